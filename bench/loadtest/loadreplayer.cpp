@@ -0,0 +1,121 @@
+#include "loadreplayer.h"
+
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+const int MEMORY_SAMPLING_INTERVAL_MS = 500;
+
+} // unnamed namespace
+
+qint64 LoadReplayer::Report::getLatencyPercentile(double fraction) const
+{
+    if ( latenciesUs.isEmpty() )
+        return -1;
+    const int index = std::min(int(fraction * latenciesUs.size()), int(latenciesUs.size()) - 1);
+    return latenciesUs[index];
+}
+
+LoadReplayer::LoadReplayer(const QUrl& baseUrl, const QStringList& paths, QObject* parent)
+    : QObject(parent),
+      m_encodedBaseUrl(baseUrl.toEncoded(QUrl::RemoveQuery | QUrl::RemoveFragment)),
+      m_paths(paths)
+{
+    m_memoryTimer.setInterval(MEMORY_SAMPLING_INTERVAL_MS);
+    connect(&m_memoryTimer, &QTimer::timeout, this, &LoadReplayer::sampleMemory);
+}
+
+qint64 LoadReplayer::getProcessMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if ( !statm.open(QIODevice::ReadOnly) )
+        return -1;
+    const auto fields = statm.readAll().split(' ');
+    if ( fields.size() < 2 )
+        return -1;
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+void LoadReplayer::sampleMemory()
+{
+    const qint64 memory = getProcessMemory();
+    m_report.memoryPeak = std::max(m_report.memoryPeak, memory);
+}
+
+void LoadReplayer::start(int concurrency, qint64 requestCount)
+{
+    m_requestCount = requestCount;
+    m_report = Report();
+    m_report.memoryAtStart = m_report.memoryPeak = getProcessMemory();
+    m_memoryTimer.start();
+    m_clock.start();
+
+    m_activeClients = concurrency;
+    for ( int i = 0; i < concurrency; ++i ) {
+        const auto client = new QNetworkAccessManager(this);
+        sendNextRequest(client);
+    }
+}
+
+void LoadReplayer::sendNextRequest(QNetworkAccessManager* client)
+{
+    if ( m_paths.isEmpty() || m_sentRequests >= m_requestCount ) {
+        client->deleteLater();
+        if ( --m_activeClients == 0 ) {
+            m_report.durationMs = m_clock.elapsed();
+            m_memoryTimer.stop();
+            m_report.memoryAtEnd = getProcessMemory();
+            sampleMemory();
+            std::sort(m_report.latenciesUs.begin(), m_report.latenciesUs.end());
+            emit(finished());
+        }
+        return;
+    }
+
+    // The paths are already encoded, as in the access logs (their query is
+    // kept as is)
+    const QString& path = m_paths[int(m_sentRequests % m_paths.size())];
+    const QUrl url = QUrl::fromEncoded(m_encodedBaseUrl + path.toUtf8(), QUrl::TolerantMode);
+    m_sentRequests++;
+
+    QNetworkRequest request(url);
+    // Don't hide the latency of the server behind the cache of the client
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    QElapsedTimer timer;
+    timer.start();
+    QNetworkReply* const reply = client->get(request);
+    connect(reply, &QNetworkReply::finished, this, [=]() {
+        onReplyFinished(client, reply, timer);
+    });
+}
+
+void LoadReplayer::onReplyFinished(QNetworkAccessManager* client, QNetworkReply* reply, const QElapsedTimer& timer)
+{
+    const QByteArray data = reply->readAll();
+    const qint64 latency = timer.nsecsElapsed() / 1000;
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+    m_report.requests++;
+    m_report.bytes += data.size();
+    m_report.latenciesUs.append(latency);
+    m_report.statusCounts[status]++;
+    if ( reply->error() != QNetworkReply::NoError ) {
+        m_report.errors++;
+    }
+    reply->deleteLater();
+    sendNextRequest(client);
+}
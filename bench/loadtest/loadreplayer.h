@@ -0,0 +1,69 @@
+#ifndef LOADREPLAYER_H
+#define LOADREPLAYER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QStringList>
+#include <QTimer>
+#include <QUrl>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+// Replays a list of percent-encoded URL paths (with their query, if any)
+// against a server with a number of concurrent
+// clients, each sending its requests one after the other (as browsers reusing
+// a keep-alive connection do). The trace is replayed from the start again
+// until the requested number of requests has been sent.
+class LoadReplayer : public QObject
+{
+    Q_OBJECT
+
+public: // types
+    struct Report
+    {
+        qint64 requests = 0;
+        qint64 errors = 0;
+        qint64 bytes = 0;
+        qint64 durationMs = 0;
+        QList<qint64> latenciesUs; // sorted
+        QMap<int, qint64> statusCounts;
+        qint64 memoryAtStart = -1; // bytes, -1 if not measurable
+        qint64 memoryAtEnd = -1;
+        qint64 memoryPeak = -1;
+
+        qint64 getLatencyPercentile(double fraction) const;
+    };
+
+public: // functions
+    LoadReplayer(const QUrl& baseUrl, const QStringList& paths, QObject* parent = nullptr);
+
+    void start(int concurrency, qint64 requestCount);
+    const Report& getReport() const { return m_report; }
+
+    // Resident memory of the current process (in bytes), -1 if it cannot be
+    // measured on this platform
+    static qint64 getProcessMemory();
+
+signals:
+    void finished();
+
+private: // functions
+    void sendNextRequest(QNetworkAccessManager* client);
+    void onReplyFinished(QNetworkAccessManager* client, QNetworkReply* reply, const QElapsedTimer& timer);
+    void sampleMemory();
+
+private: // data
+    const QByteArray  m_encodedBaseUrl;
+    const QStringList m_paths;
+    qint64            m_requestCount = 0;
+    qint64            m_sentRequests = 0;
+    int               m_activeClients = 0;
+    QElapsedTimer     m_clock;
+    QTimer            m_memoryTimer;
+    Report            m_report;
+};
+
+#endif // LOADREPLAYER_H
@@ -0,0 +1,51 @@
+#-------------------------------------------------
+#
+# Load test of the local Kiwix server (see README.md)
+#
+#-------------------------------------------------
+
+QT       += core network
+QT       -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = kiwix-desktop-loadtest
+TEMPLATE = app
+
+QMAKE_CXXFLAGS += -std=c++17
+QMAKE_LFLAGS +=  -std=c++17
+
+!win32 {
+    QMAKE_CXXFLAGS += -Werror
+}
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    main.cpp \
+    loadreplayer.cpp \
+    syntheticzim.cpp \
+    ../../src/servermetrics.cpp \
+    ../../src/servermetricsproxy.cpp
+
+HEADERS += \
+    loadreplayer.h \
+    syntheticzim.h \
+    ../../src/servermetrics.h \
+    ../../src/servermetricsproxy.h
+
+DEPS_DEFINITION = \"libkiwix >= 14.0.0 libkiwix < 15.0.0 libzim >= 9.0.0 libzim < 10.0.0\"
+
+PKGCONFIG_CFLAGS = $$system(pkg-config --cflags $$PKGCONFIG_OPTION $$DEPS_DEFINITION)
+
+QMAKE_CXXFLAGS += $$PKGCONFIG_CFLAGS
+QMAKE_CFLAGS += $$PKGCONFIG_CFLAGS
+
+!win32 {
+   LIBS += $$system(pkg-config --libs $$PKGCONFIG_OPTION $$DEPS_DEFINITION)
+}
+
+win32 {
+  LIBS += $$system(python ../../scripts/pkg-config-wrapper.py --libs $$PKGCONFIG_OPTION $$DEPS_DEFINITION)
+}
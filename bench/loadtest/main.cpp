@@ -0,0 +1,261 @@
+#include "loadreplayer.h"
+#include "servermetricsproxy.h"
+#include "syntheticzim.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QRegularExpression>
+#include <QTcpServer>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <kiwix/library.h>
+#include <kiwix/manager.h>
+#include <kiwix/name_mapper.h>
+#include <kiwix/server.h>
+#include <zim/archive.h>
+#include <zim/error.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+
+namespace
+{
+
+const int RESOURCES_PER_ARTICLE = 4;
+
+// Number of random entries requested per book when no trace is given
+const int ENTRIES_PER_BOOK = 1000;
+
+const qint64 MiB = 1024 * 1024;
+
+// A run where more requests than that fail with 404 replays a trace that
+// doesn't match the books served
+const double MAX_NOT_FOUND_FRACTION = 0.5;
+
+quint16 findFreeLoopbackPort()
+{
+    QTcpServer server;
+    if ( !server.listen(QHostAddress::LocalHost, 0) )
+        return 0;
+    return server.serverPort();
+}
+
+// Path of an entry of a book, percent-encoded as in the access logs
+QString getContentPath(const QString& bookName, const QString& entryPath)
+{
+    return "/content/" + bookName + "/" + QString::fromLatin1(QUrl::toPercentEncoding(entryPath, "/"));
+}
+
+// Reads the paths of an access log (common/combined log format, only the GET
+// and HEAD requests are kept) or of a file with one path per line. The paths
+// are percent-encoded and may have a query.
+QStringList readTrace(const QString& fileName)
+{
+    QFile file(fileName);
+    if ( !file.open(QIODevice::ReadOnly | QIODevice::Text) ) {
+        std::cerr << "Cannot read " << fileName.toStdString() << std::endl;
+        return QStringList();
+    }
+
+    static const QRegularExpression requestLine("\"(?:GET|HEAD) (\\S+) HTTP/[0-9.]+\"");
+    QStringList paths;
+    QTextStream stream(&file);
+    while ( !stream.atEnd() ) {
+        const QString line = stream.readLine().trimmed();
+        const auto match = requestLine.match(line);
+        if ( match.hasMatch() ) {
+            paths.append(match.captured(1));
+        } else if ( line.startsWith('/') ) {
+            paths.append(line);
+        }
+    }
+    return paths;
+}
+
+// Browsing of the synthetic book: an article followed by its resources
+QStringList makeSyntheticTrace(const QString& bookName, const QStringList& entryPaths, int articleCount)
+{
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> articleIndex(0, articleCount - 1);
+    std::uniform_int_distribution<int> resourceIndex(articleCount, entryPaths.size() - 1);
+
+    QStringList paths;
+    for ( int i = 0; i < articleCount; ++i ) {
+        paths.append(getContentPath(bookName, entryPaths[articleIndex(random)]));
+        for ( int r = 0; r < RESOURCES_PER_ARTICLE && articleCount < entryPaths.size(); ++r ) {
+            paths.append(getContentPath(bookName, entryPaths[resourceIndex(random)]));
+        }
+    }
+    return paths;
+}
+
+QStringList makeRandomTrace(const kiwix::Library& library, const kiwix::NameMapper& nameMapper,
+                            const std::string& bookId)
+{
+    QStringList paths;
+    const auto archive = library.getArchiveById(bookId);
+    if ( !archive )
+        return paths;
+
+    const QString bookName = QString::fromStdString(nameMapper.getNameForId(bookId));
+    for ( int i = 0; i < ENTRIES_PER_BOOK; ++i ) {
+        try {
+            paths.append(getContentPath(bookName, QString::fromStdString(archive->getRandomEntry().getPath())));
+        } catch (const zim::EntryNotFound&) {
+            break;
+        }
+    }
+    return paths;
+}
+
+QString formatMemory(qint64 bytes)
+{
+    return bytes < 0 ? QString("n/a") : QString("%1 MiB").arg(double(bytes) / MiB, 0, 'f', 1);
+}
+
+void printReport(const LoadReplayer::Report& report, bool localServer)
+{
+    QTextStream out(stdout);
+    const double seconds = std::max<qint64>(report.durationMs, 1) / 1000.0;
+    out << "Requests:     " << report.requests << " (" << report.errors << " errors)\n";
+    for ( auto it = report.statusCounts.begin(); it != report.statusCounts.end(); ++it ) {
+        out << "  HTTP " << it.key() << ": " << it.value() << "\n";
+    }
+    out << "Duration:     " << QString::number(seconds, 'f', 2) << " s\n";
+    out << "Throughput:   " << QString::number(report.requests / seconds, 'f', 1) << " req/s, "
+        << QString::number(report.bytes / seconds / MiB, 'f', 2) << " MiB/s\n";
+    out << "Latency (ms): p50 " << QString::number(report.getLatencyPercentile(0.50) / 1000.0, 'f', 2)
+        << ", p90 " << QString::number(report.getLatencyPercentile(0.90) / 1000.0, 'f', 2)
+        << ", p99 " << QString::number(report.getLatencyPercentile(0.99) / 1000.0, 'f', 2)
+        << ", max " << QString::number(report.getLatencyPercentile(1.0) / 1000.0, 'f', 2) << "\n";
+    out << "Memory:       " << formatMemory(report.memoryAtStart) << " at start, "
+        << formatMemory(report.memoryPeak) << " peak, "
+        << formatMemory(report.memoryAtEnd) << " at end";
+    if ( !localServer ) {
+        out << " (load test client only)";
+    }
+    out << "\n";
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a request trace against the local Kiwix server.");
+    parser.addHelpOption();
+    const QCommandLineOption zimOption("zim", "ZIM file to serve (can be repeated).", "path");
+    const QCommandLineOption syntheticOption("synthetic", "Serve a generated book of <count> articles.", "count");
+    const QCommandLineOption articleSizeOption("article-size", "Size of the generated articles in bytes.", "bytes", "20000");
+    const QCommandLineOption traceOption("trace", "Access log or list of paths to replay.", "file");
+    const QCommandLineOption requestsOption("requests", "Number of requests to send.", "count", "10000");
+    const QCommandLineOption concurrencyOption("concurrency", "Number of concurrent clients.", "count", "8");
+    const QCommandLineOption threadsOption("threads", "Number of server threads (0 for the default).", "count", "0");
+    const QCommandLineOption urlOption("url", "Test an already running server instead.", "url");
+    const QCommandLineOption proxyOption("proxy", "Go through the proxy measuring the load, as kiwix-desktop does.");
+    parser.addOptions({zimOption, syntheticOption, articleSizeOption, traceOption, requestsOption,
+                       concurrencyOption, threadsOption, urlOption, proxyOption});
+    parser.process(app);
+
+    const auto library = kiwix::Library::create();
+    kiwix::Manager manager(library);
+    std::vector<std::string> bookIds;
+    for ( const auto& path : parser.values(zimOption) ) {
+        const auto id = manager.addBookFromPathAndGetId(path.toStdString());
+        if ( id.empty() ) {
+            std::cerr << "Invalid ZIM file " << path.toStdString() << std::endl;
+            return 1;
+        }
+        bookIds.push_back(id);
+    }
+
+    QTemporaryDir tempDir;
+    QStringList syntheticPaths;
+    std::string syntheticId;
+    const int articleCount = parser.value(syntheticOption).toInt();
+    if ( articleCount > 0 ) {
+        const QString path = tempDir.filePath("synthetic.zim");
+        std::cout << "Creating a book of " << articleCount << " articles..." << std::endl;
+        syntheticPaths = createSyntheticZim(path, articleCount, parser.value(articleSizeOption).toInt(),
+                                            RESOURCES_PER_ARTICLE);
+        syntheticId = manager.addBookFromPathAndGetId(path.toStdString());
+    }
+    const auto nameMapper = std::make_shared<kiwix::UpdatableNameMapper>(library, false);
+
+    QStringList trace;
+    if ( parser.isSet(traceOption) ) {
+        trace = readTrace(parser.value(traceOption));
+    } else {
+        if ( !syntheticId.empty() ) {
+            trace += makeSyntheticTrace(QString::fromStdString(nameMapper->getNameForId(syntheticId)),
+                                        syntheticPaths, articleCount);
+        }
+        for ( const auto& id : bookIds ) {
+            trace += makeRandomTrace(*library, *nameMapper, id);
+        }
+    }
+    if ( trace.isEmpty() ) {
+        std::cerr << "Nothing to replay, give a --trace, a --zim or --synthetic" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<kiwix::Server> server;
+    std::unique_ptr<ServerMetricsProxy> proxy;
+    QUrl baseUrl(parser.value(urlOption));
+    if ( !parser.isSet(urlOption) ) {
+        quint16 port = findFreeLoopbackPort();
+        server.reset(new kiwix::Server(library, nameMapper));
+        server->setAddress("127.0.0.1");
+        server->setPort(port);
+        if ( const int threads = parser.value(threadsOption).toInt() ) {
+            server->setNbThreads(threads);
+        }
+        if ( !server->start() ) {
+            std::cerr << "Cannot start the server" << std::endl;
+            return 1;
+        }
+        if ( parser.isSet(proxyOption) ) {
+            const quint16 backendPort = port;
+            port = findFreeLoopbackPort();
+            proxy.reset(new ServerMetricsProxy);
+            if ( !proxy->start(QHostAddress::LocalHost, port, backendPort, 0) ) {
+                std::cerr << "Cannot start the proxy" << std::endl;
+                return 1;
+            }
+        }
+        baseUrl = QUrl(QString("http://127.0.0.1:%1").arg(port));
+    }
+    if ( baseUrl.path().endsWith('/') ) {
+        baseUrl.setPath(baseUrl.path().chopped(1));
+    }
+
+    std::cout << "Replaying " << trace.size() << " paths against " << baseUrl.toString().toStdString()
+              << std::endl;
+    LoadReplayer replayer(baseUrl, trace);
+    QObject::connect(&replayer, &LoadReplayer::finished, &app, &QCoreApplication::quit);
+    replayer.start(std::max(1, parser.value(concurrencyOption).toInt()),
+                   parser.value(requestsOption).toLongLong());
+    app.exec();
+
+    if ( proxy ) {
+        std::cout << "Requests measured by the proxy: " << proxy->getMetrics().getRequestCount() << std::endl;
+        proxy->stop();
+    }
+    if ( server ) {
+        server->stop();
+    }
+    const auto& report = replayer.getReport();
+    printReport(report, bool(server));
+    if ( report.statusCounts.value(404) > report.requests * MAX_NOT_FOUND_FRACTION ) {
+        std::cerr << "Most requests were not found (HTTP 404): the trace doesn't match the books served"
+                  << " (the paths must be /content/<book name>/...)" << std::endl;
+        return 3;
+    }
+    return report.errors == 0 ? 0 : 2;
+}
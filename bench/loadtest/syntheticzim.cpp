@@ -0,0 +1,103 @@
+#include "syntheticzim.h"
+
+#include <zim/writer/creator.h>
+#include <zim/writer/item.h>
+
+#include <random>
+#include <string>
+
+namespace
+{
+
+const int RESOURCE_COUNT = 200;
+const int RESOURCE_SIZE = 16 * 1024;
+
+const char* const WORDS[] = {
+    "library", "offline", "article", "knowledge", "school", "river", "history",
+    "science", "mountain", "language", "music", "planet", "energy", "city",
+    "animal", "computer", "ocean", "forest", "culture", "medicine"
+};
+
+std::string makeText(std::mt19937& random, int size)
+{
+    std::uniform_int_distribution<int> wordIndex(0, int(sizeof(WORDS) / sizeof(WORDS[0])) - 1);
+    std::string text;
+    text.reserve(size + 16);
+    while ( int(text.size()) < size ) {
+        text += WORDS[wordIndex(random)];
+        text += (text.size() % 97 < 8) ? ". " : " ";
+    }
+    return text;
+}
+
+std::string makeBinary(std::mt19937& random, int size)
+{
+    std::string data(size, '\0');
+    for ( auto& c : data ) {
+        c = char(random() & 0xff);
+    }
+    return data;
+}
+
+QString getArticlePath(int index)
+{
+    return QString("A/article_%1").arg(index);
+}
+
+QString getResourcePath(int index)
+{
+    return QString("I/resource_%1.bin").arg(index);
+}
+
+} // unnamed namespace
+
+QStringList createSyntheticZim(const QString& path, int articleCount, int articleSize,
+                               int resourcesPerArticle)
+{
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> resourceIndex(0, RESOURCE_COUNT - 1);
+
+    zim::writer::Creator creator;
+    creator.configIndexing(false, "eng");
+    creator.startZimCreation(path.toStdString());
+
+    const zim::writer::Hints articleHints{{zim::writer::HintKeys::FRONT_ARTICLE, 1}};
+    QStringList articlePaths;
+    for ( int i = 0; i < articleCount; ++i ) {
+        std::string html = "<html><head><title>Article " + std::to_string(i) + "</title></head><body>";
+        for ( int r = 0; r < resourcesPerArticle; ++r ) {
+            html += "<img src=\"../" + getResourcePath(resourceIndex(random)).toStdString() + "\">";
+        }
+        html += "<p>" + makeText(random, articleSize) + "</p></body></html>";
+
+        const QString articlePath = getArticlePath(i);
+        creator.addItem(zim::writer::StringItem::create(articlePath.toStdString(), "text/html",
+                                                        "Article " + std::to_string(i),
+                                                        articleHints,
+                                                        html));
+        articlePaths.append(articlePath);
+    }
+
+    const zim::writer::Hints resourceHints{{zim::writer::HintKeys::COMPRESS, 0}};
+    QStringList resourcePaths;
+    for ( int i = 0; i < RESOURCE_COUNT; ++i ) {
+        const QString resourcePath = getResourcePath(i);
+        creator.addItem(zim::writer::StringItem::create(resourcePath.toStdString(),
+                                                        "application/octet-stream", "",
+                                                        resourceHints,
+                                                        makeBinary(random, RESOURCE_SIZE)));
+        resourcePaths.append(resourcePath);
+    }
+
+    creator.setMainPath(getArticlePath(0).toStdString());
+    creator.addMetadata("Name", "kiwix-desktop_loadtest");
+    creator.addMetadata("Title", "Load test");
+    creator.addMetadata("Description", "Synthetic book for load tests");
+    creator.addMetadata("Language", "eng");
+    creator.addMetadata("Creator", "kiwix-desktop");
+    creator.addMetadata("Publisher", "kiwix-desktop");
+    creator.addMetadata("Date", "2024-01-01");
+    creator.finishZimCreation();
+
+    return articlePaths + resourcePaths;
+}
@@ -0,0 +1,16 @@
+#ifndef SYNTHETICZIM_H
+#define SYNTHETICZIM_H
+
+#include <QString>
+#include <QStringList>
+
+// Creates a ZIM file of `articleCount` HTML articles of about `articleSize`
+// bytes, each referencing `resourcesPerArticle` binary resources (shared
+// between the articles, as the images of a real book). The content is
+// generated from a fixed seed, so that runs can be compared.
+//
+// Returns the paths of the entries, articles first.
+QStringList createSyntheticZim(const QString& path, int articleCount, int articleSize,
+                               int resourcesPerArticle);
+
+#endif // SYNTHETICZIM_H
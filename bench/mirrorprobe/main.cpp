@@ -0,0 +1,102 @@
+#include "mirrorprober.h"
+#include "standinmirror.h"
+
+#include <QCoreApplication>
+#include <QNetworkAccessManager>
+#include <QTextStream>
+
+#include <iostream>
+
+namespace
+{
+
+// A fast near mirror, a fast far one, a slow near one, a failing one and
+// one that never answers
+const char* const DEFAULT_PROFILES[] = {
+    "20:4000", "300:4000", "20:200", "30:2000:error", "10:8000:stall"
+};
+
+// Measured scores closer than that to each other may be ranked either way
+const double SCORE_TOLERANCE = 1.5;
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QStringList profileTexts = app.arguments().mid(1);
+    if ( profileTexts.isEmpty() ) {
+        for ( const auto profile : DEFAULT_PROFILES ) {
+            profileTexts.append(profile);
+        }
+    }
+
+    QList<StandInMirror*> standIns;
+    QList<Metalink::Mirror> mirrors;
+    for ( const auto& text : profileTexts ) {
+        StandInMirror::Profile profile;
+        if ( !StandInMirror::Profile::parse(text, profile) ) {
+            std::cerr << "Invalid mirror profile " << text.toStdString()
+                      << ", expected <latency ms>:<KiB/s>[:error|:stall]" << std::endl;
+            return 2;
+        }
+        const auto standIn = new StandInMirror(profile, &app);
+        if ( !standIn->start() ) {
+            std::cerr << "Cannot start a stand-in mirror" << std::endl;
+            return 2;
+        }
+        standIns.append(standIn);
+
+        Metalink::Mirror mirror;
+        mirror.url = standIn->getUrl();
+        mirror.location = QString::number(mirrors.size());
+        mirror.priority = mirrors.size();
+        mirrors.append(mirror);
+        out << "Mirror " << mirror.location << ": " << text << " at " << mirror.url.toString() << "\n";
+    }
+    out.flush();
+
+    QNetworkAccessManager networkManager;
+    MirrorProber prober(&networkManager);
+    MirrorProber::Ranking ranking;
+    QObject::connect(&prober, &MirrorProber::finished, &app, [&](MirrorProber::Ranking result) {
+        ranking = result;
+        app.quit();
+    });
+    prober.probe(mirrors);
+    app.exec();
+
+    // Every mirror answering properly must be ranked, in the order of its
+    // expected score
+    bool ok = true;
+    QList<const StandInMirror::Profile*> rankedProfiles;
+    for ( const auto& result : ranking ) {
+        const auto& profile = standIns[result.mirror.location.toInt()]->getProfile();
+        out << "Ranked mirror " << result.mirror.location << ": score " << result.score()
+            << " s (expected " << profile.expectedScore() << " s)\n";
+        if ( profile.behaviour != StandInMirror::Behaviour::Normal ) {
+            out << "  ERROR: a failing mirror is ranked\n";
+            ok = false;
+        }
+        rankedProfiles.append(&profile);
+    }
+    for ( const auto standIn : standIns ) {
+        if ( standIn->getProfile().behaviour == StandInMirror::Behaviour::Normal
+          && !rankedProfiles.contains(&standIn->getProfile()) ) {
+            out << "ERROR: mirror " << standIn->getUrl().toString() << " is not ranked\n";
+            ok = false;
+        }
+    }
+    for ( int i = 0; i + 1 < rankedProfiles.size(); ++i ) {
+        const double score = rankedProfiles[i]->expectedScore();
+        const double nextScore = rankedProfiles[i + 1]->expectedScore();
+        if ( score > nextScore * SCORE_TOLERANCE ) {
+            out << "ERROR: mirrors ranked " << i << " and " << i + 1 << " are in the wrong order\n";
+            ok = false;
+        }
+    }
+    out << (ok ? "OK" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+#-------------------------------------------------
+#
+# Check of the mirror probing against local stand-ins (see README.md)
+#
+#-------------------------------------------------
+
+QT       += core network
+QT       -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = kiwix-desktop-mirrorprobe
+TEMPLATE = app
+
+QMAKE_CXXFLAGS += -std=c++17
+QMAKE_LFLAGS +=  -std=c++17
+
+!win32 {
+    QMAKE_CXXFLAGS += -Werror
+}
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    main.cpp \
+    standinmirror.cpp \
+    ../../src/metalink.cpp \
+    ../../src/mirrorprober.cpp
+
+HEADERS += \
+    standinmirror.h \
+    ../../src/metalink.h \
+    ../../src/mirrorprober.h
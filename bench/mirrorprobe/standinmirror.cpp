@@ -0,0 +1,138 @@
+#include "standinmirror.h"
+
+#include <QStringList>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace
+{
+
+const qint64 FILE_SIZE = 64 * 1024 * 1024;
+
+// The body is sent in chunks at that interval to obtain the throughput
+const int CHUNK_INTERVAL_MS = 20;
+
+// Same as in mirrorprober.cpp
+const double SEGMENT_SIZE = 1024 * 1024;
+
+} // unnamed namespace
+
+bool StandInMirror::Profile::parse(const QString& text, Profile& profile)
+{
+    const QStringList fields = text.split(':');
+    if ( fields.size() < 2 || fields.size() > 3 )
+        return false;
+
+    bool latencyOk = false, throughputOk = false;
+    profile.latencyMs = fields[0].toInt(&latencyOk);
+    profile.bytesPerSecond = fields[1].toLongLong(&throughputOk) * 1024;
+    if ( !latencyOk || !throughputOk || profile.bytesPerSecond <= 0 )
+        return false;
+
+    if ( fields.size() == 3 ) {
+        if ( fields[2] == "error" ) {
+            profile.behaviour = Behaviour::Error;
+        } else if ( fields[2] == "stall" ) {
+            profile.behaviour = Behaviour::Stall;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+double StandInMirror::Profile::expectedScore() const
+{
+    return latencyMs / 1000.0 + SEGMENT_SIZE / bytesPerSecond;
+}
+
+StandInMirror::StandInMirror(const Profile& profile, QObject* parent)
+    : QObject(parent),
+      m_profile(profile)
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &StandInMirror::acceptConnections);
+}
+
+bool StandInMirror::start()
+{
+    return m_server.listen(QHostAddress::LocalHost, 0);
+}
+
+QUrl StandInMirror::getUrl() const
+{
+    return QUrl(QString("http://127.0.0.1:%1/book.zim").arg(m_server.serverPort()));
+}
+
+void StandInMirror::acceptConnections()
+{
+    while ( QTcpSocket* socket = m_server.nextPendingConnection() ) {
+        connect(socket, &QTcpSocket::readyRead, this, [=]() { readRequest(socket); });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void StandInMirror::readRequest(QTcpSocket* socket)
+{
+    QByteArray buffer = socket->property("request").toByteArray() + socket->readAll();
+    int headersEnd;
+    while ( (headersEnd = buffer.indexOf("\r\n\r\n")) >= 0 ) {
+        const QList<QByteArray> lines = buffer.left(headersEnd).split('\n');
+        buffer.remove(0, headersEnd + 4);
+
+        const QByteArray method = lines[0].split(' ')[0];
+        QByteArray range;
+        for ( const auto& line : lines ) {
+            if ( line.toLower().startsWith("range:") ) {
+                range = line.mid(6).trimmed();
+            }
+        }
+        if ( m_profile.behaviour != Behaviour::Stall ) {
+            QTimer::singleShot(m_profile.latencyMs, socket, [=]() { reply(socket, method, range); });
+        }
+    }
+    socket->setProperty("request", buffer);
+}
+
+void StandInMirror::reply(QTcpSocket* socket, const QByteArray& method, const QByteArray& range)
+{
+    if ( m_profile.behaviour == Behaviour::Error ) {
+        socket->write("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n");
+        return;
+    }
+
+    qint64 first = 0, last = FILE_SIZE - 1;
+    QByteArray status = "200 OK";
+    if ( range.startsWith("bytes=") ) {
+        const QList<QByteArray> bounds = range.mid(6).split('-');
+        first = bounds[0].toLongLong();
+        if ( bounds.size() > 1 && !bounds[1].isEmpty() ) {
+            last = std::min(last, bounds[1].toLongLong());
+        }
+        status = "206 Partial Content";
+    }
+    const qint64 length = last - first + 1;
+
+    QByteArray headers = "HTTP/1.1 " + status + "\r\n"
+                         "Accept-Ranges: bytes\r\n"
+                         "Content-Length: " + QByteArray::number(length) + "\r\n";
+    if ( status.startsWith("206") ) {
+        headers += "Content-Range: bytes " + QByteArray::number(first) + "-" + QByteArray::number(last)
+                 + "/" + QByteArray::number(FILE_SIZE) + "\r\n";
+    }
+    socket->write(headers + "\r\n");
+    if ( method != "HEAD" ) {
+        sendBody(socket, length);
+    }
+}
+
+void StandInMirror::sendBody(QTcpSocket* socket, qint64 remaining)
+{
+    const qint64 chunkSize = std::max(qint64(1), m_profile.bytesPerSecond * CHUNK_INTERVAL_MS / 1000);
+    const qint64 size = std::min(remaining, chunkSize);
+    socket->write(QByteArray(size, 'z'));
+    if ( remaining > size ) {
+        QTimer::singleShot(CHUNK_INTERVAL_MS, socket, [=]() { sendBody(socket, remaining - size); });
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef STANDINMIRROR_H
+#define STANDINMIRROR_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QUrl>
+
+class QTcpSocket;
+
+// Minimal HTTP server on the loopback interface standing in for a download
+// mirror. It answers HEAD and ranged GET requests for a file of arbitrary
+// content after a given latency and at a given throughput, or fails them.
+class StandInMirror : public QObject
+{
+    Q_OBJECT
+
+public: // types
+    enum class Behaviour { Normal, Error, Stall };
+
+    struct Profile
+    {
+        int       latencyMs = 0;
+        qint64    bytesPerSecond = 0;
+        Behaviour behaviour = Behaviour::Normal;
+
+        // "<latency ms>:<KiB/s>", optionally followed by ":error" or ":stall"
+        static bool parse(const QString& text, Profile& profile);
+
+        // Expected score of MirrorProber::Result (lower is better)
+        double expectedScore() const;
+    };
+
+public: // functions
+    StandInMirror(const Profile& profile, QObject* parent = nullptr);
+
+    bool start();
+    QUrl getUrl() const;
+    const Profile& getProfile() const { return m_profile; }
+
+private: // functions
+    void acceptConnections();
+    void readRequest(QTcpSocket* socket);
+    void reply(QTcpSocket* socket, const QByteArray& method, const QByteArray& range);
+    void sendBody(QTcpSocket* socket, qint64 remaining);
+
+private: // data
+    const Profile m_profile;
+    QTcpServer    m_server;
+};
+
+#endif // STANDINMIRROR_H
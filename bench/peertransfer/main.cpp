@@ -0,0 +1,130 @@
+#include "peertransfer.h"
+#include "standinpeer.h"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <iostream>
+
+namespace
+{
+
+const qint64 PIECE_LENGTH = 1024 * 1024;
+
+struct PeerSpec
+{
+    StandInPeer::Failure failure;
+    int failureCount;
+
+    // Number of requests that the peer should receive (-1 if not checked)
+    int expectedRequests;
+};
+
+struct Scenario
+{
+    const char* name;
+    QList<PeerSpec> peers;
+    bool expectedSuccess;
+};
+
+const QList<Scenario> SCENARIOS = {
+    { "the only peer fails twice",
+      { { StandInPeer::Failure::Error, 2, -1 } }, true },
+    { "the only peer drops the connection once",
+      { { StandInPeer::Failure::Cut, 1, -1 } }, true },
+    { "a peer sends bad data, the other one is fine",
+      { { StandInPeer::Failure::Corrupt, -1, 1 },
+        { StandInPeer::Failure::Error, 0, -1 } }, true },
+    { "the only peer is gone (takes about 15 s)",
+      { { StandInPeer::Failure::Error, -1, 5 } }, false },
+};
+
+Metalink makeMetalink()
+{
+    Metalink metalink;
+    metalink.fileName = "test.zim";
+    metalink.size = StandInPeer::getFileSize();
+    metalink.pieceHashType = "sha-256";
+    metalink.pieceLength = PIECE_LENGTH;
+    for ( qint64 pos = 0; pos < metalink.size; pos += PIECE_LENGTH ) {
+        const QByteArray piece = StandInPeer::getFileData(pos, std::min(PIECE_LENGTH, metalink.size - pos));
+        metalink.pieceHashes.append(QCryptographicHash::hash(piece, QCryptographicHash::Sha256).toHex());
+    }
+    return metalink;
+}
+
+bool run(const Scenario& scenario, const Metalink& metalink, QNetworkAccessManager* nam,
+         QTextStream& out)
+{
+    out << scenario.name << "\n";
+    out.flush();
+
+    QTemporaryDir dir;
+    QList<StandInPeer*> peers;
+    QList<QUrl> sources;
+    for ( const auto& spec : scenario.peers ) {
+        const auto peer = new StandInPeer(spec.failure, spec.failureCount);
+        if ( !peer->start() ) {
+            std::cerr << "Cannot start a stand-in peer" << std::endl;
+            return false;
+        }
+        peers.append(peer);
+        sources.append(peer->getUrl());
+    }
+
+    const QString path = dir.filePath(metalink.fileName);
+    PeerTransfer transfer(nam, metalink, sources, path, 0);
+    QEventLoop loop;
+    bool success = false;
+    QObject::connect(&transfer, &PeerTransfer::finished, &loop, [&](bool result) {
+        success = result;
+        loop.quit();
+    });
+    transfer.start();
+    loop.exec();
+
+    bool ok = true;
+    if ( success != scenario.expectedSuccess ) {
+        out << "  ERROR: the transfer " << (success ? "succeeded" : "failed") << "\n";
+        ok = false;
+    }
+    if ( success ) {
+        QFile file(path);
+        if ( !file.open(QIODevice::ReadOnly)
+          || file.readAll() != StandInPeer::getFileData(0, metalink.size) ) {
+            out << "  ERROR: the file transferred is not the expected one\n";
+            ok = false;
+        }
+    }
+    for ( int i = 0; i < peers.size(); ++i ) {
+        const int expected = scenario.peers[i].expectedRequests;
+        out << "  peer " << i << ": " << peers[i]->getRequestCount() << " requests\n";
+        if ( expected >= 0 && peers[i]->getRequestCount() != expected ) {
+            out << "  ERROR: " << expected << " requests expected\n";
+            ok = false;
+        }
+    }
+    qDeleteAll(peers);
+    return ok;
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const Metalink metalink = makeMetalink();
+    QNetworkAccessManager networkManager;
+    bool ok = true;
+    for ( const auto& scenario : SCENARIOS ) {
+        ok = run(scenario, metalink, &networkManager, out) && ok;
+    }
+    out << (ok ? "OK" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+#-------------------------------------------------
+#
+# Check of the transfers from peers against local stand-ins (see README.md)
+#
+#-------------------------------------------------
+
+QT       += core network
+QT       -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = kiwix-desktop-peertransfer
+TEMPLATE = app
+
+QMAKE_CXXFLAGS += -std=c++17
+QMAKE_LFLAGS +=  -std=c++17
+
+!win32 {
+    QMAKE_CXXFLAGS += -Werror
+}
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    main.cpp \
+    standinpeer.cpp \
+    ../../src/metalink.cpp \
+    ../../src/peertransfer.cpp
+
+HEADERS += \
+    standinpeer.h \
+    ../../src/metalink.h \
+    ../../src/peertransfer.h
@@ -0,0 +1,111 @@
+#include "standinpeer.h"
+
+#include <QTcpSocket>
+
+#include <algorithm>
+
+namespace
+{
+
+// Not a multiple of the piece length, so that the last piece is shorter
+const qint64 FILE_SIZE = 20 * 1024 * 1024 + 12345;
+
+} // unnamed namespace
+
+StandInPeer::StandInPeer(Failure failure, int failureCount, QObject* parent)
+    : QObject(parent),
+      m_failure(failure),
+      m_failureCount(failureCount)
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &StandInPeer::acceptConnections);
+}
+
+bool StandInPeer::start()
+{
+    return m_server.listen(QHostAddress::LocalHost, 0);
+}
+
+QUrl StandInPeer::getUrl() const
+{
+    return QUrl(QString("http://127.0.0.1:%1/peer/v1/books/test").arg(m_server.serverPort()));
+}
+
+QByteArray StandInPeer::getFileData(qint64 first, qint64 length)
+{
+    QByteArray data(int(length), 0);
+    for ( qint64 i = 0; i < length; ++i ) {
+        const quint64 pos = quint64(first + i);
+        data[int(i)] = char((pos * 2654435761u) >> 13);
+    }
+    return data;
+}
+
+qint64 StandInPeer::getFileSize()
+{
+    return FILE_SIZE;
+}
+
+void StandInPeer::acceptConnections()
+{
+    while ( QTcpSocket* socket = m_server.nextPendingConnection() ) {
+        connect(socket, &QTcpSocket::readyRead, this, [=]() { readRequest(socket); });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void StandInPeer::readRequest(QTcpSocket* socket)
+{
+    QByteArray buffer = socket->property("request").toByteArray() + socket->readAll();
+    int headersEnd;
+    while ( (headersEnd = buffer.indexOf("\r\n\r\n")) >= 0 ) {
+        const QList<QByteArray> lines = buffer.left(headersEnd).split('\n');
+        buffer.remove(0, headersEnd + 4);
+
+        QByteArray range;
+        for ( const auto& line : lines ) {
+            if ( line.toLower().startsWith("range:") ) {
+                range = line.mid(6).trimmed();
+            }
+        }
+        reply(socket, range);
+    }
+    socket->setProperty("request", buffer);
+}
+
+void StandInPeer::reply(QTcpSocket* socket, const QByteArray& range)
+{
+    ++m_requestCount;
+    const bool fail = m_failureCount < 0 || m_requestCount <= m_failureCount;
+    if ( fail && m_failure == Failure::Error ) {
+        socket->write("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n");
+        return;
+    }
+
+    qint64 first = 0, last = FILE_SIZE - 1;
+    if ( range.startsWith("bytes=") ) {
+        const QList<QByteArray> bounds = range.mid(6).split('-');
+        first = bounds[0].toLongLong();
+        if ( bounds.size() > 1 && !bounds[1].isEmpty() ) {
+            last = std::min(last, bounds[1].toLongLong());
+        }
+    }
+    const qint64 length = last - first + 1;
+
+    socket->write("HTTP/1.1 206 Partial Content\r\n"
+                  "Accept-Ranges: bytes\r\n"
+                  "Content-Length: " + QByteArray::number(length) + "\r\n"
+                  "Content-Range: bytes " + QByteArray::number(first) + "-" + QByteArray::number(last)
+                  + "/" + QByteArray::number(FILE_SIZE) + "\r\n\r\n");
+
+    QByteArray body = getFileData(first, length);
+    if ( fail && m_failure == Failure::Cut ) {
+        socket->write(body.left(body.size() / 2));
+        socket->flush();
+        socket->abort();
+        return;
+    }
+    if ( fail && m_failure == Failure::Corrupt ) {
+        body[body.size() / 2] = char(~body[body.size() / 2]);
+    }
+    socket->write(body);
+}
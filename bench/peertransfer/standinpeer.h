@@ -0,0 +1,50 @@
+#ifndef STANDINPEER_H
+#define STANDINPEER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QUrl>
+
+class QTcpSocket;
+
+// Minimal HTTP server on the loopback interface standing in for the file
+// server of another kiwix-desktop instance (see PeerShare). It answers ranged
+// GET requests for a file of generated content, and can be told to fail a
+// number of them first.
+class StandInPeer : public QObject
+{
+    Q_OBJECT
+
+public: // types
+    enum class Failure
+    {
+        Error,   // answers 503
+        Cut,     // closes the connection in the middle of the body
+        Corrupt  // sends the body with a wrong byte
+    };
+
+public: // functions
+    // The first failureCount requests fail (all of them if negative)
+    StandInPeer(Failure failure, int failureCount, QObject* parent = nullptr);
+
+    bool start();
+    QUrl getUrl() const;
+    int getRequestCount() const { return m_requestCount; }
+
+    // Content of the file served
+    static QByteArray getFileData(qint64 first, qint64 length);
+    static qint64 getFileSize();
+
+private: // functions
+    void acceptConnections();
+    void readRequest(QTcpSocket* socket);
+    void reply(QTcpSocket* socket, const QByteArray& range);
+
+private: // data
+    const Failure m_failure;
+    const int     m_failureCount;
+    int           m_requestCount = 0;
+    QTcpServer    m_server;
+};
+
+#endif // STANDINPEER_H
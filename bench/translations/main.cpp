@@ -0,0 +1,96 @@
+#include "translation.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QStringList>
+#include <QTextStream>
+
+namespace
+{
+
+const int LOAD_ROUNDS = 100;
+const int LOOKUP_ROUNDS = 200;
+
+// What Translation::setTranslation() did before the tables: parsing the
+// JSON files of English and of the language, and merging them in a QMap
+QMap<QString, QString> readJson(const QString& path)
+{
+    QMap<QString, QString> translations;
+    QFile file(path);
+    if ( !file.open(QIODevice::ReadOnly) )
+        return translations;
+    const auto jsonObj = QJsonDocument::fromJson(file.readAll()).object();
+    for ( const auto& key : jsonObj.keys() ) {
+        translations.insert(key, jsonObj.value(key).toString());
+    }
+    return translations;
+}
+
+QMap<QString, QString> loadJsonTranslations(const QString& language)
+{
+    const auto defaultText = readJson(I18N_DIR "/en.json");
+    auto translations = readJson(QString(I18N_DIR "/%1.json").arg(language));
+    for ( const auto& key : defaultText.keys() ) {
+        if ( !translations.contains(key) || translations.value(key).isEmpty() ) {
+            translations.insert(key, defaultText.value(key));
+        }
+    }
+    return translations;
+}
+
+template<class F>
+double measureNs(int rounds, F f)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for ( int i = 0; i < rounds; ++i ) {
+        f();
+    }
+    return double(timer.nsecsElapsed()) / rounds;
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QString language = argc > 1 ? argv[1] : "fr";
+    QTextStream out(stdout);
+
+    QMap<QString, QString> jsonTranslations;
+    const double jsonLoad = measureNs(LOAD_ROUNDS, [&]() {
+        jsonTranslations = loadJsonTranslations(language);
+    });
+    Translation translation;
+    const double tableLoad = measureNs(LOAD_ROUNDS, [&]() {
+        translation.setTranslation(QLocale(language));
+    });
+    out << "Loading " << language << ": JSON + QMap " << jsonLoad / 1000 << " us, tables "
+        << tableLoad / 1000 << " us\n";
+
+    const QStringList keys = jsonTranslations.keys();
+    const int count = int(TranslationKey::Count);
+    qint64 total = 0;
+    const double mapLookup = measureNs(LOOKUP_ROUNDS, [&]() {
+        for ( const auto& key : keys ) {
+            total += jsonTranslations.value(key).size();
+        }
+    }) / keys.size();
+    const double hashLookup = measureNs(LOOKUP_ROUNDS, [&]() {
+        for ( const auto& key : keys ) {
+            total += translation.getText(key).size();
+        }
+    }) / keys.size();
+    const double keyLookup = measureNs(LOOKUP_ROUNDS, [&]() {
+        for ( int i = 0; i < count; ++i ) {
+            total += translation.getText(TranslationKey(i)).size();
+        }
+    }) / count;
+    out << "Lookup of " << keys.size() << " keys: QMap " << mapLookup << " ns, perfect hash "
+        << hashLookup << " ns, TranslationKey " << keyLookup << " ns (" << total << ")\n";
+    return 0;
+}
@@ -0,0 +1,42 @@
+#-------------------------------------------------
+#
+# Benchmark of the translation tables (see README.md)
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = kiwix-desktop-translations-bench
+TEMPLATE = app
+
+QMAKE_CXXFLAGS += -std=c++17
+QMAKE_LFLAGS +=  -std=c++17
+
+!win32 {
+    QMAKE_CXXFLAGS += -Werror
+}
+
+# Same generation as in kiwix-desktop.pro
+win32 {
+  PYTHON = python
+} else {
+  PYTHON = python3
+}
+TRANSLATION_TABLES_DIR = $$OUT_PWD/translation_tables
+!system($$PYTHON $$PWD/../../resources/generate_translation_tables.py $$TRANSLATION_TABLES_DIR): error("Cannot generate the translation tables")
+INCLUDEPATH += $$TRANSLATION_TABLES_DIR ../../src
+RESOURCES += $$TRANSLATION_TABLES_DIR/translation_tables.qrc
+
+# The JSON files are read for the comparison with the former QMap
+DEFINES += I18N_DIR=\\\"$$PWD/../../resources/i18n\\\"
+
+SOURCES += \
+    main.cpp \
+    ../../src/translation.cpp
+
+HEADERS += \
+    ../../src/translation.h
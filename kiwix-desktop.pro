@@ -52,6 +52,7 @@ SOURCES += \
     src/contenttypefilter.cpp \
     src/descriptionnode.cpp \
     src/downloadmanagement.cpp \
+    src/downloadverifier.cpp \
     src/findinpagebar.cpp \
     src/flowlayout.cpp \
     src/kiwixchoicebox.cpp \
@@ -60,9 +61,12 @@ SOURCES += \
     src/kiwixlistwidget.cpp \
     src/kiwixloader.cpp \
     src/rownode.cpp \
+    src/suggestioncache.cpp \
     src/suggestionlistworker.cpp \
     src/suggestionlistmodel.cpp \
     src/thumbnaildownloader.cpp \
+    src/titleindex.cpp \
+    src/tracing.cpp \
     src/translation.cpp \
     src/main.cpp \
     src/mainwindow.cpp \
@@ -70,23 +74,39 @@ SOURCES += \
     src/kprofile.cpp \
     src/blobbuffer.cpp \
     src/library.cpp \
+    src/librarytitleindex.cpp \
+    src/servermetrics.cpp \
+    src/servermetricsproxy.cpp \
     src/settingsmanager.cpp \
+    src/serverprocess.cpp \
+    src/servertuning.cpp \
+    src/settingsstore.cpp \
+    src/sidecarindexer.cpp \
     src/settingsview.cpp \
     src/topwidget.cpp \
     src/urlschemehandler.cpp \
     src/webview.cpp \
+    src/webviewpool.cpp \
     src/searchbar.cpp \
     src/mainmenu.cpp \
     src/webpage.cpp \
     src/about.cpp \
+    src/contentcache.cpp \
     src/contentmanager.cpp \
     src/contentmanagerview.cpp \
     src/tabbar.cpp \
+    src/tabhibernator.cpp \
     src/contentmanagerside.cpp \
+    src/diagnosticsdialog.cpp \
     src/readinglistbar.cpp \
     src/klistwidgetitem.cpp \
     src/opdsrequestmanager.cpp \
+    src/peershare.cpp \
+    src/peertransfer.cpp \
     src/localkiwixserver.cpp \
+    src/metalink.cpp \
+    src/mirrorprober.cpp \
+    src/navigationmetrics.cpp \
     src/fullscreenwindow.cpp \
     src/fullscreennotification.cpp \
     src/zimview.cpp \
@@ -100,6 +120,7 @@ HEADERS += \
     src/contenttypefilter.h \
     src/descriptionnode.h \
     src/downloadmanagement.h \
+    src/downloadverifier.h \
     src/findinpagebar.h \
     src/flowlayout.h \
     src/kiwixchoicebox.h \
@@ -109,32 +130,51 @@ HEADERS += \
     src/kiwixloader.h \
     src/node.h \
     src/rownode.h \
+    src/suggestioncache.h \
     src/suggestionlistworker.h \
     src/suggestionlistmodel.h \
     src/thumbnaildownloader.h \
+    src/titleindex.h \
+    src/tracing.h \
     src/translation.h \
     src/mainwindow.h \
     src/kiwixapp.h \
     src/kprofile.h \
     src/blobbuffer.h \
     src/library.h \
+    src/librarytitleindex.h \
+    src/servermetrics.h \
+    src/servermetricsproxy.h \
     src/settingsmanager.h \
+    src/serverprocess.h \
+    src/servertuning.h \
+    src/settingsstore.h \
+    src/sidecarindexer.h \
     src/settingsview.h \
     src/topwidget.h \
     src/kconstants.h \
     src/urlschemehandler.h \
     src/webview.h \
+    src/webviewpool.h \
     src/searchbar.h \
     src/mainmenu.h \
     src/webpage.h \
     src/about.h \
+    src/contentcache.h \
     src/contentmanager.h \
     src/tabbar.h \
+    src/tabhibernator.h \
     src/contentmanagerside.h \
+    src/diagnosticsdialog.h \
     src/readinglistbar.h \
     src/klistwidgetitem.h \
     src/opdsrequestmanager.h \
+    src/peershare.h \
+    src/peertransfer.h \
     src/localkiwixserver.h \
+    src/metalink.h \
+    src/mirrorprober.h \
+    src/navigationmetrics.h \
     src/fullscreenwindow.h \
     src/fullscreennotification.h \
     src/menuproxystyle.h \
@@ -199,7 +239,7 @@ unix {
   INSTALLS += mime_file
 }
 
-DEPS_DEFINITION = \"libkiwix >= 14.0.0 libkiwix < 15.0.0 libzim >= 9.0.0 libzim < 10.0.0\"
+DEPS_DEFINITION = \"libkiwix >= 14.0.0 libkiwix < 15.0.0 libzim >= 9.0.0 libzim < 10.0.0 xapian-core >= 1.4\"
 
 PKGCONFIG_CFLAGS = $$system(pkg-config --cflags $$PKGCONFIG_OPTION $$DEPS_DEFINITION)
 
@@ -214,9 +254,28 @@ win32 {
   LIBS += $$system(python scripts/pkg-config-wrapper.py --libs $$PKGCONFIG_OPTION $$DEPS_DEFINITION)
 }
 
+# The JSON translations are compiled into tables read in place at runtime
+# (see resources/generate_translation_tables.py). They are generated when
+# qmake runs, as rcc needs the list of the files, and again when a JSON file
+# changes.
+win32 {
+  PYTHON = python
+} else {
+  PYTHON = python3
+}
+TRANSLATION_TABLES_DIR = $$OUT_PWD/translation_tables
+TRANSLATION_TABLES_COMMAND = $$PYTHON $$PWD/resources/generate_translation_tables.py $$TRANSLATION_TABLES_DIR
+!system($$TRANSLATION_TABLES_COMMAND): error("Cannot generate the translation tables")
+translation_tables.target = $$TRANSLATION_TABLES_DIR/translationkeys.h
+translation_tables.depends = $$files($$PWD/resources/i18n/*.json) $$PWD/resources/generate_translation_tables.py
+translation_tables.commands = $$TRANSLATION_TABLES_COMMAND
+QMAKE_EXTRA_TARGETS += translation_tables
+PRE_TARGETDEPS += $$translation_tables.target
+INCLUDEPATH += $$TRANSLATION_TABLES_DIR
+
 RESOURCES += \
     resources/kiwix.qrc \
-    resources/translations.qrc \
+    $$TRANSLATION_TABLES_DIR/translation_tables.qrc \
     resources/contentmanager.qrc \
     resources/settingsmanager.qrc \
     resources/style.qrc
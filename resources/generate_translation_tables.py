@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+#
+# This file is part of kiwix-desktop.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Compiles the JSON translations of resources/i18n into the tables read by
+src/translation.cpp, in the given output directory:
+
+- translationkeys.h: the TranslationKey enum, one value per key of en.json;
+- translations/keys.tr: the keys and a minimal perfect hash of them;
+- translations/<lang>.tr: the texts of a language, indexed by TranslationKey,
+  the missing ones taken from en.json;
+- translation_tables.qrc: the resource file listing the tables.
+
+All the integers are 32 bits little endian and the strings are UTF-16
+(little endian), so that the tables are used in place, without parsing.
+
+Files whose content doesn't change are not rewritten, so that running the
+script again doesn't trigger a rebuild.
+"""
+
+import json
+import re
+import struct
+import sys
+from pathlib import Path
+
+KEYS_MAGIC = b"KXTK"
+TEXTS_MAGIC = b"KXTT"
+VERSION = 1
+
+# Keys per bucket of the first level of the perfect hash
+BUCKET_SIZE = 4
+
+script_path = Path(__file__)
+translation_dir = script_path.parent / "i18n"
+
+
+def key_hash(key, seed):
+    """ Must be the same as keyHash() in src/translation.cpp """
+    h = (0x811C9DC5 ^ seed) & 0xFFFFFFFF
+    for unit in struct.unpack("<%dH" % (len(key.encode("utf-16-le")) // 2), key.encode("utf-16-le")):
+        h ^= unit
+        h = (h * 0x01000193) & 0xFFFFFFFF
+    # Final mixing of MurmurHash3
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & 0xFFFFFFFF
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & 0xFFFFFFFF
+    h ^= h >> 16
+    return h
+
+
+def build_perfect_hash(keys):
+    """
+    Hash and displace: the keys are spread in buckets by key_hash(key, 0),
+    then for each bucket (largest first) a seed is searched, with which
+    key_hash(key, seed) puts its keys in free slots of the table.
+    Returns the seeds of the buckets and the key index of each slot.
+    """
+    count = len(keys)
+    bucket_count = max(1, (count + BUCKET_SIZE - 1) // BUCKET_SIZE)
+    buckets = [[] for _ in range(bucket_count)]
+    for index, key in enumerate(keys):
+        buckets[key_hash(key, 0) % bucket_count].append(index)
+
+    seeds = [0] * bucket_count
+    slots = [None] * count
+    for bucket in sorted(range(bucket_count), key=lambda b: -len(buckets[b])):
+        if not buckets[bucket]:
+            continue
+        seed = 1
+        while True:
+            positions = [key_hash(keys[i], seed) % count for i in buckets[bucket]]
+            if len(set(positions)) == len(positions) and all(slots[p] is None for p in positions):
+                break
+            seed += 1
+        seeds[bucket] = seed
+        for index, position in zip(buckets[bucket], positions):
+            slots[position] = index
+    return seeds, slots
+
+
+def pack_strings(strings):
+    """ Offsets and lengths (in UTF-16 units) of the strings, and their data """
+    offsets, lengths, pool = [], [], bytearray()
+    for string in strings:
+        data = string.encode("utf-16-le")
+        offsets.append(len(pool) // 2)
+        lengths.append(len(data) // 2)
+        pool += data
+    return offsets, lengths, bytes(pool)
+
+
+def u32_array(values):
+    return struct.pack("<%dI" % len(values), *values)
+
+
+def make_keys_table(keys):
+    seeds, slots = build_perfect_hash(keys)
+    offsets, lengths, pool = pack_strings(keys)
+    return (KEYS_MAGIC + u32_array([VERSION, len(keys), len(seeds)])
+            + u32_array(seeds) + u32_array(slots)
+            + u32_array(offsets) + u32_array(lengths) + pool)
+
+
+def make_texts_table(keys, texts, default_texts):
+    values = [texts.get(key) or default_texts[key] for key in keys]
+    offsets, lengths, pool = pack_strings(values)
+    return (TEXTS_MAGIC + u32_array([VERSION, len(keys)])
+            + u32_array(offsets) + u32_array(lengths) + pool)
+
+
+def to_identifier(key):
+    # CamelCase, as macros (DELETE in windows.h...) are upper case
+    return "".join(part[:1].upper() + part[1:] for part in re.split(r"[^A-Za-z0-9]+", key))
+
+
+def make_keys_header(keys):
+    lines = [
+        "// Generated by resources/generate_translation_tables.py, do not edit",
+        "",
+        "#ifndef TRANSLATIONKEYS_H",
+        "#define TRANSLATIONKEYS_H",
+        "",
+        "enum class TranslationKey",
+        "{",
+    ]
+    lines += ["    %s, // %s" % (to_identifier(key), key) for key in keys]
+    lines += [
+        "    Count",
+        "};",
+        "",
+        "#endif // TRANSLATIONKEYS_H",
+        "",
+    ]
+    return "\n".join(lines).encode("utf-8")
+
+
+def make_qrc(languages):
+    lines = ["<RCC>", '    <qresource prefix="/">']
+    # Uncompressed, to be used in place
+    lines += ['        <file threshold="100">translations/%s.tr</file>' % name
+              for name in ["keys"] + languages]
+    lines += ["    </qresource>", "</RCC>", ""]
+    return "\n".join(lines).encode("utf-8")
+
+
+def read_texts(path):
+    texts = json.loads(path.read_text(encoding="utf-8"))
+    return {key: value for key, value in texts.items()
+            if not key.startswith("@") and isinstance(value, str)}
+
+
+def write_if_changed(path, data):
+    if path.exists() and path.read_bytes() == data:
+        return
+    path.parent.mkdir(parents=True, exist_ok=True)
+    path.write_bytes(data)
+
+
+def main(out_dir):
+    default_texts = read_texts(translation_dir / "en.json")
+    keys = sorted(default_texts)
+    identifiers = [to_identifier(key) for key in keys]
+    if len(set(identifiers)) != len(identifiers):
+        sys.exit("Translation keys differing only by punctuation")
+
+    languages = []
+    # qqq.json documents the keys, it is not a language
+    for path in sorted(translation_dir.glob("*.json")):
+        if path.stem == "qqq":
+            continue
+        languages.append(path.stem)
+        write_if_changed(out_dir / "translations" / (path.stem + ".tr"),
+                         make_texts_table(keys, read_texts(path), default_texts))
+
+    write_if_changed(out_dir / "translations" / "keys.tr", make_keys_table(keys))
+    write_if_changed(out_dir / "translationkeys.h", make_keys_header(keys))
+    write_if_changed(out_dir / "translation_tables.qrc", make_qrc(languages))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.exit("Usage: %s <output directory>" % sys.argv[0])
+    main(Path(sys.argv[1]))
@@ -0,0 +1,103 @@
+#include "contentcache.h"
+
+#include <QMutexLocker>
+
+#include <zim/archive.h>
+
+namespace
+{
+
+// Share of the total budget given to the entries, the clusters get the rest
+const int ENTRY_BUDGET_PERCENT = 25;
+
+// Larger entries (videos, ...) would evict everything else
+const int MAX_ENTRY_BUDGET_FRACTION = 8;
+
+QString makeKey(const QString& zimId, const QString& path)
+{
+    return zimId + "/" + path;
+}
+
+} // unnamed namespace
+
+ContentCache::ContentCache()
+    : m_defaultBudget(qint64(zim::getClusterCacheMaxSize()))
+{
+    setBudget(0);
+}
+
+void ContentCache::setBudget(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 budget = bytes > 0 ? bytes : m_defaultBudget;
+    m_entryBudget = budget * ENTRY_BUDGET_PERCENT / 100;
+    zim::setClusterCacheMaxSize(size_t(budget - m_entryBudget));
+    evict();
+}
+
+bool ContentCache::isCacheable(qint64 size) const
+{
+    QMutexLocker locker(&m_mutex);
+    return size <= m_entryBudget / MAX_ENTRY_BUDGET_FRACTION;
+}
+
+bool ContentCache::get(const QString& zimId, const QString& path, Entry* entry)
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_index.constFind(makeKey(zimId, path));
+    if ( it == m_index.constEnd() ) {
+        m_misses++;
+        return false;
+    }
+
+    m_hits++;
+    m_entries.splice(m_entries.begin(), m_entries, it.value());
+    *entry = it.value()->second;
+    return true;
+}
+
+void ContentCache::put(const QString& zimId, const QString& path, const Entry& entry)
+{
+    QMutexLocker locker(&m_mutex);
+    if ( entry.data.size() > m_entryBudget / MAX_ENTRY_BUDGET_FRACTION )
+        return;
+
+    const QString key = makeKey(zimId, path);
+    const auto it = m_index.find(key);
+    if ( it != m_index.end() ) {
+        m_entrySize -= it.value()->second.data.size();
+        m_entries.erase(it.value());
+        m_index.erase(it);
+    }
+
+    m_entries.emplace_front(key, entry);
+    m_index.insert(key, m_entries.begin());
+    m_entrySize += entry.data.size();
+    evict();
+}
+
+void ContentCache::evict()
+{
+    while ( m_entrySize > m_entryBudget && !m_entries.empty() ) {
+        const auto& last = m_entries.back();
+        m_entrySize -= last.second.data.size();
+        m_index.remove(last.first);
+        m_entries.pop_back();
+        m_evictions++;
+    }
+}
+
+ContentCache::Stats ContentCache::getStats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.evictions = m_evictions;
+    stats.entryCount = m_index.size();
+    stats.entrySize = m_entrySize;
+    stats.entryBudget = m_entryBudget;
+    stats.clusterCacheSize = qint64(zim::getClusterCacheCurrentSize());
+    stats.clusterCacheBudget = qint64(zim::getClusterCacheMaxSize());
+    return stats;
+}
@@ -0,0 +1,82 @@
+#ifndef CONTENTCACHE_H
+#define CONTENTCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <list>
+
+// Memory budget and statistics of the decoded content shared by the viewer
+// (UrlSchemeHandler) and the local Kiwix server.
+//
+// Both serve the books of the same kiwix::Library, hence the same
+// zim::Archive objects, and libzim keeps the decompressed clusters in a
+// process-wide cache: an article decoded for one of them is not decoded
+// again for the other while its cluster stays in that cache. Most of the
+// budget goes to that cluster cache.
+//
+// The rest of the budget holds the entries most recently served to the
+// viewer (in a LRU list), which also spares the lookup of the entry and the
+// copy of its data out of the cluster. kiwix::Server doesn't offer a way to
+// consult it.
+//
+// The cache may be used from any thread.
+class ContentCache
+{
+public: // types
+    struct Entry
+    {
+        QByteArray mimeType;
+        QByteArray data;
+    };
+
+    struct Stats
+    {
+        qint64 hits = 0;
+        qint64 misses = 0;
+        qint64 evictions = 0;
+        int    entryCount = 0;
+        qint64 entrySize = 0;
+        qint64 entryBudget = 0;
+        qint64 clusterCacheSize = 0;
+        qint64 clusterCacheBudget = 0;
+    };
+
+public: // functions
+    ContentCache();
+
+    // Total budget in bytes, 0 for the default size of the libzim cluster
+    // cache (the entries and the clusters share it in all cases)
+    void setBudget(qint64 bytes);
+
+    // Looks up the entry `path` of the book `zimId`
+    bool get(const QString& zimId, const QString& path, Entry* entry);
+    void put(const QString& zimId, const QString& path, const Entry& entry);
+
+    // Whether data of that size would be kept by put()
+    bool isCacheable(qint64 size) const;
+
+    Stats getStats() const;
+
+private: // types
+    typedef std::list<std::pair<QString, Entry>> EntryList; // most recent first
+
+private: // functions
+    void evict();
+
+private: // data
+    mutable QMutex m_mutex;
+    EntryList m_entries;
+    QHash<QString, EntryList::iterator> m_index;
+    // Size of the libzim cluster cache when the cache was created
+    const qint64 m_defaultBudget;
+    qint64 m_entrySize = 0;
+    qint64 m_entryBudget = 0;
+    qint64 m_hits = 0;
+    qint64 m_misses = 0;
+    qint64 m_evictions = 0;
+};
+
+#endif // CONTENTCACHE_H
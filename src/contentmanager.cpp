@@ -1,6 +1,7 @@
 #include "contentmanager.h"
 
 #include "kiwixapp.h"
+#include "tracing.h"
 #include <kiwix/manager.h>
 #include <kiwix/tools.h>
 
@@ -31,6 +32,9 @@
 namespace
 {
 
+// The catalog is searched for newer versions of all the local books at most
+// once a day
+const qint64 BOOK_UPDATE_CHECK_INTERVAL_SECS = 24 * 60 * 60;
 
 SettingsManager* getSettingsManager()
 {
@@ -115,16 +119,29 @@ ContentManager::ContentManager(Library* library)
 
     connect(this, &DownloadManager::error, this, &ContentManager::handleError);
 
-    if ( DownloadManager::downloadingFunctionalityAvailable() ) {
-        startDownloadUpdaterThread();
+    connect(this, &DownloadManager::downloadVerified,
+            this, &ContentManager::downloadVerified);
+
+    connect(this, &DownloadManager::peerTransferStarted,
+            this, &ContentManager::peerTransferStarted);
+
+    for ( const auto& bookId : mp_library->getBookIds() ) {
+        if ( getSettingsManager()->getSettings(bookId + "/integrityCheck").toString() == "failed" ) {
+            m_booksFailingIntegrityCheck.insert(bookId);
+        }
     }
 
     connect(&m_watcher, &QFileSystemWatcher::directoryChanged,
             this, &ContentManager::asyncUpdateLibraryFromDir);
+
+    connect(&m_remoteLibraryManager, &OpdsRequestManager::bookEntriesReceived,
+            this, &ContentManager::handleBookEntries);
+    QTimer::singleShot(0, this, &ContentManager::checkForBookUpdates);
 }
 
 void ContentManager::updateModel()
 {
+    KIWIX_TRACE_SCOPE("ContentManager::updateModel");
     const auto bookIds = getBookIds();
     BookInfoList bookList;
     QStringList keys = {"title", "tags", "date", "id", "size", "description", "favicon"};
@@ -146,14 +163,34 @@ void ContentManager::onCustomContextMenu(const QPoint &point)
     auto bookNode = static_cast<RowNode*>(index.internalPointer());
     const auto id = bookNode->getBookId();
 
-    QAction menuDeleteBook(gt("delete-book"), this);
-    QAction menuOpenBook(gt("open-book"), this);
-    QAction menuDownloadBook(gt("download-book"), this);
-    QAction menuPauseBook(gt("pause-download"), this);
-    QAction menuResumeBook(gt("resume-download"), this);
-    QAction menuCancelBook(gt("cancel-download"), this);
-    QAction menuOpenFolder(gt("open-folder"), this);
-    QAction menuPreviewBook(gt("preview-book-in-web-browser"), this);
+    QAction menuDeleteBook(gt(TranslationKey::DeleteBook), this);
+    QAction menuOpenBook(gt(TranslationKey::OpenBook), this);
+    QAction menuDownloadBook(gt(TranslationKey::DownloadBook), this);
+    QAction menuUpdateBook(gt(TranslationKey::UpdateBook), this);
+    QAction menuDownloadSelectedBooks(this);
+    QAction menuPauseBook(gt(TranslationKey::PauseDownload), this);
+    QAction menuResumeBook(gt(TranslationKey::ResumeDownload), this);
+    QAction menuCancelBook(gt(TranslationKey::CancelDownload), this);
+    QAction menuOpenFolder(gt(TranslationKey::OpenFolder), this);
+    QAction menuPreviewBook(gt(TranslationKey::PreviewBookInWebBrowser), this);
+
+    // Bulk download of the selected books (if the context menu was opened
+    // on one of them)
+    QStringList selectedBooksToDownload;
+    const QStringList selectedIds = getSelectedBookIds();
+    if ( selectedIds.contains(id) ) {
+        for ( const auto& selectedId : selectedIds ) {
+            if ( getBookState(selectedId) == BookState::AVAILABLE_ONLINE ) {
+                selectedBooksToDownload.append(selectedId);
+            }
+        }
+    }
+    if ( selectedBooksToDownload.size() > 1 ) {
+        auto text = gt("download-selected-books");
+        text = text.replace("{{COUNT}}", QString::number(selectedBooksToDownload.size()));
+        menuDownloadSelectedBooks.setText(text);
+        contextMenu.addAction(&menuDownloadSelectedBooks);
+    }
 
     const auto bookState = getBookState(id);
     switch ( bookState ) {
@@ -182,6 +219,9 @@ void ContentManager::onCustomContextMenu(const QPoint &point)
             if ( bookState == BookState::AVAILABLE_LOCALLY_AND_HEALTHY ) {
                 contextMenu.addAction(&menuOpenBook);
             }
+            if ( m_bookUpdates.contains(id) ) {
+                contextMenu.addAction(&menuUpdateBook);
+            }
             contextMenu.addAction(&menuDeleteBook);
             contextMenu.addAction(&menuOpenFolder);
             connect(&menuOpenFolder, &QAction::triggered, [=]() {
@@ -207,6 +247,12 @@ void ContentManager::onCustomContextMenu(const QPoint &point)
     connect(&menuDownloadBook, &QAction::triggered, [=]() {
         downloadBook(id);
     });
+    connect(&menuUpdateBook, &QAction::triggered, [=]() {
+        updateBook(id);
+    });
+    connect(&menuDownloadSelectedBooks, &QAction::triggered, [=]() {
+        downloadBooks(selectedBooksToDownload);
+    });
     connect(&menuPauseBook, &QAction::triggered, [=]() {
         pauseBook(id, index);
     });
@@ -351,15 +397,18 @@ QVariant getBookAttribute(const kiwix::Book& b, const QString& a)
     return QVariant();
 }
 
-ContentManager::BookState getStateOfLocalBook(const kiwix::Book& book)
+ContentManager::BookState getStateOfLocalBook(const kiwix::Book& book, bool failedIntegrityCheck)
 {
     if ( !book.isPathValid() ) {
         return ContentManager::BookState::ERROR_MISSING_ZIM_FILE;
     }
 
-    // XXX: When a book is detected to be corrupted, information about that
-    // XXX: has to be recorded somewhere so that we can return
-    // XXX: ERROR_CORRUPTED_ZIM_FILE here
+    // XXX: Only corruption detected by the verification of downloaded files
+    // XXX: is recorded so far. ZIM files failing to open should be recorded
+    // XXX: too.
+    if ( failedIntegrityCheck ) {
+        return ContentManager::BookState::ERROR_CORRUPTED_ZIM_FILE;
+    }
 
     return ContentManager::BookState::AVAILABLE_LOCALLY_AND_HEALTHY;
 }
@@ -406,7 +455,7 @@ ContentManager::BookState ContentManager::getBookState(QString bookId)
     try {
         const kiwix::Book& b = mp_library->getBookById(bookId);
         return b.getDownloadId().empty()
-             ? getStateOfLocalBook(b)
+             ? getStateOfLocalBook(b, m_booksFailingIntegrityCheck.contains(bookId))
              : BookState::DOWNLOADING;
     } catch (...) {}
 
@@ -476,6 +525,7 @@ void ContentManager::removeDownload(QString bookId)
 void ContentManager::downloadDisappeared(QString bookId)
 {
     removeDownload(bookId);
+    abandonVerification(bookId);
     kiwix::Book bCopy;
     try {
         bCopy = mp_library->getBookById(bookId);
@@ -508,6 +558,47 @@ void ContentManager::downloadCompleted(QString bookId, QString path)
     } else {
         emit(mp_library->booksChanged());
     }
+    verifyCompletedDownload(bookId, path);
+
+    // An update replaces the old version of the book only after its
+    // integrity has been checked (if that is possible at all)
+    if ( !isBeingVerified(bookId) ) {
+        replaceOlderVersion(bookId);
+    }
+}
+
+void ContentManager::downloadVerified(QString bookId, DownloadVerifier::Verdict verdict)
+{
+    if ( verdict != DownloadVerifier::FAILED ) {
+        qInfo() << "Integrity of the download of book" << bookId
+                << (verdict == DownloadVerifier::VERIFIED ? "verified" : "cannot be verified");
+
+        // An UNVERIFIABLE verdict may be reached before the download completes
+        if ( !getDownloadState(bookId) ) {
+            replaceOlderVersion(bookId);
+        }
+        return;
+    }
+
+    kiwix::Book book;
+    try {
+        book = mp_library->getBookById(bookId);
+    } catch ( const std::out_of_range& ) {
+        // The book was removed before the verification completed
+        return;
+    }
+
+    m_booksFailingIntegrityCheck.insert(bookId);
+    getSettingsManager()->setSettings(bookId + "/integrityCheck", "failed");
+    if (!m_local) {
+        emit(oneBookChanged(bookId));
+    } else {
+        emit(booksChanged());
+    }
+
+    auto text = gt("download-integrity-error-text");
+    text = text.replace("{{ZIM}}", QString::fromStdString(book.getTitle()));
+    showErrorBox(KiwixAppError(gt("download-integrity-error"), text), mp_view);
 }
 
 void ContentManager::updateDownload(QString bookId, const DownloadInfo& downloadInfo)
@@ -520,11 +611,22 @@ void ContentManager::updateDownload(QString bookId, const DownloadInfo& download
         } else {
             mp_library->updateBookBeingDownloaded(bookId, downloadPath);
             downloadState->update(downloadInfo);
+            verifyDownloadProgress(bookId, downloadInfo);
             managerModel->updateDownload(bookId);
         }
     }
 }
 
+void ContentManager::peerTransferStarted(QString bookId, QString path)
+{
+    kiwix::Book bCopy(mp_library->getBookById(bookId));
+    bCopy.setDownloadId(DownloadManager::getPeerDownloadId(bookId));
+    mp_library->getKiwixLibrary()->addOrUpdateBook(bCopy);
+    mp_library->updateBookBeingDownloaded(bookId, path);
+    mp_library->save();
+    emit(oneBookChanged(bookId));
+}
+
 void ContentManager::handleError(QString errSummary, QString errDetails)
 {
     showErrorBox(KiwixAppError(errSummary, errDetails), mp_view);
@@ -532,22 +634,185 @@ void ContentManager::handleError(QString errSummary, QString errDetails)
 
 void ContentManager::downloadBook(const QString &id)
 {
-    kiwix::Book book = getRemoteOrLocalBook(id);
+    enqueueBookDownloads({getRemoteOrLocalBook(id)});
+}
+
+void ContentManager::downloadBooks(const QStringList &ids)
+{
+    QList<kiwix::Book> books;
+    for ( const auto& id : ids ) {
+        if ( getBookState(id) == BookState::AVAILABLE_ONLINE ) {
+            books.append(getRemoteOrLocalBook(id));
+        }
+    }
+
+    if ( !books.isEmpty() ) {
+        enqueueBookDownloads(books);
+    }
+}
+
+void ContentManager::updateBook(const QString &id)
+{
+    if ( !m_bookUpdates.contains(id) )
+        return;
+
+    const kiwix::Book newBook = m_bookUpdates.value(id);
+    if ( enqueueBookDownloads({newBook}) ) {
+        const QString newId = QString::fromStdString(newBook.getId());
+        getSettingsManager()->setSettings(newId + "/replacesBook", id);
+        m_bookUpdates.remove(id);
+    }
+}
+
+bool ContentManager::enqueueBookDownloads(const QList<kiwix::Book>& books)
+{
     const auto downloadPath = getSettingsManager()->getDownloadDir();
 
     try {
-        DownloadManager::checkThatBookCanBeDownloaded(book, downloadPath);
+        DownloadManager::checkThatBooksCanBeDownloaded(books, downloadPath);
     } catch ( const KiwixAppError& err ) {
         showErrorBox(err, mp_view);
-        return;
+        return false;
     }
 
-    mp_library->addBookBeingDownloaded(book, downloadPath);
+    mp_library->addBooksBeingDownloaded(books, downloadPath);
     mp_library->save();
 
-    DownloadManager::addRequest(DownloadState::START, id);
-    const auto downloadState = DownloadManager::getDownloadState(id);
-    managerModel->setDownloadState(id, downloadState);
+    for ( const auto& book : books ) {
+        const QString id = QString::fromStdString(book.getId());
+        DownloadManager::addRequest(DownloadState::START, id);
+        const auto downloadState = DownloadManager::getDownloadState(id);
+        managerModel->setDownloadState(id, downloadState);
+    }
+    return true;
+}
+
+QStringList ContentManager::getSelectedBookIds() const
+{
+    QStringList ids;
+    for ( const auto& index : mp_view->getView()->selectionModel()->selectedRows() ) {
+        if ( !isDescriptionIndex(index) ) {
+            ids.append(static_cast<Node*>(index.internalPointer())->getBookId());
+        }
+    }
+    return ids;
+}
+
+void ContentManager::checkForBookUpdates()
+{
+    // In between the daily checks, only the books known to have a newer
+    // version are looked up again (so that they can still be updated after a
+    // restart)
+    const auto settingsManager = getSettingsManager();
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const QDateTime lastCheck = settingsManager->getSettings("catalog/lastUpdateCheck").toDateTime();
+    const bool fullCheck = !lastCheck.isValid() || lastCheck > now
+                        || lastCheck.secsTo(now) >= BOOK_UPDATE_CHECK_INTERVAL_SECS;
+    const QStringList updatableBooks = settingsManager->getSettings("catalog/updatableBooks").toStringList();
+
+    QStringSet bookNames;
+    for ( const auto& bookId : mp_library->getBookIds() ) {
+        const auto& book = mp_library->getBookById(bookId);
+        const QString name = QString::fromStdString(book.getName());
+        if ( book.getDownloadId().empty() && !name.isEmpty()
+             && (fullCheck || updatableBooks.contains(name)) ) {
+            bookNames.insert(name);
+        }
+    }
+
+    if ( fullCheck ) {
+        settingsManager->setSettings("catalog/lastUpdateCheck", now);
+    }
+
+    for ( const auto& name : bookNames ) {
+        m_remoteLibraryManager.getBookEntriesByName(name);
+    }
+}
+
+void ContentManager::handleBookEntries(const QString& bookName, const QString& content)
+{
+    if ( content.isEmpty() )
+        return;
+
+    const auto catalog = kiwix::Library::create();
+    kiwix::Manager manager(catalog);
+    manager.readOpds(content.toStdString(), getRemoteLibraryUrl().toStdString());
+
+    bool updatable = false;
+    for ( const auto& bookId : mp_library->getBookIds() ) {
+        const auto& localBook = mp_library->getBookById(bookId);
+        if ( QString::fromStdString(localBook.getName()) != bookName
+             || !localBook.getDownloadId().empty() )
+            continue;
+
+        // The newest book of the same name and flavour (dates are in the
+        // YYYY-MM-DD format and compare correctly as strings)
+        const kiwix::Book* newest = nullptr;
+        for ( const auto& id : catalog->getBooksIds() ) {
+            const auto& b = catalog->getBookById(id);
+            if ( b.getName() == localBook.getName()
+                 && b.getFlavour() == localBook.getFlavour()
+                 && !b.getUrl().empty()
+                 && b.getDate() > (newest ? newest->getDate() : localBook.getDate()) ) {
+                newest = &b;
+            }
+        }
+
+        if ( newest && m_bookUpdates.contains(bookId) ) {
+            updatable = true;
+        } else if ( newest ) {
+            const QString newId = QString::fromStdString(newest->getId());
+            bool alreadyPresent = true;
+            try {
+                mp_library->getBookById(newId);
+            } catch ( const std::out_of_range& ) {
+                alreadyPresent = false;
+            }
+
+            if ( !alreadyPresent ) {
+                qInfo() << "Book" << bookId << "can be updated to version"
+                        << QString::fromStdString(newest->getDate());
+                m_bookUpdates.insert(bookId, *newest);
+                updatable = true;
+            }
+        }
+    }
+
+    const QString key = "catalog/updatableBooks";
+    QStringList updatableBooks = getSettingsManager()->getSettings(key).toStringList();
+    if ( updatable != updatableBooks.contains(bookName) ) {
+        if ( updatable ) {
+            updatableBooks.append(bookName);
+        } else {
+            updatableBooks.removeAll(bookName);
+        }
+        getSettingsManager()->setSettings(key, updatableBooks);
+    }
+}
+
+void ContentManager::replaceOlderVersion(const QString& bookId)
+{
+    const QString key = bookId + "/replacesBook";
+    const QString oldBookId = getSettingsManager()->getSettings(key).toString();
+    if ( oldBookId.isEmpty() )
+        return;
+
+    getSettingsManager()->deleteSettings(key);
+    try {
+        mp_library->getBookById(oldBookId);
+    } catch ( const std::out_of_range& ) {
+        // The old version has been removed meanwhile
+        return;
+    }
+
+    // The new version is already in the library at this point, so the book
+    // is never missing from the library
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    const auto moveToTrash = getSettingsManager()->getMoveToTrash();
+#else
+    const auto moveToTrash = false;
+#endif
+    reallyEraseBook(oldBookId, moveToTrash);
 }
 
 // This function is called asynchronously in a worker thread processing all
@@ -656,6 +921,7 @@ void ContentManager::reallyEraseBook(const QString& id, bool moveToTrash)
         emit(oneBookChanged(id));
     }
     getSettingsManager()->deleteSettings(id);
+    m_booksFailingIntegrityCheck.remove(id);
     emit booksChanged();
 }
 
@@ -702,6 +968,7 @@ void ContentManager::cancelBook(const QString& id)
 void ContentManager::downloadWasCancelled(const QString& id)
 {
     removeDownload(id);
+    abandonVerification(id);
 
     // incompleted downloaded file should be perma deleted
     eraseBookFilesFromComputer(mp_library->getBookFilePath(id), false);
@@ -769,6 +1036,7 @@ void ContentManager::updateLibrary() {
 
 void ContentManager::updateRemoteLibrary(const QString& content) {
     (void) QtConcurrent::run([=]() {
+        KIWIX_TRACE_SCOPE("ContentManager::updateRemoteLibrary");
         QMutexLocker locker(&remoteLibraryLocker);
         mp_remoteLibrary = kiwix::Library::create();
         kiwix::Manager manager(mp_remoteLibrary);
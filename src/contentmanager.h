@@ -91,6 +91,9 @@ public slots:
     void openBook(const QString& id);
     void openBookPreview(const QString& id);
     void downloadBook(const QString& id);
+    void downloadBooks(const QStringList& ids);
+    // Downloads the newer version of a book and replaces the old one with it
+    void updateBook(const QString& id);
     void updateLibrary();
     void setSearch(const QString& search);
     void setSortBy(const QString& sortBy, const bool sortOrderAsc);
@@ -106,6 +109,8 @@ public slots:
     void openBookWithIndex(const QModelIndex& index);
     void updateDownload(QString bookId, const DownloadInfo& downloadInfo);
     void downloadWasCancelled(const QString& id);
+    void downloadVerified(QString bookId, DownloadVerifier::Verdict verdict);
+    void peerTransferStarted(QString bookId, QString path);
     void handleError(QString errSummary, QString errDetails);
 
 private: // types
@@ -174,6 +179,15 @@ private: // functions
     void removeDownload(QString bookId);
     void downloadDisappeared(QString bookId);
     void downloadCompleted(QString bookId, QString path);
+    // Adds all the books to the library in one go and enqueues their downloads
+    bool enqueueBookDownloads(const QList<kiwix::Book>& books);
+    QStringList getSelectedBookIds() const;
+
+    // Looks the local books up in the catalog for newer versions (all of
+    // them once a day, see BOOK_UPDATE_CHECK_INTERVAL_SECS)
+    void checkForBookUpdates();
+    void handleBookEntries(const QString& bookName, const QString& content);
+    void replaceOlderVersion(const QString& bookId);
 
 private: // data
     Library* mp_library;
@@ -196,6 +210,12 @@ private: // data
     QFileSystemWatcher m_watcher;
     QMutex m_updateFromDirMutex;
     QMap<QString, ZimFileName2InfoMap> m_knownZimsInDir;
+
+    // Books whose downloaded ZIM files didn't match their published checksums
+    QStringSet m_booksFailingIntegrityCheck;
+
+    // Local book id -> newer version of the book available in the catalog
+    QMap<QString, kiwix::Book> m_bookUpdates;
 };
 
 #endif // CONTENTMANAGER_H
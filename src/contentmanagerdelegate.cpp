@@ -9,6 +9,8 @@
 #include "descriptionnode.h"
 #include "portutils.h"
 
+#include <algorithm>
+
 ContentManagerDelegate::ContentManagerDelegate(QObject *parent)
     : QStyledItemDelegate(parent), baseButton(new QPushButton)
 {
@@ -83,7 +85,34 @@ void createCancelButton(QPainter *painter, const QRect& r)
     painter->setFont(oldFont);
 }
 
-void createDownloadStats(QPainter *painter, QRect box, QString downloadSpeed, QString completedLength)
+void createSpeedSparkline(QPainter *painter, QRect r, const QVector<double>& speeds)
+{
+    if ( speeds.size() < 2 )
+        return;
+
+    const double maxSpeed = *std::max_element(speeds.begin(), speeds.end());
+    if ( maxSpeed <= 0 )
+        return;
+
+    QPainterPath path;
+    const double dx = double(r.width()) / (speeds.size() - 1);
+    for ( int i = 0; i < speeds.size(); ++i ) {
+        const QPointF p(r.left() + i * dx,
+                        r.bottom() - speeds[i] / maxSpeed * r.height());
+        if ( i == 0 )
+            path.moveTo(p);
+        else
+            path.lineTo(p);
+    }
+
+    QPen pen;
+    pen.setWidth(1);
+    pen.setColor("#3366cc");
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->strokePath(path, pen);
+}
+
+void createDownloadStats(QPainter *painter, QRect box, const DownloadState& downloadInfo)
 {
     QPen pen;
     int x = box.x();
@@ -94,11 +123,16 @@ void createDownloadStats(QPainter *painter, QRect box, QString downloadSpeed, QS
     painter->setPen(pen);
     auto oldFont = painter->font();
     painter->setFont(QFont("Selawik", 8));
-    QRect nRect(x - 20, y - 10, w, h);
-    painter->drawText(nRect,Qt::AlignCenter | Qt::AlignJustify, downloadSpeed);
-    QRect fRect(x - 20, y + 10, w, h);
-    painter->drawText(fRect,Qt::AlignCenter | Qt::AlignJustify, completedLength);
+    QRect nRect(x - 20, y - 16, w, h);
+    painter->drawText(nRect,Qt::AlignCenter | Qt::AlignJustify, downloadInfo.getDownloadSpeed());
+    QRect fRect(x - 20, y, w, h);
+    painter->drawText(fRect,Qt::AlignCenter | Qt::AlignJustify, downloadInfo.completedLength);
+    QRect eRect(x - 20, y + 16, w, h);
+    painter->drawText(eRect,Qt::AlignCenter | Qt::AlignJustify, downloadInfo.getEstimatedTimeLeftString());
     painter->setFont(oldFont);
+
+    const QRect sparklineRect(x + 10, y + h - 13, w/2 - 20, 8);
+    createSpeedSparkline(painter, sparklineRect, downloadInfo.getSpeedHistory());
 }
 
 struct DownloadControlLayout
@@ -128,15 +162,13 @@ void showDownloadProgress(QPainter *painter, QRect box, const DownloadState& dow
     const DownloadControlLayout dcl = getDownloadControlLayout(box);
     double progress  = (double) (downloadInfo.progress) / 100;
     progress = -progress;
-    auto completedLength = downloadInfo.completedLength;
-    auto downloadSpeed = downloadInfo.getDownloadSpeed();
 
     if (downloadInfo.getStatus() == DownloadState::PAUSED) {
         createResumeSymbol(painter, dcl.pauseResumeButtonRect);
         createCancelButton(painter, dcl.cancelButtonRect);
     } else if (downloadInfo.getStatus() == DownloadState::DOWNLOADING) {
         createPauseSymbol(painter, dcl.pauseResumeButtonRect);
-        createDownloadStats(painter, box, downloadSpeed, completedLength);
+        createDownloadStats(painter, box, downloadInfo);
     }
 
     QPen pen;
@@ -176,10 +208,10 @@ void ContentManagerDelegate::paintBookState(QPainter *p, const QStyleOptionViewI
     const auto id = node->getBookId();
     switch ( KiwixApp::instance()->getContentManager()->getBookState(id) ) {
     case ContentManager::BookState::AVAILABLE_LOCALLY_AND_HEALTHY:
-        return paintButton(p, r, gt("open"));
+        return paintButton(p, r, gt(TranslationKey::Open));
 
     case ContentManager::BookState::AVAILABLE_ONLINE:
-        return paintButton(p, r, gt("download"));
+        return paintButton(p, r, gt(TranslationKey::Download));
 
     case ContentManager::BookState::DOWNLOADING:
     case ContentManager::BookState::DOWNLOAD_PAUSED:
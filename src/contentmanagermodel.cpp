@@ -6,12 +6,20 @@
 #include <zim/item.h>
 #include "kiwixapp.h"
 #include <kiwix/tools.h>
+#include <algorithm>
+#include <limits>
 
 ContentManagerModel::ContentManagerModel(ContentManager *contentMgr)
     : QAbstractItemModel(contentMgr)
     , m_contentMgr(*contentMgr)
 {
     connect(&td, &ThumbnailDownloader::oneThumbnailDownloaded, this, &ContentManagerModel::updateImage);
+
+    // Updates of all downloads are requested at once every second and
+    // arrive within a short time from each other
+    m_downloadUpdatesFlushTimer.setSingleShot(true);
+    m_downloadUpdatesFlushTimer.setInterval(200);
+    connect(&m_downloadUpdatesFlushTimer, &QTimer::timeout, this, &ContentManagerModel::flushDownloadUpdates);
 }
 
 ContentManagerModel::~ContentManagerModel()
@@ -252,11 +260,27 @@ void ContentManagerModel::updateImage(QString bookId, QString url, QByteArray im
 
 void ContentManagerModel::updateDownload(QString bookId)
 {
-    const auto it = bookIdToRowMap.constFind(bookId);
+    m_booksWithDownloadUpdates.insert(bookId);
+    if ( !m_downloadUpdatesFlushTimer.isActive() ) {
+        m_downloadUpdatesFlushTimer.start();
+    }
+}
+
+void ContentManagerModel::flushDownloadUpdates()
+{
+    int minRow = std::numeric_limits<int>::max();
+    int maxRow = -1;
+    for ( const auto& bookId : m_booksWithDownloadUpdates ) {
+        const auto it = bookIdToRowMap.constFind(bookId);
+        if ( it != bookIdToRowMap.constEnd() ) {
+            minRow = std::min(minRow, int(it.value()));
+            maxRow = std::max(maxRow, int(it.value()));
+        }
+    }
+    m_booksWithDownloadUpdates.clear();
 
-    if ( it != bookIdToRowMap.constEnd() ) {
-        const size_t row = it.value();
-        triggerDataUpdateAt( this->index(row, 5) );
+    if ( maxRow >= 0 ) {
+        emit dataChanged(this->index(minRow, 5), this->index(maxRow, 5));
     }
 }
 
@@ -5,6 +5,8 @@
 #include <QModelIndex>
 #include <QVariant>
 #include <QIcon>
+#include <QSet>
+#include <QTimer>
 #include "thumbnaildownloader.h"
 #include "rownode.h"
 #include "downloadmanagement.h"
@@ -53,6 +55,7 @@ private: // functions
     // QString) from where the actual data can be obtained.
     QVariant getThumbnail(const QVariant& faviconEntry) const;
     RowNode* getRowNode(size_t row);
+    void flushDownloadUpdates();
 
 private: // data
     ContentManager& m_contentMgr;
@@ -60,6 +63,11 @@ private: // data
     mutable ThumbnailDownloader td;
     QMap<QString, size_t> bookIdToRowMap;
     QMap<QString, QByteArray> m_iconMap;
+
+    // Download progress updates are coalesced and reported to the view with
+    // a single dataChanged() signal per polling cycle of the downloads
+    QSet<QString> m_booksWithDownloadUpdates;
+    QTimer m_downloadUpdatesFlushTimer;
 };
 
 inline bool isDescriptionIndex(const QModelIndex& index)
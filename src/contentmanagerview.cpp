@@ -12,6 +12,7 @@ ContentManagerView::ContentManagerView(QWidget *parent)
     mp_ui->m_view->setSortingEnabled(true);
     mp_ui->m_view->setStyleSheet(KiwixApp::instance()->parseStyleFromFile(":/css/_contentManager.css"));
     mp_ui->m_view->setContextMenuPolicy(Qt::CustomContextMenu);
+    mp_ui->m_view->setSelectionMode(QAbstractItemView::ExtendedSelection);
     auto managerDelegate = new ContentManagerDelegate();
     mp_ui->m_view->setItemDelegate(managerDelegate);
     mp_ui->m_view->setCursor(Qt::PointingHandCursor);
@@ -0,0 +1,153 @@
+#include "diagnosticsdialog.h"
+#include "kiwixapp.h"
+
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLabel>
+#include <QPushButton>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+#include <kiwix/tools.h>
+
+#include <algorithm>
+
+namespace
+{
+
+QTableWidgetItem* createNumberItem(qint64 value)
+{
+    const auto item = new QTableWidgetItem;
+    // Sorted as a number, not as a string
+    item->setData(Qt::DisplayRole, value < 0 ? QVariant() : QVariant(value));
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+} // unnamed namespace
+
+DiagnosticsDialog::DiagnosticsDialog(QWidget *parent)
+    : QDialog(parent),
+      mp_table(new QTableWidget(this)),
+      mp_cacheStats(new QLabel(this))
+{
+    setWindowTitle(gt("diagnostics"));
+    resize(800, 400);
+
+    mp_table->setColumnCount(7);
+    mp_table->setHorizontalHeaderLabels({gt("diagnostics-book"),
+                                         gt("diagnostics-loads"),
+                                         gt("diagnostics-first-request"),
+                                         gt("diagnostics-document-served"),
+                                         gt("diagnostics-load-finished"),
+                                         gt("diagnostics-subresources"),
+                                         gt("diagnostics-transferred")});
+    mp_table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    mp_table->verticalHeader()->hide();
+    mp_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    mp_table->setSelectionMode(QAbstractItemView::NoSelection);
+    mp_table->setSortingEnabled(true);
+
+    const auto buttons = new QDialogButtonBox(this);
+    const auto exportButton = buttons->addButton(gt("diagnostics-export"), QDialogButtonBox::ActionRole);
+    const auto clearButton = buttons->addButton(gt("diagnostics-clear"), QDialogButtonBox::ResetRole);
+    const auto closeButton = buttons->addButton(gt("close"), QDialogButtonBox::RejectRole);
+    connect(exportButton, &QPushButton::clicked, this, &DiagnosticsDialog::exportJson);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::close);
+
+    const auto metrics = KiwixApp::instance()->getNavigationMetrics();
+    connect(clearButton, &QPushButton::clicked, metrics, &NavigationMetrics::clear);
+    connect(metrics, &NavigationMetrics::statsChanged, this, [=]() {
+        if (isVisible())
+            updateTable();
+    });
+
+    const auto layout = new QVBoxLayout(this);
+    layout->addWidget(mp_table);
+    layout->addWidget(mp_cacheStats);
+    layout->addWidget(buttons);
+}
+
+void DiagnosticsDialog::showEvent(QShowEvent *event)
+{
+    updateTable();
+    QDialog::showEvent(event);
+}
+
+void DiagnosticsDialog::updateTable()
+{
+    const auto app = KiwixApp::instance();
+    const auto& bookStats = app->getNavigationMetrics()->getBookStats();
+
+    mp_table->setSortingEnabled(false);
+    mp_table->setRowCount(bookStats.size());
+    int row = 0;
+    for (auto it = bookStats.constBegin(); it != bookStats.constEnd(); ++it, ++row) {
+        const auto& stats = it.value();
+        QString title = it.key();
+        try {
+            title = QString::fromStdString(app->getLibrary()->getBookById(it.key()).getTitle());
+        } catch (...) {}
+
+        const int loads = std::max(1, stats.navigations);
+        mp_table->setItem(row, 0, new QTableWidgetItem(title));
+        mp_table->setItem(row, 1, createNumberItem(stats.navigations));
+        mp_table->setItem(row, 2, createNumberItem(stats.timeToFirstRequest.mean()));
+        mp_table->setItem(row, 3, createNumberItem(stats.timeToDocument.mean()));
+        mp_table->setItem(row, 4, createNumberItem(stats.timeToLoadFinished.mean()));
+        mp_table->setItem(row, 5, createNumberItem(stats.subresourceRequests / loads));
+        mp_table->setItem(row, 6, createNumberItem((stats.documentBytes + stats.subresourceBytes) / loads / 1024));
+    }
+    mp_table->setSortingEnabled(true);
+
+    const auto cacheStats = app->getContentCache()->getStats();
+    const qint64 lookups = cacheStats.hits + cacheStats.misses;
+    const auto formatSize = [](qint64 size) {
+        return QString::fromStdString(kiwix::beautifyFileSize(size));
+    };
+    mp_cacheStats->setText(gt("diagnostics-content-cache")
+        .replace("{{ENTRIES}}", QString::number(cacheStats.entryCount))
+        .replace("{{ENTRY_SIZE}}", formatSize(cacheStats.entrySize))
+        .replace("{{ENTRY_BUDGET}}", formatSize(cacheStats.entryBudget))
+        .replace("{{HIT_RATE}}", QString::number(lookups ? 100 * cacheStats.hits / lookups : 0))
+        .replace("{{CLUSTER_SIZE}}", formatSize(cacheStats.clusterCacheSize))
+        .replace("{{CLUSTER_BUDGET}}", formatSize(cacheStats.clusterCacheBudget)));
+}
+
+void DiagnosticsDialog::exportJson()
+{
+    const auto app = KiwixApp::instance();
+    const auto documentsDir = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+    const QString fileName = QFileDialog::getSaveFileName(this,
+                                                          gt("save-file-as-window-title"),
+                                                          documentsDir + "/kiwix_diagnostics.json",
+                                                          "(*.json)");
+    if (fileName.isEmpty())
+        return;
+
+    QJsonObject json = app->getNavigationMetrics()->toJson();
+    const auto cacheStats = app->getContentCache()->getStats();
+    json["contentCache"] = QJsonObject{
+        { "hits",               cacheStats.hits },
+        { "misses",             cacheStats.misses },
+        { "evictions",          cacheStats.evictions },
+        { "entryCount",         cacheStats.entryCount },
+        { "entrySize",          cacheStats.entrySize },
+        { "entryBudget",        cacheStats.entryBudget },
+        { "clusterCacheSize",   cacheStats.clusterCacheSize },
+        { "clusterCacheBudget", cacheStats.clusterCacheBudget }
+    };
+    json["mirrors"] = QJsonObject::fromVariantMap(DownloadManager::getMirrorStatistics());
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)
+     || file.write(QJsonDocument(json).toJson()) < 0
+     || !file.commit()) {
+        app->showMessage(gt("diagnostics-export-error"), gt("error-title"), QMessageBox::Information);
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef DIAGNOSTICSDIALOG_H
+#define DIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+
+class QLabel;
+class QTableWidget;
+
+// Shows the article load timings of NavigationMetrics, per book
+class DiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsDialog(QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
+private:
+    void updateTable();
+    void exportJson();
+
+    QTableWidget* mp_table;
+    QLabel* mp_cacheStats;
+};
+
+#endif // DIAGNOSTICSDIALOG_H
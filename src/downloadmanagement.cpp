@@ -2,7 +2,12 @@
 
 #include "kiwixapp.h"
 #include "kiwixconfirmbox.h"
+#include "tracing.h"
 
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QNetworkReply>
+#include <QPointer>
 #include <QStorageInfo>
 #include <QThread>
 
@@ -26,6 +31,19 @@ QString convertToUnits(double bytes)
     return preciseBytes + " " + units[unitIndex];
 }
 
+// Number of progress samples kept per download (the samples are taken
+// every second)
+const int SAMPLE_HISTORY_SIZE = 60;
+
+// Time window (in seconds) over which the download speed is averaged
+const double SPEED_SMOOTHING_WINDOW = 10.0;
+
+double secondsBetween(std::chrono::steady_clock::time_point t1,
+                      std::chrono::steady_clock::time_point t2)
+{
+    return std::chrono::duration<double>(t2 - t1).count();
+}
+
 DownloadState::Status getDownloadStatus(QString status)
 {
     if ( status == "active" )    return DownloadState::DOWNLOADING;
@@ -49,15 +67,88 @@ bool DownloadState::isLateUpdateInfo(const DownloadInfo& info) const
 void DownloadState::update(const DownloadInfo& info)
 {
     const auto completedBytes = info["completedLength"].toDouble();
-    const double percentage = completedBytes / info["totalLength"].toDouble();
+    m_totalBytes = info["totalLength"].toDouble();
+    const double percentage = completedBytes / m_totalBytes;
 
     progress = QString::number(100 * percentage, 'g', 3).toDouble();
     completedLength = convertToUnits(completedBytes);
-    downloadSpeed = convertToUnits(info["downloadSpeed"].toDouble()) + "/s";
     if ( !isLateUpdateInfo(info) ) {
         status = getDownloadStatus(info["status"].toString());
     }
     lastUpdated = std::chrono::steady_clock::now();
+    addSample({lastUpdated, completedBytes});
+
+    // aria2 reports the instantaneous speed, which is very jumpy; fall back
+    // to it only until enough samples are collected
+    const double smoothedSpeed = getSmoothedSpeed();
+    downloadSpeed = convertToUnits(smoothedSpeed > 0 ? smoothedSpeed : info["downloadSpeed"].toDouble()) + "/s";
+}
+
+void DownloadState::addSample(const Sample& s)
+{
+    if ( m_samples.size() < SAMPLE_HISTORY_SIZE ) {
+        m_samples.append(s);
+    } else {
+        m_samples[m_oldestSample] = s;
+        m_oldestSample = (m_oldestSample + 1) % SAMPLE_HISTORY_SIZE;
+    }
+}
+
+const DownloadState::Sample& DownloadState::getSample(int i) const
+{
+    return m_samples[(m_oldestSample + i) % m_samples.size()];
+}
+
+double DownloadState::getSmoothedSpeed() const
+{
+    const int n = m_samples.size();
+    if ( n < 2 )
+        return 0;
+
+    const Sample& last = getSample(n - 1);
+    int i = n - 2;
+    while ( i > 0 && secondsBetween(getSample(i).time, last.time) < SPEED_SMOOTHING_WINDOW )
+        --i;
+
+    const Sample& first = getSample(i);
+    const double dt = secondsBetween(first.time, last.time);
+    return dt > 0 ? std::max(0.0, last.completedBytes - first.completedBytes) / dt : 0;
+}
+
+double DownloadState::getEstimatedTimeLeft() const
+{
+    const double speed = getSmoothedSpeed();
+    if ( speed <= 0 || m_samples.isEmpty() )
+        return -1;
+
+    const double bytesLeft = m_totalBytes - getSample(m_samples.size() - 1).completedBytes;
+    return std::max(0.0, bytesLeft) / speed;
+}
+
+QString DownloadState::getEstimatedTimeLeftString() const
+{
+    const double t = getEstimatedTimeLeft();
+    if ( t < 0 || status != DOWNLOADING || timeSinceLastUpdate() > 2.0 )
+        return "--:--";
+
+    const qint64 seconds = qint64(t + 0.5);
+    const auto twoDigits = [](qint64 x) { return QString::number(x).rightJustified(2, '0'); };
+    const QString minSec = twoDigits(seconds / 60 % 60) + ":" + twoDigits(seconds % 60);
+    return seconds >= 3600
+         ? QString::number(seconds / 3600) + ":" + minSec
+         : minSec;
+}
+
+QVector<double> DownloadState::getSpeedHistory() const
+{
+    QVector<double> speeds;
+    for ( int i = 1; i < m_samples.size(); ++i ) {
+        const Sample& s0 = getSample(i - 1);
+        const Sample& s1 = getSample(i);
+        const double dt = secondsBetween(s0.time, s1.time);
+        speeds.append(dt > 0 ? std::max(0.0, s1.completedBytes - s0.completedBytes) / dt : 0);
+    }
+    return speeds;
 }
 
 double DownloadState::timeSinceLastUpdate() const
@@ -102,24 +193,43 @@ void DownloadState::changeState(Action action)
 namespace
 {
 
-kiwix::Downloader* createDownloader()
+const char PEER_DOWNLOAD_ID_PREFIX[] = "peer:";
+
+// Time allowed for hearing from the peers after startup before interrupted
+// peer transfers are resumed
+const int PEER_DISCOVERY_DELAY_MS = 6000;
+
+SettingsManager* getSettingsManager()
 {
-    try {
-        return new kiwix::Downloader(getDataDirectory().toStdString());
-    } catch (std::exception& e) {
-        QMessageBox::critical(nullptr, gt("error-downloader-window-title"),
-        gt("error-downloader-launch-message") + "<br><br>" + e.what());
-        return nullptr;
-    }
+    return KiwixApp::instance()->getSettingsManager();
+}
+
+QString peerTransferOffsetKey(const QString& bookId)
+{
+    return bookId + "/peerTransferOffset";
 }
 
 } // unnamed namespace
 
 DownloadManager::DownloadManager(const Library* lib)
     : mp_library(lib)
-    , mp_downloader(createDownloader())
 {
+    if ( getSettingsManager()->getPeerSharing() ) {
+        mp_peerShare = new PeerShare(mp_library, this);
+        if ( !mp_peerShare->start() ) {
+            delete mp_peerShare;
+            mp_peerShare = nullptr;
+        }
+    }
+
     restoreDownloads();
+
+    // Launching aria2c takes a while, so it is done in the download updater
+    // thread. It is not needed at all unless some downloads are to be
+    // resumed, or the user starts a new one (see addRequest()).
+    if ( !m_downloads.keys().isEmpty() ) {
+        QTimer::singleShot(0, this, &DownloadManager::startDownloadUpdaterThread);
+    }
 }
 
 DownloadManager::~DownloadManager()
@@ -136,15 +246,35 @@ DownloadManager::~DownloadManager()
     }
 }
 
-bool DownloadManager::downloadingFunctionalityAvailable() const
+// Runs in the download updater thread
+void DownloadManager::launchDownloader()
 {
-    return mp_downloader.get() != nullptr;
+    KIWIX_TRACE_SCOPE("DownloadManager::launchDownloader");
+    QElapsedTimer timer;
+    timer.start();
+    try {
+        mp_downloader.reset(new kiwix::Downloader(getDataDirectory().toStdString()));
+        m_downloaderStatus = DOWNLOADER_READY;
+        qInfo() << "aria2c launched in" << timer.elapsed() << "ms";
+    } catch (std::exception& e) {
+        m_downloaderStatus = DOWNLOADER_FAILED;
+        emit error(gt("error-downloader-window-title"),
+                   gt("error-downloader-launch-message") + "<br><br>" + e.what());
+    }
 }
 
 void DownloadManager::processDownloadActions()
 {
+   launchDownloader();
    while ( mp_downloadUpdaterThread != nullptr ) {
         const Request req = m_requestQueue.dequeue();
+        const bool downloaderReady = m_downloaderStatus == DOWNLOADER_READY;
+
+        // Without the downloader only START requests are handled (they
+        // fail with a proper error message)
+        if ( !downloaderReady && req.action != DownloadState::START )
+            continue;
+
         if ( !req.bookId.isEmpty() ) {
             switch ( req.action ) {
             case DownloadState::START:  startDownload(req.bookId);  break;
@@ -159,6 +289,11 @@ void DownloadManager::processDownloadActions()
 
 void DownloadManager::startDownloadUpdaterThread()
 {
+    if ( mp_downloadUpdaterThread )
+        return;
+
+    m_downloaderStatus = DOWNLOADER_STARTING;
+
     // so that DownloadInfo can be copied across threads
     qRegisterMetaType<DownloadInfo>("DownloadInfo");
 
@@ -170,9 +305,16 @@ void DownloadManager::startDownloadUpdaterThread()
 
     QTimer *timer = new QTimer(this);
     connect(timer, &QTimer::timeout, [this]() {
+        for ( const auto& bookId : m_peerTransfers.keys() ) {
+            updatePeerTransfer(bookId, QString());
+        }
+
         if ( m_requestQueue.isEmpty() ) {
             for ( const auto& bookId : m_downloads.keys() ) {
-                addRequest(DownloadState::UPDATE, bookId);
+                if ( !m_downloadsBeingPrepared.contains(bookId)
+                     && !m_peerTransfers.contains(bookId) ) {
+                    addRequest(DownloadState::UPDATE, bookId);
+                }
             }
         }
     });
@@ -183,9 +325,18 @@ void DownloadManager::restoreDownloads()
 {
     for ( const auto& bookId : mp_library->getBookIds() ) {
         const kiwix::Book& book = mp_library->getBookById(bookId);
-        if ( ! book.getDownloadId().empty() ) {
+        if ( isPeerDownloadId(book.getDownloadId()) ) {
+            m_downloads.set(bookId, std::make_shared<DownloadState>());
+            m_downloadsBeingPrepared.insert(bookId);
+            QTimer::singleShot(PEER_DISCOVERY_DELAY_MS, this, [=]() {
+                if ( m_downloadsBeingPrepared.contains(bookId) ) {
+                    prepareDownload(bookId);
+                }
+            });
+        } else if ( ! book.getDownloadId().empty() ) {
             const auto newDownload = std::make_shared<DownloadState>();
             m_downloads.set(bookId, newDownload);
+            startVerification(bookId);
         }
     }
 }
@@ -268,7 +419,7 @@ uint64_t getMaxFileSize(const QStorageInfo& storageInfo)
     return problematicFileSystems.value(fsType, virtuallyNoLimit);
 }
 
-void checkThatBookCanBeSaved(const kiwix::Book& book, QString targetDir)
+void checkThatBooksCanBeSaved(const QList<kiwix::Book>& books, QString targetDir, qint64 pendingBytes)
 {
     const QFileInfo targetDirInfo(targetDir);
     if ( !targetDirInfo.isDir() ) {
@@ -285,14 +436,31 @@ void checkThatBookCanBeSaved(const kiwix::Book& book, QString targetDir)
 
     QStorageInfo storage(targetDir);
     auto bytesAvailable = storage.bytesAvailable();
-    if (bytesAvailable == -1 || book.getSize() > (unsigned long long) bytesAvailable) {
-        throw KiwixAppError(gt("download-storage-error"),
-                            gt("download-storage-error-text"));
+    uint64_t bytesNeeded = pendingBytes;
+    for ( const auto& book : books ) {
+        bytesNeeded += book.getSize();
     }
 
-    if ( book.getSize() > getMaxFileSize(storage) ) {
-        throw KiwixAppError(gt("download-storage-error"),
-                            gt("download-exceeds-max-file-size"));
+    if (bytesAvailable == -1 || bytesNeeded > (unsigned long long) bytesAvailable) {
+        QString details = gt("download-storage-error-text");
+        if ( books.size() > 1 || pendingBytes > 0 ) {
+            details = gt("download-storage-error-aggregate-text")
+                      .replace("{{NEEDED}}", convertToUnits(bytesNeeded))
+                      .replace("{{PENDING}}", convertToUnits(pendingBytes))
+                      .replace("{{AVAILABLE}}", convertToUnits(std::max(bytesAvailable, qint64(0))));
+        }
+        throw KiwixAppError(gt("download-storage-error"), details);
+    }
+
+    const uint64_t maxFileSize = getMaxFileSize(storage);
+    for ( const auto& book : books ) {
+        if ( book.getSize() > maxFileSize ) {
+            QString details = gt("download-exceeds-max-file-size");
+            if ( books.size() > 1 ) {
+                details += "<br><br>" + QString::fromStdString(book.getTitle());
+            }
+            throw KiwixAppError(gt("download-storage-error"), details);
+        }
     }
 }
 
@@ -301,10 +469,45 @@ void checkThatBookCanBeSaved(const kiwix::Book& book, QString targetDir)
 
 void DownloadManager::checkThatBookCanBeDownloaded(const kiwix::Book& book, const QString& downloadDirPath)
 {
-    if ( ! DownloadManager::downloadingFunctionalityAvailable() )
+    checkThatBooksCanBeDownloaded({book}, downloadDirPath);
+}
+
+void DownloadManager::checkThatBooksCanBeDownloaded(const QList<kiwix::Book>& books, const QString& downloadDirPath)
+{
+    if ( getDownloaderStatus() == DOWNLOADER_FAILED )
         throwDownloadUnavailableError();
 
-    checkThatBookCanBeSaved(book, downloadDirPath);
+    QStringList bookIds;
+    for ( const auto& book : books ) {
+        bookIds.append(QString::fromStdString(book.getId()));
+    }
+
+    const QStorageInfo storage(downloadDirPath);
+    checkThatBooksCanBeSaved(books, downloadDirPath, getPendingDownloadBytes(storage, bookIds));
+}
+
+qint64 DownloadManager::getPendingDownloadBytes(const QStorageInfo& storage, const QStringList& excludedBookIds) const
+{
+    qint64 pendingBytes = 0;
+    for ( const auto& bookId : m_downloads.keys() ) {
+        if ( excludedBookIds.contains(bookId) )
+            continue;
+
+        try {
+            const auto& book = mp_library->getBookById(bookId);
+            const QFileInfo file(QString::fromStdString(mp_library->getBookFilePath(bookId)));
+            if ( QStorageInfo(file.absolutePath()).rootPath() != storage.rootPath() )
+                continue;
+
+            // Whatever has already been written (or preallocated by aria2)
+            // is already accounted for in the free space of the filesystem
+            const qint64 fileSize = file.exists() ? file.size() : 0;
+            pendingBytes += std::max(qint64(book.getSize()) - fileSize, qint64(0));
+        } catch ( const std::out_of_range& ) {
+            // The download has just completed or was cancelled
+        }
+    }
+    return pendingBytes;
 }
 
 std::string DownloadManager::startDownload(const kiwix::Book& book, const QString& downloadDirPath)
@@ -314,7 +517,8 @@ std::string DownloadManager::startDownload(const kiwix::Book& book, const QStrin
 
     std::string downloadId;
     try {
-        const auto d = mp_downloader->startDownload(url, downloadDirPath.toStdString());
+        const auto options = takeDownloadOptions(bookId);
+        const auto d = mp_downloader->startDownload(url, downloadDirPath.toStdString(), options);
         downloadId = d->getDid();
     } catch (std::exception& e) {
         throwDownloadUnavailableError();
@@ -325,8 +529,28 @@ std::string DownloadManager::startDownload(const kiwix::Book& book, const QStrin
 
 void DownloadManager::addRequest(Action action, QString bookId)
 {
+    startDownloadUpdaterThread();
+
     if ( action == DownloadState::START ) {
         m_downloads.set(bookId, std::make_shared<DownloadState>());
+        // The START request is enqueued once the mirrors have been probed
+        prepareDownload(bookId);
+        return;
+    }
+
+    if ( m_peerTransfers.contains(bookId) ) {
+        handlePeerTransferAction(action, bookId);
+        return;
+    }
+
+    if ( m_downloadsBeingPrepared.contains(bookId) ) {
+        // There is nothing to pause or resume yet
+        if ( action == DownloadState::CANCEL ) {
+            m_downloadsBeingPrepared.remove(bookId);
+            discardPeerTransferData(bookId);
+            emit downloadCancelled(bookId);
+        }
+        return;
     }
 
     if ( const auto downloadState = getDownloadState(bookId) ) {
@@ -400,3 +624,326 @@ void DownloadManager::removeDownload(QString bookId)
 {
     m_downloads.remove(bookId);
 }
+
+namespace
+{
+
+bool isMetalinkUrl(const QString& url)
+{
+    return url.endsWith(".meta4") || url.endsWith(".metalink");
+}
+
+// Only mirrors that are not much slower than the fastest one are worth
+// downloading from
+const double MAX_MIRROR_SCORE_RATIO = 2.0;
+
+const int MAX_DOWNLOAD_SOURCES = 4;
+
+const char MIRROR_STATISTICS_KEY[] = "mirrors/statistics";
+
+// Adds the results of a probing to the statistics of the mirror hosts
+void recordMirrorStatistics(const QList<MirrorProber::Result>& results)
+{
+    const auto settingsManager = getSettingsManager();
+    QVariantMap statistics = settingsManager->getSettings(MIRROR_STATISTICS_KEY).toMap();
+    const QString now = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    for ( const auto& r : results ) {
+        const QString host = r.mirror.url.host();
+        QVariantMap stats = statistics.value(host).toMap();
+        const bool failed = r.rtt < 0 || r.throughput <= 0;
+        const qint64 probes = stats.value("probes").toLongLong() + 1;
+        const qint64 failures = stats.value("failures").toLongLong() + (failed ? 1 : 0);
+        if ( !failed ) {
+            // Running averages of the successful probes
+            const qint64 successes = probes - failures;
+            const double rtt = stats.value("rtt").toDouble();
+            const double throughput = stats.value("throughput").toDouble();
+            stats["rtt"] = rtt + (r.rtt - rtt) / successes;
+            stats["throughput"] = throughput + (r.throughput - throughput) / successes;
+        }
+        stats["probes"] = probes;
+        stats["failures"] = failures;
+        stats["lastProbe"] = now;
+        statistics[host] = stats;
+    }
+    settingsManager->setSettings(MIRROR_STATISTICS_KEY, statistics);
+}
+
+kiwix::Downloader::Options getAria2Options(const MirrorProber::Ranking& ranking)
+{
+    kiwix::Downloader::Options options;
+    if ( ranking.isEmpty() )
+        return options;
+
+    const double bestScore = ranking.first().score();
+    QStringList locations;
+    int nbGoodMirrors = 0;
+    for ( const auto& r : ranking ) {
+        if ( r.score() > bestScore * MAX_MIRROR_SCORE_RATIO )
+            break;
+        ++nbGoodMirrors;
+        if ( !r.mirror.location.isEmpty() && !locations.contains(r.mirror.location) ) {
+            locations.append(r.mirror.location);
+        }
+    }
+
+    // Make aria2 prefer the mirrors found to be the fastest, while still
+    // adapting to their actual performance during the download
+    if ( !locations.isEmpty() ) {
+        options.push_back({"metalink-location", locations.join(",").toStdString()});
+    }
+    options.push_back({"uri-selector", "adaptive"});
+
+    // Fetch segments from several good mirrors in parallel
+    if ( nbGoodMirrors > 1 ) {
+        const int nbSources = std::min(nbGoodMirrors, MAX_DOWNLOAD_SOURCES);
+        options.push_back({"split", std::to_string(nbSources)});
+        options.push_back({"max-connection-per-server", "1"});
+    }
+    return options;
+}
+
+} // unnamed namespace
+
+void DownloadManager::fetchMetalink(const QString& url, std::function<void(Metalink)> callback)
+{
+    if ( !isMetalinkUrl(url) ) {
+        callback(Metalink());
+        return;
+    }
+
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
+                         QNetworkRequest::NoLessSafeRedirectPolicy);
+    const auto reply = m_networkManager.get(request);
+    connect(reply, &QNetworkReply::finished, this, [=]() {
+        reply->deleteLater();
+        if ( reply->error() != QNetworkReply::NoError ) {
+            qInfo() << "Cannot retrieve metalink" << url << ":" << reply->errorString();
+            callback(Metalink());
+            return;
+        }
+        callback(Metalink::parse(reply->readAll()));
+    });
+}
+
+void DownloadManager::prepareDownload(const QString& bookId, bool tryPeers)
+{
+    m_downloadsBeingPrepared.insert(bookId);
+    startVerification(bookId, [=](const Metalink& metalink) {
+        if ( !m_downloadsBeingPrepared.contains(bookId) )
+            return; // cancelled meanwhile
+
+        if ( tryPeers && startPeerTransfer(bookId, metalink) )
+            return;
+
+        // aria2 cannot make use of a partial file written by a peer transfer
+        discardPeerTransferData(bookId);
+
+        const auto prober = new MirrorProber(&m_networkManager, this);
+        connect(prober, &MirrorProber::finished, this, [=](MirrorProber::Ranking ranking) {
+            prober->deleteLater();
+            recordMirrorStatistics(prober->getResults());
+            setDownloadOptions(bookId, getAria2Options(ranking));
+            if ( m_downloadsBeingPrepared.remove(bookId) && getDownloadState(bookId) ) {
+                m_requestQueue.enqueue({DownloadState::START, bookId});
+            }
+        });
+        prober->probe(metalink.mirrors);
+    });
+}
+
+QVariantMap DownloadManager::getMirrorStatistics()
+{
+    return getSettingsManager()->getSettings(MIRROR_STATISTICS_KEY).toMap();
+}
+
+void DownloadManager::setDownloadOptions(const QString& bookId, const kiwix::Downloader::Options& options)
+{
+    const QMutexLocker threadSafetyGuarantee(&m_downloadOptionsMutex);
+    m_downloadOptions[bookId] = options;
+}
+
+kiwix::Downloader::Options DownloadManager::takeDownloadOptions(const QString& bookId)
+{
+    const QMutexLocker threadSafetyGuarantee(&m_downloadOptionsMutex);
+    return m_downloadOptions.take(bookId);
+}
+
+std::string DownloadManager::getPeerDownloadId(const QString& bookId)
+{
+    return PEER_DOWNLOAD_ID_PREFIX + bookId.toStdString();
+}
+
+bool DownloadManager::isPeerDownloadId(const std::string& downloadId)
+{
+    return downloadId.rfind(PEER_DOWNLOAD_ID_PREFIX, 0) == 0;
+}
+
+bool DownloadManager::startPeerTransfer(const QString& bookId, const Metalink& metalink)
+{
+    // Data received from peers can be trusted only if it can be checked
+    if ( !mp_peerShare || !metalink.hasPieceHashes() || metalink.fileName.isEmpty() )
+        return false;
+
+    const auto sources = mp_peerShare->getBookSources(bookId);
+    if ( sources.isEmpty() )
+        return false;
+
+    const auto& book = mp_library->getBookById(bookId);
+    const QFileInfo bookFile(QString::fromStdString(mp_library->getBookFilePath(bookId)));
+    const QString path = QDir(bookFile.absolutePath()).absoluteFilePath(metalink.fileName);
+    const bool resuming = isPeerDownloadId(book.getDownloadId());
+    if ( !resuming && QFileInfo::exists(path) )
+        return false; // don't overwrite files that aren't ours
+
+    const qint64 resumeOffset = resuming
+        ? getSettingsManager()->getSettings(peerTransferOffsetKey(bookId)).toLongLong()
+        : 0;
+    qInfo() << "Transferring book" << bookId << "from" << sources.size()
+            << "peer(s), starting at offset" << resumeOffset;
+
+    // Every piece is checked by the transfer itself
+    abandonVerification(bookId);
+    m_downloadsBeingPrepared.remove(bookId);
+
+    const auto transfer = new PeerTransfer(&m_networkManager, metalink, sources,
+                                           path, resumeOffset, this);
+    m_peerTransfers.insert(bookId, transfer);
+    connect(transfer, &PeerTransfer::progressed, this, [=](qint64 verifiedLength) {
+        getSettingsManager()->setSettings(peerTransferOffsetKey(bookId), verifiedLength);
+    });
+    connect(transfer, &PeerTransfer::finished, this, [=](bool success) {
+        peerTransferFinished(bookId, success);
+    });
+    emit peerTransferStarted(bookId, path);
+    transfer->start();
+    return true;
+}
+
+void DownloadManager::handlePeerTransferAction(Action action, const QString& bookId)
+{
+    PeerTransfer* const transfer = m_peerTransfers.value(bookId);
+    switch ( action ) {
+    case DownloadState::PAUSE:  transfer->pause();  break;
+    case DownloadState::RESUME: transfer->resume(); break;
+    case DownloadState::CANCEL:
+        m_peerTransfers.remove(bookId);
+        transfer->cancel();
+        transfer->deleteLater();
+        getSettingsManager()->deleteSettings(peerTransferOffsetKey(bookId));
+        emit downloadCancelled(bookId);
+        return;
+    default:
+        break;
+    }
+
+    if ( action != DownloadState::UPDATE ) {
+        if ( const auto downloadState = getDownloadState(bookId) ) {
+            downloadState->changeState(action);
+        }
+    }
+    updatePeerTransfer(bookId, QString());
+}
+
+// Reports the progress of a peer transfer the same way as the downloads
+// by aria2 are reported. A null status is derived from the transfer state.
+void DownloadManager::updatePeerTransfer(const QString& bookId, const QString& status)
+{
+    const PeerTransfer* const transfer = m_peerTransfers.value(bookId);
+    if ( !transfer )
+        return;
+
+    const auto updateRequestTime = std::chrono::steady_clock::now();
+    const QString actualStatus = !status.isNull() ? status
+                               : QString(transfer->isPaused() ? "paused" : "active");
+    const DownloadInfo downloadInfo = {
+             { "status"            , actualStatus },
+             { "completedLength"   , QString::number(transfer->getCompletedLength()) },
+             { "totalLength"       , QString::number(transfer->getTotalLength())     },
+             { "downloadSpeed"     , "0" },
+             { "path"              , transfer->getPath() },
+             { "updateRequestTime" , double(updateRequestTime.time_since_epoch().count()) }
+    };
+    emit downloadUpdated(bookId, downloadInfo);
+}
+
+void DownloadManager::peerTransferFinished(const QString& bookId, bool success)
+{
+    if ( success ) {
+        qInfo() << "Book" << bookId << "transferred from peers";
+        getSettingsManager()->deleteSettings(peerTransferOffsetKey(bookId));
+        updatePeerTransfer(bookId, "completed");
+        m_peerTransfers.take(bookId)->deleteLater();
+        return;
+    }
+
+    qInfo() << "Peers failed to provide book" << bookId
+            << "- downloading it from the internet";
+    m_peerTransfers.take(bookId)->deleteLater();
+    prepareDownload(bookId, false);
+}
+
+void DownloadManager::discardPeerTransferData(const QString& bookId)
+{
+    try {
+        const auto& book = mp_library->getBookById(bookId);
+        if ( !isPeerDownloadId(book.getDownloadId()) )
+            return;
+
+        QFile::remove(QString::fromStdString(mp_library->getBookFilePath(bookId)));
+        getSettingsManager()->deleteSettings(peerTransferOffsetKey(bookId));
+    } catch ( const std::out_of_range& ) {
+        // The book is gone
+    }
+}
+
+void DownloadManager::startVerification(const QString& bookId,
+                                        std::function<void(const Metalink&)> onMetalink)
+{
+    abandonVerification(bookId);
+
+    const auto url = QString::fromStdString(mp_library->getBookById(bookId).getUrl());
+    const auto verifier = new DownloadVerifier(this);
+    m_verifiers.insert(bookId, verifier);
+    connect(verifier, &DownloadVerifier::finished, this, [=](DownloadVerifier::Verdict verdict) {
+        if ( m_verifiers.value(bookId) == verifier ) {
+            m_verifiers.remove(bookId);
+        }
+        verifier->deleteLater();
+        emit downloadVerified(bookId, verdict);
+    });
+
+    const QPointer<DownloadVerifier> verifierPtr(verifier);
+    fetchMetalink(url, [=](Metalink metalink) {
+        if ( verifierPtr ) {
+            verifierPtr->setMetalink(metalink);
+        }
+        if ( onMetalink ) {
+            onMetalink(metalink);
+        }
+    });
+}
+
+void DownloadManager::verifyDownloadProgress(const QString& bookId, const DownloadInfo& downloadInfo)
+{
+    if ( const auto verifier = m_verifiers.value(bookId) ) {
+        verifier->checkProgress(downloadInfo["path"].toString(),
+                                downloadInfo["completedLength"].toLongLong());
+    }
+}
+
+void DownloadManager::verifyCompletedDownload(const QString& bookId, const QString& path)
+{
+    if ( const auto verifier = m_verifiers.value(bookId) ) {
+        verifier->finish(path);
+    }
+}
+
+void DownloadManager::abandonVerification(const QString& bookId)
+{
+    if ( const auto verifier = m_verifiers.take(bookId) ) {
+        verifier->disconnect(this);
+        verifier->deleteLater();
+    }
+}
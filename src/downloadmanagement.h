@@ -5,17 +5,27 @@
 #include <QMap>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QNetworkAccessManager>
+#include <QSet>
+#include <QStorageInfo>
 #include <QString>
 #include <QVariant>
+#include <QVector>
 #include <QWaitCondition>
 
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <queue>
 
 #include <kiwix/downloader.h>
 
 #include "library.h"
+#include "downloadverifier.h"
+#include "mirrorprober.h"
+#include "peershare.h"
+#include "peertransfer.h"
 
 typedef QMap<QString, QVariant> DownloadInfo;
 
@@ -83,6 +93,19 @@ public: // data
 public: // functions
     void update(const DownloadInfo& info);
     QString getDownloadSpeed() const;
+
+    // Download speed (in bytes/s) averaged over the last few seconds
+    double getSmoothedSpeed() const;
+
+    // Estimated time (in seconds) until the completion of the download.
+    // Negative if the download doesn't progress.
+    double getEstimatedTimeLeft() const;
+    QString getEstimatedTimeLeftString() const;
+
+    // Download speeds (in bytes/s) between consecutive progress samples,
+    // oldest first
+    QVector<double> getSpeedHistory() const;
+
     Status getStatus() const { return status; }
     void changeState(Action action);
     bool stateChangeHasBeenRequested() const
@@ -96,10 +119,29 @@ public: // functions
     // time in seconds since last update
     double timeSinceLastUpdate() const;
 
+private: // types
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    struct Sample
+    {
+        TimePoint time;
+        double    completedBytes;
+    };
+
+private: // functions
+    void addSample(const Sample& s);
+    const Sample& getSample(int i) const; // i = 0 is the oldest sample
+
 private: // data
     Status status = UNKNOWN;
     QString downloadSpeed;
-    std::chrono::steady_clock::time_point lastUpdated;
+    TimePoint lastUpdated;
+
+    // Ring buffer of the most recent progress samples
+    QVector<Sample> m_samples;
+    int m_oldestSample = 0;
+
+    double m_totalBytes = 0;
 };
 
 class DownloadManager : public QObject
@@ -110,44 +152,67 @@ public: // types
     typedef std::shared_ptr<DownloadState> DownloadStatePtr;
     typedef DownloadState::Action Action;
 
+    // State of aria2c, which is launched in the download updater thread
+    enum DownloaderStatus
+    {
+        DOWNLOADER_NOT_STARTED,
+        DOWNLOADER_STARTING,
+        DOWNLOADER_READY,
+        DOWNLOADER_FAILED
+    };
+
 private:
     // BookId -> DownloadState map
+    //
+    // The map is published as an immutable snapshot so that readers (most
+    // notably the GUI thread, on every repaint of the download column) never
+    // wait for a lock. Writers (that are rare) publish a modified copy.
     class Downloads
     {
     private:
         typedef QMap<QString, DownloadStatePtr> ImplType;
+        typedef std::shared_ptr<const ImplType> Snapshot;
 
     public:
+        Downloads() : impl(std::make_shared<const ImplType>()) {}
+
         void set(const QString& id, DownloadStatePtr d) {
-            const QMutexLocker threadSafetyGuarantee(&mutex);
-            impl[id] = d;
+            const QMutexLocker writersGuard(&writeMutex);
+            const auto newImpl = std::make_shared<ImplType>(*snapshot());
+            (*newImpl)[id] = d;
+            std::atomic_store(&impl, Snapshot(newImpl));
         }
 
         DownloadStatePtr value(const QString& id) const {
-            const QMutexLocker threadSafetyGuarantee(&mutex);
-            return impl.value(id);
+            return snapshot()->value(id);
         }
 
         QList<QString> keys() const {
-            const QMutexLocker threadSafetyGuarantee(&mutex);
-            return impl.keys();
+            return snapshot()->keys();
         }
 
         void remove(const QString& id) {
-            const QMutexLocker threadSafetyGuarantee(&mutex);
-            impl.remove(id);
+            const QMutexLocker writersGuard(&writeMutex);
+            const auto newImpl = std::make_shared<ImplType>(*snapshot());
+            newImpl->remove(id);
+            std::atomic_store(&impl, Snapshot(newImpl));
         }
 
     private:
-        ImplType impl;
-        mutable QMutex mutex;
+        Snapshot snapshot() const { return std::atomic_load(&impl); }
+
+    private:
+        Snapshot impl;
+        QMutex writeMutex;
     };
 
 public: // functions
     explicit DownloadManager(const Library* lib);
     virtual ~DownloadManager();
 
-    bool downloadingFunctionalityAvailable() const;
+    // Downloads can be requested unless the status is DOWNLOADER_FAILED (the
+    // requests made before aria2c is ready wait for it)
+    DownloaderStatus getDownloaderStatus() const { return m_downloaderStatus; }
 
     void startDownloadUpdaterThread();
 
@@ -160,6 +225,11 @@ public: // functions
     // successful download
     void checkThatBookCanBeDownloaded(const kiwix::Book& book, const QString& downloadDirPath);
 
+    // Same as above for several books to be downloaded together. The storage
+    // needed by all of them (and by the downloads in progress on the same
+    // filesystem) is checked in aggregate.
+    void checkThatBooksCanBeDownloaded(const QList<kiwix::Book>& books, const QString& downloadDirPath);
+
     void removeDownload(QString bookId);
 
     DownloadStatePtr getDownloadState(QString bookId) const
@@ -167,11 +237,36 @@ public: // functions
         return m_downloads.value(bookId);
     }
 
+    // The functions below deal with the verification of the integrity of
+    // downloaded files against the checksums published in their metalinks.
+    // They must be called from the main (GUI) thread.
+    void startVerification(const QString& bookId,
+                           std::function<void(const Metalink&)> onMetalink = nullptr);
+    void verifyDownloadProgress(const QString& bookId, const DownloadInfo& downloadInfo);
+    void verifyCompletedDownload(const QString& bookId, const QString& path);
+    void abandonVerification(const QString& bookId);
+    bool isBeingVerified(const QString& bookId) const { return m_verifiers.contains(bookId); }
+
+    // Books transferred from peers on the local network (rather than
+    // downloaded by aria2) are recorded in the library with a special
+    // download id
+    static std::string getPeerDownloadId(const QString& bookId);
+    static bool isPeerDownloadId(const std::string& downloadId);
+
+    // Results of the probes of the mirrors (see MirrorProber) made before
+    // the downloads, aggregated per host and kept in the settings so that the
+    // performance of the mirrors can be followed over time: host -> {probes,
+    // failures, rtt (mean, in seconds), throughput (mean, in bytes/s),
+    // lastProbe (ISO 8601 date)}
+    static QVariantMap getMirrorStatistics();
+
 signals:
     void error(QString errSummary, QString errDetails);
     void downloadUpdated(QString bookId, const DownloadInfo& );
     void downloadCancelled(QString bookId);
     void downloadDisappeared(QString bookId);
+    void downloadVerified(QString bookId, DownloadVerifier::Verdict verdict);
+    void peerTransferStarted(QString bookId, QString path);
 
 protected:
     // returns the download id
@@ -191,6 +286,28 @@ private: // types
     typedef ThreadSafePriorityQueue<Request> RequestQueue;
 
 private: // functions
+    // Amount of data that the downloads in progress (except those of the
+    // specified books) still have to write to the given filesystem
+    qint64 getPendingDownloadBytes(const QStorageInfo& storage, const QStringList& excludedBookIds) const;
+
+    // Retrieves the metalink (if any) behind a download URL. An invalid
+    // Metalink is passed to the callback on failure.
+    void fetchMetalink(const QString& url, std::function<void(Metalink)> callback);
+
+    // Transfers the book from peers on the local network if possible.
+    // Otherwise probes the mirrors of the book before enqueuing its download.
+    void prepareDownload(const QString& bookId, bool tryPeers = true);
+    void setDownloadOptions(const QString& bookId, const kiwix::Downloader::Options& options);
+    kiwix::Downloader::Options takeDownloadOptions(const QString& bookId);
+
+    // The functions below must be called from the main (GUI) thread
+    bool startPeerTransfer(const QString& bookId, const Metalink& metalink);
+    void handlePeerTransferAction(Action action, const QString& bookId);
+    void updatePeerTransfer(const QString& bookId, const QString& status);
+    void peerTransferFinished(const QString& bookId, bool success);
+    void discardPeerTransferData(const QString& bookId);
+
+    void launchDownloader();
     void processDownloadActions();
     virtual void startDownload(QString bookId) = 0;
     void pauseDownload(const QString& bookId);
@@ -200,10 +317,25 @@ private: // functions
 
 private: // data
     const Library* const     mp_library;
-    const std::unique_ptr<kiwix::Downloader> mp_downloader;
+    // Created (and accessed only) in the download updater thread
+    std::unique_ptr<kiwix::Downloader> mp_downloader;
+    std::atomic<DownloaderStatus> m_downloaderStatus{DOWNLOADER_NOT_STARTED};
     Downloads                m_downloads;
     QThread*                 mp_downloadUpdaterThread = nullptr;
     RequestQueue             m_requestQueue;
+    QNetworkAccessManager    m_networkManager;
+    QMap<QString, DownloadVerifier*> m_verifiers;
+    PeerShare*               mp_peerShare = nullptr;
+    QMap<QString, PeerTransfer*> m_peerTransfers;
+
+    // Downloads for which a metalink is being fetched and mirrors probed
+    // (aria2 doesn't know about them yet)
+    QSet<QString>            m_downloadsBeingPrepared;
+
+    // Options for aria2 computed by prepareDownload() and consumed by
+    // startDownload() in the download updater thread
+    QMap<QString, kiwix::Downloader::Options> m_downloadOptions;
+    QMutex                   m_downloadOptionsMutex;
 };
 
 #endif // DOWNLOADMANAGEMENT_H
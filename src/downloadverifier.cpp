@@ -0,0 +1,198 @@
+#include "downloadverifier.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <limits>
+
+namespace
+{
+
+// Bounds of the amount of data hashed per progress check. Each check tries to
+// hash twice the amount of data downloaded since the previous one so that the
+// verification keeps up with the download.
+const qint64 MIN_CHECK_BUDGET = 8 * 1024 * 1024;
+const qint64 MAX_CHECK_BUDGET = 256 * 1024 * 1024;
+
+const qint64 READ_CHUNK_SIZE = 1024 * 1024;
+
+typedef QPair<int, QByteArray> PieceAndHash;
+
+QByteArray hashFileRegion(QFile& file, qint64 offset, qint64 length,
+                          QCryptographicHash::Algorithm algo)
+{
+    QCryptographicHash hash(algo);
+    if ( !file.seek(offset) )
+        return QByteArray();
+
+    while ( length > 0 ) {
+        const QByteArray data = file.read(qMin(length, READ_CHUNK_SIZE));
+        if ( data.isEmpty() )
+            break;
+        hash.addData(data);
+        length -= data.size();
+    }
+    return hash.result().toHex();
+}
+
+} // unnamed namespace
+
+DownloadVerifier::DownloadVerifier(QObject* parent)
+    : QObject(parent)
+{
+    connect(&m_checkWatcher, &QFutureWatcher<PieceCheckResult>::finished,
+            this, &DownloadVerifier::onCheckFinished);
+}
+
+void DownloadVerifier::setMetalink(Metalink m)
+{
+    // Fall back to the whole-file digest (treated as a single piece
+    // that is checked only once the download completes)
+    if ( m.isValid() && !m.hasPieceHashes() && !m.sha256.isEmpty() ) {
+        m.pieceHashType = "sha-256";
+        m.pieceLength = qMax(m.size, qint64(1));
+        m.pieceHashes = { m.sha256 };
+    }
+
+    const qint64 expectedNbPieces = m.pieceLength > 0
+        ? (m.size + m.pieceLength - 1) / m.pieceLength
+        : -1;
+    if ( !m.hasPieceHashes() || expectedNbPieces != m.pieceHashes.size() ) {
+        setVerdict(UNVERIFIABLE);
+        return;
+    }
+
+    m_metalink = m;
+    m_metalinkReady = true;
+    m_pieceIsVerified = QVector<bool>(m.pieceHashes.size(), false);
+    if ( m_completed && !m_checkWatcher.isRunning() ) {
+        finish(m_completedPath);
+    }
+}
+
+double DownloadVerifier::verifiedFraction() const
+{
+    return m_pieceIsVerified.isEmpty()
+         ? 0.0
+         : double(m_nbVerifiedPieces) / m_pieceIsVerified.size();
+}
+
+QVector<int> DownloadVerifier::selectPiecesToCheck(qint64 budget) const
+{
+    const int n = m_pieceIsVerified.size();
+    QVector<int> pieces;
+    QVector<bool> selected(n, false);
+    qint64 total = 0;
+    const auto select = [&](int i) {
+        if ( m_pieceIsVerified[i] || selected[i] || total >= budget )
+            return;
+        if ( m_metalink.pieceLength > budget && !m_completed )
+            return;
+        selected[i] = true;
+        pieces.append(i);
+        total += m_metalink.pieceLength;
+    };
+
+    // The download is likely to be progressing right after the pieces
+    // already known to be good (aria2 fills its segments sequentially)
+    for ( int i = 1; i < n; ++i ) {
+        if ( m_pieceIsVerified[i-1] ) {
+            select(i);
+        }
+    }
+
+    // The remaining budget is spent scanning the file in a round-robin way
+    // so that the starting points of new segments are discovered too
+    for ( int k = 0; k < n && total < budget; ++k ) {
+        select((m_scanCursor + k) % n);
+    }
+    return pieces;
+}
+
+void DownloadVerifier::runCheck(const QString& path, const QVector<int>& pieces)
+{
+    QVector<PieceAndHash> work;
+    for ( const int i : pieces ) {
+        work.append({i, m_metalink.pieceHashes[i]});
+    }
+
+    const qint64 pieceLength = m_metalink.pieceLength;
+    const auto algo = m_metalink.pieceHashAlgorithm();
+    m_checkWatcher.setFuture(QtConcurrent::run([=]() {
+        PieceCheckResult r;
+        QFile file(path);
+        const bool fileIsOpen = file.open(QIODevice::ReadOnly);
+        for ( const auto& p : work ) {
+            const bool ok = fileIsOpen
+                && hashFileRegion(file, p.first * pieceLength, pieceLength, algo) == p.second;
+            (ok ? r.good : r.bad).append(p.first);
+        }
+        return r;
+    }));
+}
+
+void DownloadVerifier::checkProgress(const QString& path, qint64 completedLength)
+{
+    if ( !m_metalinkReady || m_completed || m_checkWatcher.isRunning() || path.isEmpty() )
+        return;
+
+    const qint64 downloadedSinceLastCheck = completedLength - m_lastCompletedLength;
+    if ( downloadedSinceLastCheck <= 0 )
+        return;
+
+    const auto pieces = selectPiecesToCheck(qBound(MIN_CHECK_BUDGET, 2 * downloadedSinceLastCheck, MAX_CHECK_BUDGET));
+    if ( pieces.isEmpty() )
+        return;
+
+    m_lastCompletedLength = completedLength;
+    m_scanCursor = (pieces.last() + 1) % m_pieceIsVerified.size();
+    runCheck(path, pieces);
+}
+
+void DownloadVerifier::finish(const QString& path)
+{
+    m_completed = true;
+    m_completedPath = path;
+    if ( m_verdict != PENDING || !m_metalinkReady || m_checkWatcher.isRunning() )
+        return;
+
+    if ( QFileInfo(path).size() != m_metalink.size ) {
+        setVerdict(FAILED);
+        return;
+    }
+
+    const auto pieces = selectPiecesToCheck(std::numeric_limits<qint64>::max());
+    if ( pieces.isEmpty() ) {
+        setVerdict(VERIFIED);
+    } else {
+        m_finalCheckIsRunning = true;
+        runCheck(path, pieces);
+    }
+}
+
+void DownloadVerifier::onCheckFinished()
+{
+    const PieceCheckResult r = m_checkWatcher.result();
+    for ( const int i : r.good ) {
+        if ( !m_pieceIsVerified[i] ) {
+            m_pieceIsVerified[i] = true;
+            ++m_nbVerifiedPieces;
+        }
+    }
+
+    if ( m_finalCheckIsRunning ) {
+        m_finalCheckIsRunning = false;
+        setVerdict(r.bad.isEmpty() ? VERIFIED : FAILED);
+    } else if ( m_completed && m_verdict == PENDING ) {
+        // The download completed while a progress check was running
+        finish(m_completedPath);
+    }
+}
+
+void DownloadVerifier::setVerdict(Verdict v)
+{
+    m_verdict = v;
+    emit finished(v);
+}
@@ -0,0 +1,94 @@
+#ifndef DOWNLOADVERIFIER_H
+#define DOWNLOADVERIFIER_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QVector>
+
+#include "metalink.h"
+
+// Checks the integrity of a file being downloaded against the piece hashes
+// published in its metalink.
+//
+// Pieces are hashed in a worker thread while the download is in progress
+// (starting from the ones adjacent to already verified data, where aria2 is
+// most likely to be writing), so that when the download completes only the
+// few pieces that landed since the last check remain to be read. A piece
+// that doesn't match during the download simply hasn't been written yet and
+// is retried later; a mismatch after completion means corruption.
+//
+// All public functions must be called from the thread owning the object.
+class DownloadVerifier : public QObject
+{
+    Q_OBJECT
+
+public: // types
+    enum Verdict
+    {
+        // The verification is still in progress
+        PENDING,
+
+        // All pieces of the file matched their hashes
+        VERIFIED,
+
+        // The file doesn't match the hashes published for it
+        FAILED,
+
+        // No (usable) checksums are available for the file
+        UNVERIFIABLE
+    };
+
+public: // functions
+    explicit DownloadVerifier(QObject* parent = nullptr);
+
+    // Provides the metalink describing the file. A metalink without usable
+    // checksums results in an UNVERIFIABLE verdict.
+    void setMetalink(Metalink m);
+
+    // Hashes (in the background) a batch of pieces that are likely to have
+    // been written since the previous call
+    void checkProgress(const QString& path, qint64 completedLength);
+
+    // Verifies the remaining pieces of the completed file. The result is
+    // reported via the finished() signal.
+    void finish(const QString& path);
+
+    Verdict verdict() const { return m_verdict; }
+    double verifiedFraction() const;
+
+signals:
+    void finished(DownloadVerifier::Verdict verdict);
+
+private: // types
+    struct PieceCheckResult
+    {
+        QVector<int> good;
+        QVector<int> bad;
+    };
+
+private: // functions
+    QVector<int> selectPiecesToCheck(qint64 budget) const;
+    void runCheck(const QString& path, const QVector<int>& pieces);
+    void onCheckFinished();
+    void setVerdict(Verdict v);
+
+private: // data
+    Metalink      m_metalink;
+    bool          m_metalinkReady = false;
+    Verdict       m_verdict = PENDING;
+
+    QVector<bool> m_pieceIsVerified;
+    int           m_nbVerifiedPieces = 0;
+
+    // Position from which the next scan for not yet verified pieces starts
+    int           m_scanCursor = 0;
+
+    qint64        m_lastCompletedLength = 0;
+    bool          m_completed = false;
+    bool          m_finalCheckIsRunning = false;
+    QString       m_completedPath;
+
+    QFutureWatcher<PieceCheckResult> m_checkWatcher;
+};
+
+#endif // DOWNLOADVERIFIER_H
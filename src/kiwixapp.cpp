@@ -1,4 +1,6 @@
 #include "kiwixapp.h"
+#include "servertuning.h"
+#include "tracing.h"
 #include "zim/error.h"
 #include "zim/version.h"
 #include "kiwix/tools.h"
@@ -15,6 +17,8 @@
 #include <QPrintDialog>
 #include <thread>
 #include <QMessageBox>
+#include <QSignalBlocker>
+#include <QDebug>
 #if defined(Q_OS_WIN) && QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 #include <QtPlatformHeaders\QWindowsWindowFunctions>
 #endif
@@ -31,11 +35,14 @@ KiwixApp::KiwixApp(int& argc, char *argv[])
       m_libraryDirectory(findLibraryDirectory()),
       m_library(m_libraryDirectory),
       mp_manager(nullptr),
+      mp_titleIndex(nullptr),
+      mp_sidecarIndexer(nullptr),
       mp_mainWindow(nullptr),
       mp_nameMapper(std::make_shared<kiwix::UpdatableNameMapper>(m_library.getKiwixLibrary(), false)),
       m_server(m_library.getKiwixLibrary(), mp_nameMapper),
       mp_session(nullptr)
 {
+    Tracing::Scope translationScope("Translations");
     try {
         m_translation.setTranslation(QLocale());
     } catch (std::exception& e) {
@@ -50,7 +57,9 @@ KiwixApp::KiwixApp(int& argc, char *argv[])
 #endif
     loadAndInstallTranslations(m_qtTranslator, "qt", path);
     loadAndInstallTranslations(m_appTranslator, "kiwix-desktop", ":/i18n/");
+    translationScope.end();
 
+    KIWIX_TRACE_SCOPE("Fonts");
     QFontDatabase::addApplicationFont(":/fonts/Selawik/selawkb.ttf");
     QFontDatabase::addApplicationFont(":/fonts/Selawik/selawkl.ttf");
     QFontDatabase::addApplicationFont(":/fonts/Selawik/selawksb.ttf");
@@ -67,8 +76,22 @@ void KiwixApp::loadAndInstallTranslations(QTranslator& translator, const QString
 
 void KiwixApp::init()
 {
+    KIWIX_TRACE_SCOPE("KiwixApp::init");
+    const int cacheSize = ServerTuning::getCacheSize(m_settingsManager);
+    qInfo() << "Content cache:" << (cacheSize ? QString::number(cacheSize) + " MiB" : QString("default size"));
+    m_contentCache.setBudget(qint64(cacheSize) * 1024 * 1024);
+    Tracing::Scope contentManagerScope("ContentManager");
     mp_manager = new ContentManager(&m_library);
+    contentManagerScope.end();
     mp_manager->setLocal(!m_library.getBookIds().isEmpty());
+    if (m_settingsManager.getMultiZimSuggestions() == "library") {
+        const auto titleIndexDir = QDir(getDataDirectory()).filePath("title-index");
+        mp_titleIndex = new LibraryTitleIndex(&m_library, titleIndexDir);
+    }
+    if (m_settingsManager.getSidecarIndexing()) {
+        const auto sidecarIndexDir = QDir(getDataDirectory()).filePath("fulltext-index");
+        mp_sidecarIndexer = new SidecarIndexer(&m_library, sidecarIndexDir);
+    }
 
     auto icon = QIcon();
     icon.addFile(":/icons/kiwix-app-icons-square.svg");
@@ -79,7 +102,9 @@ void KiwixApp::init()
     setStyleSheet(parseStyleFromFile(":/css/style.css"));
 
     createActions();
+    Tracing::Scope mainWindowScope("MainWindow");
     mp_mainWindow = new MainWindow;
+    mainWindowScope.end();
     getTabWidget()->setContentManagerView(mp_manager->getView());
     const auto newTabAction = getAction(KiwixApp::NewTabAction);
     getTabWidget()->setNewTabButton(newTabAction);
@@ -113,6 +138,7 @@ void KiwixApp::init()
 
 void KiwixApp::setupDirectoryMonitoring()
 {
+    KIWIX_TRACE_SCOPE("KiwixApp::setupDirectoryMonitoring");
     QString monitorDir = m_settingsManager.getMonitorDir();
     QString downloadDir = m_settingsManager.getDownloadDir();
     auto dirList = QSet<QString>({monitorDir, downloadDir});
@@ -121,6 +147,8 @@ void KiwixApp::setupDirectoryMonitoring()
 
 KiwixApp::~KiwixApp()
 {
+    m_serverProxy.stop();
+    m_serverProcess.stop();
     m_server.stop();
     if (mp_manager) {
         delete mp_manager;
@@ -128,6 +156,13 @@ KiwixApp::~KiwixApp()
     if (mp_mainWindow) {
         delete mp_mainWindow;
     }
+    // After the main window, as the search bar and the views use them
+    if (mp_titleIndex) {
+        delete mp_titleIndex;
+    }
+    if (mp_sidecarIndexer) {
+        delete mp_sidecarIndexer;
+    }
 }
 
 void KiwixApp::newTab()
@@ -172,25 +207,37 @@ QString KiwixApp::findLibraryDirectory()
 
 void KiwixApp::restoreTabs()
 {
+    KIWIX_TRACE_SCOPE("KiwixApp::restoreTabs");
     /* Place session file in our global library path */
     QDir dir(m_libraryDirectory);
-    mp_session = new QSettings(dir.filePath("kiwix-desktop.session"),
-                               QSettings::defaultFormat(), this);
+    mp_session = new SettingsStore(dir.filePath("kiwix-desktop.session"),
+                                   QSettings::defaultFormat(), this);
     QStringList tabsToOpen = mp_session->value("reopenTabList").toStringList();
+    QStringList tabTitles = mp_session->value("reopenTabTitles").toStringList();
 
     /* Restart a new session to prevent duplicate records in openURL */
     saveListOfOpenTabs();
     if (m_settingsManager.getReopenTab())
     {
-      for (const auto &zimUrl : tabsToOpen)
+      for (int i = 0; i < tabsToOpen.size(); ++i)
       {
-        if (zimUrl == "SettingsTab")
+        const auto &zimUrl = tabsToOpen[i];
+        if (zimUrl == "SettingsTab") {
+          /* The settings tab is opened next to the current tab. Make the
+             last tab current without displaying it (which would load it). */
+          {
+            QSignalBlocker blocker(getTabWidget());
+            getTabWidget()->setCurrentIndex(getTabWidget()->realTabCount() - 1);
+          }
           getTabWidget()->openOrSwitchToSettingsTab();
+        }
         else if (zimUrl.isEmpty())
-          getTabWidget()->createNewTab(true, true);
+          getTabWidget()->createNewTab(false, false);
         else
-          openUrl(QUrl(zimUrl));
+          /* Pages are only loaded when their tab is displayed */
+          getTabWidget()->createNewTab(false, false)->setDeferredUrl(QUrl(zimUrl), tabTitles.value(i));
       }
+      saveListOfOpenTabs();
     }
 
     /* Restore current tab index. */
@@ -206,6 +253,10 @@ QString gt(const QString &key) {
     return KiwixApp::instance()->getText(key);
 }
 
+QString gt(TranslationKey key) {
+    return KiwixApp::instance()->getText(key);
+}
+
 void KiwixApp::openZimFile(const QString &zimfile)
 {
     QString _zimfile;
@@ -468,6 +519,8 @@ void KiwixApp::createActions()
     CREATE_ACTION(RequestFeatureAction, gt("request-a-feature"));
     HIDE_ACTION(RequestFeatureAction);
 
+    CREATE_ACTION(DiagnosticsAction, gt("diagnostics"));
+
     CREATE_ACTION(AboutAction, gt("about-kiwix"));
 
     CREATE_ACTION_ICON_SHORTCUT(SettingAction, "settings", gt("settings"),  QKeySequence(Qt::Key_F12));
@@ -478,6 +531,7 @@ void KiwixApp::createActions()
 }
 
 void KiwixApp::postInit() {
+    KIWIX_TRACE_SCOPE("KiwixApp::postInit");
     connect(getTabWidget(), &TabBar::tabDisplayed,
             this, &KiwixApp::handleItemsState);
     emit(m_library.booksChanged());
@@ -529,6 +583,7 @@ QString KiwixApp::parseStyleFromFile(QString filePath)
 
 void KiwixApp::saveListOfOpenTabs()
 {
+  mp_session->setValue("reopenTabTitles", getTabWidget()->getTabTitles());
   return mp_session->setValue("reopenTabList", getTabWidget()->getTabUrls());
 }
 
@@ -540,6 +595,7 @@ void KiwixApp::saveWindowState()
 
 void KiwixApp::restoreWindowState()
 {
+  KIWIX_TRACE_SCOPE("KiwixApp::restoreWindowState");
   getMainWindow()->restoreGeometry(mp_session->value("geometry").toByteArray());
   getMainWindow()->restoreState(mp_session->value("windowState").toByteArray());
 }
@@ -2,11 +2,17 @@
 #define KIWIXAPP_H
 
 #include "library.h"
+#include "contentcache.h"
 #include "contentmanager.h"
+#include "librarytitleindex.h"
+#include "navigationmetrics.h"
+#include "sidecarindexer.h"
 #include "tabbar.h"
 #include "mainwindow.h"
 #include "kiwix/downloader.h"
 #include <kiwix/kiwixserve.h>
+#include "servermetricsproxy.h"
+#include "serverprocess.h"
 #include "kprofile.h"
 #include "settingsmanager.h"
 #include "translation.h"
@@ -66,6 +72,7 @@ public:
         ImportReadingListAction,
         ScrollPreviousTabAction,
         ScrollNextTabAction,
+        DiagnosticsAction,
         MAX_ACTION
     };
 
@@ -82,12 +89,23 @@ public:
     Library* getLibrary() { return &m_library; }
     MainWindow* getMainWindow() { return mp_mainWindow; }
     ContentManager* getContentManager() { return mp_manager; }
+    // nullptr unless suggestions come from the whole library
+    LibraryTitleIndex* getTitleIndex() { return mp_titleIndex; }
+    // nullptr if the books without fulltext index are not indexed
+    SidecarIndexer* getSidecarIndexer() { return mp_sidecarIndexer; }
+    NavigationMetrics* getNavigationMetrics() { return &m_navigationMetrics; }
+    ContentCache* getContentCache() { return &m_contentCache; }
     TabBar* getTabWidget() { return getMainWindow()->getTabBar(); }
     QAction* getAction(Actions action);
     QString getLibraryDirectory() { return m_libraryDirectory; };
     kiwix::Server* getLocalServer() { return &m_server; }
+    // The clients of the local server connect to it through this proxy
+    ServerMetricsProxy* getLocalServerProxy() { return &m_serverProxy; }
+    // Used instead of the local server when it runs out of process
+    ServerProcess* getLocalServerProcess() { return &m_serverProcess; }
     SettingsManager* getSettingsManager() { return &m_settingsManager; };
     QString getText(const QString &key) { return m_translation.getText(key); };
+    QString getText(TranslationKey key) { return m_translation.getText(key); };
     void setMonitorDir(const QString &dir);
     bool isCurrentArticleBookmarked();
     QString parseStyleFromFile(QString filePath);
@@ -119,12 +137,18 @@ private:
     QString m_libraryDirectory;
     Library m_library;
     ContentManager* mp_manager;
+    LibraryTitleIndex* mp_titleIndex;
+    SidecarIndexer* mp_sidecarIndexer;
     MainWindow* mp_mainWindow;
     QErrorMessage* mp_errorDialog;
     std::shared_ptr<kiwix::UpdatableNameMapper> mp_nameMapper;
     kiwix::Server m_server;
+    ServerMetricsProxy m_serverProxy;
+    ServerProcess m_serverProcess;
     Translation m_translation;
-    QSettings* mp_session;
+    SettingsStore* mp_session;
+    NavigationMetrics m_navigationMetrics;
+    ContentCache m_contentCache;
 
     QAction*     mpa_actions[MAX_ACTION];
 
@@ -135,6 +159,8 @@ private:
 };
 
 QString gt(const QString &key);
+// Faster, for the texts used when painting or building menus
+QString gt(TranslationKey key);
 #define _STR(...) # __VA_ARGS__
 #define STR(X) _STR(X)
 static QString version = STR(VERSION);
@@ -1,5 +1,6 @@
 #include "library.h"
 #include "kiwixapp.h"
+#include "tracing.h"
 
 #include <kiwix/manager.h>
 #include <kiwix/tools.h>
@@ -31,6 +32,7 @@ Library::Library(const QString& libraryDirectory)
   : mp_library(kiwix::Library::create()),
     m_libraryDirectory(libraryDirectory)
 {
+    KIWIX_TRACE_SCOPE("Library::Library");
     auto manager = kiwix::Manager(LibraryManipulator(this));
     manager.readFile(kiwix::appendToDirectory(m_libraryDirectory.toStdString(),"library.xml"), false);
     manager.readBookmarkFile(kiwix::appendToDirectory(m_libraryDirectory.toStdString(),"library.bookmarks.xml"));
@@ -73,6 +75,28 @@ std::shared_ptr<zim::Searcher> Library::getSearcher(const QString &zimId)
     return mp_library->getSearcherById(zimId.toStdString());
 }
 
+Library::SearchResults Library::search(const QString& zimId, const std::string& pattern, int start, int pageLength)
+{
+    SearchResults searchResults;
+    const auto sidecarIndexer = KiwixApp::instance()->getSidecarIndexer();
+    if ( sidecarIndexer && sidecarIndexer->hasIndex(zimId) ) {
+        auto sidecarSearchResults = sidecarIndexer->search(zimId, QString::fromStdString(pattern), start, pageLength);
+        searchResults.estimatedMatchCount = sidecarSearchResults.estimatedMatches;
+        searchResults.sidecarResults = sidecarSearchResults.results;
+        return searchResults;
+    }
+
+    std::unique_ptr<zim::Search> search;
+    try {
+        search.reset(new zim::Search(getSearcher(zimId)->search(pattern)));
+    } catch (const std::exception& e) {
+        throw std::out_of_range("Book " + zimId.toStdString() + " cannot be searched: " + e.what());
+    }
+    searchResults.estimatedMatchCount = search->getEstimatedMatches();
+    searchResults.results = std::make_shared<zim::SearchResultSet>(search->getResults(start, pageLength));
+    return searchResults;
+}
+
 QIcon Library::getBookIcon(const QString &zimId)
 {
     static QIcon defaultIcon = QIcon(":/icons/placeholder-icon.png");
@@ -184,6 +208,13 @@ void Library::updateBookBeingDownloaded(const QString& bookId, const QString& bo
     }
 }
 
+void Library::addBooksBeingDownloaded(const QList<kiwix::Book>& books, QString downloadDir)
+{
+    for ( const auto& book : books ) {
+        addBookBeingDownloaded(book, downloadDir);
+    }
+}
+
 bool Library::isBeingDownloadedByUs(QString path) const
 {
     const auto fakePath = pseudoPathOfAFileBeingDownloaded(path.toStdString());
@@ -209,6 +240,7 @@ void Library::removeBookmark(const QString &zimId, const QString &url)
 
 void Library::save()
 {
+    KIWIX_TRACE_SCOPE("Library::save");
     mp_library->writeToFile(kiwix::appendToDirectory(m_libraryDirectory.toStdString(),"library.xml"));
     mp_library->writeBookmarksToFile(kiwix::appendToDirectory(m_libraryDirectory.toStdString(), "library.bookmarks.xml"));
 }
@@ -1,6 +1,8 @@
 #ifndef LIBRARY_H
 #define LIBRARY_H
 
+#include "sidecarindexer.h"
+
 #include <kiwix/book.h>
 #include <kiwix/library.h>
 #include <zim/archive.h>
@@ -29,11 +31,24 @@ class Library : public QObject
 public:
     typedef QSet<QString> QStringSet;
 
+    struct SearchResults
+    {
+        int estimatedMatchCount = 0;
+        // Results of the fulltext index embedded in the book, if it has one
+        std::shared_ptr<zim::SearchResultSet> results;
+        // Otherwise, results of the index built by the SidecarIndexer
+        QList<SidecarIndexer::SearchResult> sidecarResults;
+    };
+
     Library(const QString& libraryDirectory);
     virtual ~Library();
     QString openBookFromPath(const QString& zimPath);
     std::shared_ptr<zim::Archive> getArchive(const QString& zimId);
     std::shared_ptr<zim::Searcher> getSearcher(const QString& zimId);
+    // Searches the fulltext index embedded in the book or, for the books
+    // without one, the index built by the SidecarIndexer. Throws
+    // std::out_of_range if the book cannot be searched.
+    SearchResults search(const QString& zimId, const std::string& pattern, int start, int pageLength);
     QIcon getBookIcon(const QString& zimId);
     QStringList getBookIds() const;
     QStringList listBookIds(const kiwix::Filter& filter, kiwix::supportedListSortBy sortBy, bool ascending) const;
@@ -41,6 +56,7 @@ public:
     QStringSet getLibraryZimsFromDir(QString dir) const;
     void addBookToLibrary(kiwix::Book& book);
     void addBookBeingDownloaded(const kiwix::Book& book, QString downloadDir);
+    void addBooksBeingDownloaded(const QList<kiwix::Book>& books, QString downloadDir);
     bool isBeingDownloadedByUs(QString path) const;
     void updateBookBeingDownloaded(const QString& bookId, const QString& bookPath);
     std::string getBookFilePath(const QString& bookId) const;
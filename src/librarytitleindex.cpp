@@ -0,0 +1,168 @@
+#include "librarytitleindex.h"
+#include "library.h"
+
+#include <zim/archive.h>
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+
+namespace
+{
+
+// The library changes in bursts (e.g. when a directory is scanned)
+const int UPDATE_DELAY_MS = 5000;
+
+const QString INDEX_SUFFIX = ".idx";
+
+} // unnamed namespace
+
+LibraryTitleIndex::LibraryTitleIndex(Library* library, const QString& directory, QObject* parent)
+    : QObject(parent)
+    , mp_library(library)
+    , m_directory(directory)
+{
+    QDir().mkpath(m_directory);
+
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(UPDATE_DELAY_MS);
+    connect(&m_updateTimer, &QTimer::timeout, this, &LibraryTitleIndex::update);
+    connect(library, &Library::booksChanged, &m_updateTimer, QOverload<>::of(&QTimer::start));
+    connect(&m_buildWatcher, &QFutureWatcher<void>::finished, this, [=]() {
+        if ( m_updatePending ) {
+            m_updatePending = false;
+            update();
+        }
+    });
+    m_updateTimer.start();
+}
+
+LibraryTitleIndex::~LibraryTitleIndex()
+{
+    m_stopping = true;
+    m_buildWatcher.waitForFinished();
+}
+
+QString LibraryTitleIndex::getIndexPath(const QString& bookId) const
+{
+    return QDir(m_directory).filePath(bookId + INDEX_SUFFIX);
+}
+
+void LibraryTitleIndex::update()
+{
+    if ( m_buildWatcher.isRunning() ) {
+        m_updatePending = true;
+        return;
+    }
+
+    QSet<QString> libraryBookIds;
+    QSet<QString> availableBookIds;
+    QList<BookAndPath> booksToIndex;
+    {
+        QMutexLocker locker(&m_indexesMutex);
+        for ( const auto& bookId : mp_library->getBookIds() ) {
+            libraryBookIds.insert(bookId);
+            const auto& book = mp_library->getBookById(bookId);
+            if ( !book.getDownloadId().empty() || !book.isPathValid() )
+                continue;
+
+            availableBookIds.insert(bookId);
+            if ( !m_indexes.contains(bookId) ) {
+                booksToIndex.append({bookId, QString::fromStdString(book.getPath())});
+            }
+        }
+
+        // Books whose file is (temporarily) unavailable keep their index file
+        for ( const auto& bookId : m_indexes.keys() ) {
+            if ( !availableBookIds.contains(bookId) ) {
+                m_indexes.remove(bookId);
+            }
+        }
+    }
+
+    for ( const auto& fileInfo : QDir(m_directory).entryInfoList({"*" + INDEX_SUFFIX}, QDir::Files) ) {
+        if ( !libraryBookIds.contains(fileInfo.completeBaseName()) ) {
+            QFile::remove(fileInfo.absoluteFilePath());
+        }
+    }
+
+    if ( !booksToIndex.isEmpty() ) {
+        m_buildWatcher.setFuture(QtConcurrent::run([=]() {
+            buildIndexes(booksToIndex);
+        }));
+    }
+}
+
+void LibraryTitleIndex::buildIndexes(const QList<BookAndPath>& books)
+{
+    // Indexing must not slow down the rest of the application
+    QThread* const thread = QThread::currentThread();
+    const auto priority = thread->priority();
+    thread->setPriority(QThread::LowestPriority);
+
+    for ( const auto& book : books ) {
+        if ( m_stopping )
+            break;
+
+        const QString indexPath = getIndexPath(book.first);
+        std::unique_ptr<TitleIndex> index = TitleIndex::open(indexPath);
+        if ( !index ) {
+            try {
+                QElapsedTimer timer;
+                timer.start();
+                const zim::Archive archive(book.second.toStdString());
+                if ( !TitleIndex::build(archive, indexPath, m_stopping) )
+                    continue;
+                index = TitleIndex::open(indexPath);
+                qInfo() << "Indexed the titles of" << book.second << "in" << timer.elapsed() << "ms";
+            } catch ( const std::exception& e ) {
+                qWarning() << "Cannot index the titles of" << book.second << ":" << e.what();
+                continue;
+            }
+        }
+
+        if ( index ) {
+            addIndex(book.first, std::move(index));
+        }
+    }
+
+    thread->setPriority(priority);
+}
+
+void LibraryTitleIndex::addIndex(const QString& bookId, TitleIndexPtr index)
+{
+    QMutexLocker locker(&m_indexesMutex);
+    m_indexes.insert(bookId, index);
+}
+
+QList<LibraryTitleIndex::Match> LibraryTitleIndex::lookup(const QString& prefix, int maxResults,
+                                                          const QString& preferredBookId) const
+{
+    QMap<QString, TitleIndexPtr> indexes;
+    {
+        QMutexLocker locker(&m_indexesMutex);
+        indexes = m_indexes;
+    }
+
+    QList<Match> matches;
+    for ( auto it = indexes.constBegin(); it != indexes.constEnd(); ++it ) {
+        for ( const auto& entry : it.value()->lookup(prefix, maxResults) ) {
+            matches.append({it.key(), entry.title, entry.path});
+        }
+    }
+
+    std::stable_sort(matches.begin(), matches.end(), [&](const Match& a, const Match& b) {
+        const int cmp = a.title.compare(b.title, Qt::CaseInsensitive);
+        if ( cmp != 0 )
+            return cmp < 0;
+        return a.bookId == preferredBookId && b.bookId != preferredBookId;
+    });
+    return matches.mid(0, maxResults);
+}
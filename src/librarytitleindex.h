@@ -0,0 +1,75 @@
+#ifndef LIBRARYTITLEINDEX_H
+#define LIBRARYTITLEINDEX_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QTimer>
+
+#include <atomic>
+#include <memory>
+
+#include "titleindex.h"
+
+class Library;
+
+// Title index of all the local books, so that an article can be found without
+// knowing which book holds it (and without opening any archive).
+//
+// Every book has its own TitleIndex file in the title-index directory of the
+// data directory. The files are built in the background, one book at a time,
+// and are added or deleted as books come and go from the library.
+class LibraryTitleIndex : public QObject
+{
+    Q_OBJECT
+
+public: // types
+    struct Match
+    {
+        QString bookId;
+        QString title;
+        QString path;
+    };
+
+public: // functions
+    LibraryTitleIndex(Library* library, const QString& directory, QObject* parent = nullptr);
+    ~LibraryTitleIndex();
+
+    // Thread-safe. Titles starting with the prefix in all the indexed books,
+    // in title order (the titles of preferredBookId coming first among equal
+    // titles).
+    QList<Match> lookup(const QString& prefix, int maxResults,
+                        const QString& preferredBookId = QString()) const;
+
+public slots:
+    // Brings the index files in line with the library (done shortly after
+    // the library changes)
+    void update();
+
+private: // types
+    typedef QPair<QString, QString> BookAndPath;
+    typedef std::shared_ptr<const TitleIndex> TitleIndexPtr;
+
+private: // functions
+    QString getIndexPath(const QString& bookId) const;
+    void buildIndexes(const QList<BookAndPath>& books);
+    void addIndex(const QString& bookId, TitleIndexPtr index);
+
+private: // data
+    Library* const mp_library;
+    const QString  m_directory;
+
+    mutable QMutex m_indexesMutex;
+    QMap<QString, TitleIndexPtr> m_indexes;
+
+    QTimer                m_updateTimer;
+    QFutureWatcher<void>  m_buildWatcher;
+    bool                  m_updatePending = false;
+    std::atomic<bool>     m_stopping{false};
+};
+
+#endif // LIBRARYTITLEINDEX_H
@@ -1,11 +1,47 @@
 #include "localkiwixserver.h"
 #include "ui_localkiwixserver.h"
 #include "kiwixapp.h"
+#include "servertuning.h"
 #include <kiwix/tools.h>
+#include <QDebug>
 #include <QDesktopServices>
+#include <QDir>
 #include <QMessageBox>
 #include <thread>
 
+namespace
+{
+
+const int STATS_UPDATE_INTERVAL_MS = 1000;
+
+// Address under which the clients on the local network can reach the server
+QString getPublicAddress(bool ipv4, bool ipv6)
+{
+    const auto interfacesMap = kiwix::getNetworkInterfacesIPv4Or6();
+    for (const auto &interfacePair : interfacesMap) {
+        const QString address = QString::fromStdString(interfacePair.second.addr);
+        if (ipv4 && !address.isEmpty() && !address.startsWith("127.") && !address.startsWith("169.254"))
+            return address;
+    }
+    for (const auto &interfacePair : interfacesMap) {
+        const QString address = QString::fromStdString(interfacePair.second.addr6);
+        if (ipv6 && !address.isEmpty() && address != "::1" && !address.startsWith("fe80"))
+            return address;
+    }
+    return ipv4 ? "127.0.0.1" : "::1";
+}
+
+QString formatRankedList(const ServerMetrics::RankedList& list)
+{
+    QStringList entries;
+    for (const auto &entry : list) {
+        entries.append(entry.first + " (" + QString::number(entry.second) + ")");
+    }
+    return entries.join(", ");
+}
+
+} // unnamed namespace
+
 LocalKiwixServer::LocalKiwixServer(QWidget *parent) :
     QDialog(parent),
     ui(new Ui::LocalKiwixServer)
@@ -21,6 +57,7 @@ LocalKiwixServer::LocalKiwixServer(QWidget *parent) :
     setStyleSheet(style);
 
     mp_server = KiwixApp::instance()->getLocalServer();
+    mp_proxy = KiwixApp::instance()->getLocalServerProxy();
     m_port = KiwixApp::instance()->getSettingsManager()->getKiwixServerPort();
 
     connect(ui->KiwixServerButton, SIGNAL(clicked()), this, SLOT(runOrStopServer()));
@@ -68,6 +105,12 @@ LocalKiwixServer::LocalKiwixServer(QWidget *parent) :
     ui->OpenInBrowserButton->setText(gt("open-in-browser"));
     ui->KiwixServerButton->setText(gt("start-kiwix-server"));
     ui->closeButton->setText(gt("close"));
+    ui->ServerStats->hide();
+
+    m_statsTimer.setInterval(STATS_UPDATE_INTERVAL_MS);
+    connect(&m_statsTimer, &QTimer::timeout, this, &LocalKiwixServer::updateStats);
+    connect(KiwixApp::instance()->getLocalServerProcess(), &ServerProcess::started,
+            this, &LocalKiwixServer::onServerProcessStarted);
 }
 
 LocalKiwixServer::~LocalKiwixServer()
@@ -86,49 +129,190 @@ void LocalKiwixServer::openInBrowser()
 
 void LocalKiwixServer::runOrStopServer()
 {
+    if (m_starting)
+        return;
+
     if (!m_active) {
         auto settingsManager = KiwixApp::instance()->getSettingsManager();
         m_port = ui->PortChooser->text().toInt();
-        mp_server->setPort(m_port);
         settingsManager->setKiwixServerPort(m_port);
-        mp_server->setIpMode(kiwix::IpMode::AUTO);
-        mp_server->setAddress("");
+        kiwix::IpMode ipMode = kiwix::IpMode::AUTO;
+        std::string serverAddress;
         if (ui->IpChooser->currentText() == gt("all_ips")) {
-            mp_server->setIpMode(kiwix::IpMode::ALL);
+            m_listenAddress = QHostAddress::Any;
+            ipMode = kiwix::IpMode::ALL;
+            m_ipAddress = getPublicAddress(true, true);
             settingsManager->setKiwixServerIpAddress("all_ips");
         } else if (ui->IpChooser->currentText() == gt("ipv4")) {
-            mp_server->setIpMode(kiwix::IpMode::IPV4);
+            m_listenAddress = QHostAddress::AnyIPv4;
+            ipMode = kiwix::IpMode::IPV4;
+            m_ipAddress = getPublicAddress(true, false);
             settingsManager->setKiwixServerIpAddress("ipv4");
         } else if (ui->IpChooser->currentText() == gt("ipv6")) {
-            mp_server->setIpMode(kiwix::IpMode::IPV6);
+            m_listenAddress = QHostAddress::AnyIPv6;
+            ipMode = kiwix::IpMode::IPV6;
+            m_ipAddress = getPublicAddress(false, true);
             settingsManager->setKiwixServerIpAddress("ipv6");
         } else {
-            mp_server->setAddress(ui->IpChooser->currentText().toStdString());
+            m_listenAddress = QHostAddress(ui->IpChooser->currentText());
+            serverAddress = ui->IpChooser->currentText().toStdString();
+            m_ipAddress = ui->IpChooser->currentText();
             settingsManager->setKiwixServerIpAddress(ui->IpChooser->currentText());
         }
+
+        const auto tuning = ServerTuning::getApplied(*settingsManager);
+        qInfo() << "Local server:" << tuning.toString();
+        m_outOfProcess = settingsManager->getKiwixServerOutOfProcess();
+        // Measuring the load takes the proxy, the server itself then only
+        // listens on the loopback interface
+        m_measured = settingsManager->getKiwixServerMetrics();
+        quint16 serverPort = m_port;
+        int ipConnectionLimit = tuning.ipConnectionLimit;
+        if (m_measured) {
+            m_backendPort = ServerMetricsProxy::findFreeLoopbackPort();
+            if (m_backendPort == 0) {
+                QMessageBox messageBox;
+                messageBox.critical(0,gt("error-title"),gt("error-launch-server-message"));
+                return;
+            }
+            mp_proxy->setConnectionLimits(tuning.connectionLimit, tuning.ipConnectionLimit);
+            serverPort = m_backendPort;
+            ipMode = kiwix::IpMode::AUTO;
+            serverAddress = "127.0.0.1";
+            // The proxy is the only client
+            ipConnectionLimit = 0;
+        }
+
+        if (m_outOfProcess) {
+            const auto app = KiwixApp::instance();
+            // The child process serves the books of library.xml. It is ready
+            // once it says so (see onServerProcessStarted()).
+            app->getLibrary()->save();
+            const QString libraryPath = QDir(app->getLibraryDirectory()).filePath("library.xml");
+            app->getLocalServerProcess()->start(libraryPath, QString::fromStdString(serverAddress),
+                                                ipMode, serverPort, ipConnectionLimit);
+            m_starting = true;
+            ui->KiwixServerButton->setEnabled(false);
+            ui->KiwixServerButton->setText(gt("starting-kiwix-server"));
+            return;
+        }
+
+        mp_server->setPort(serverPort);
+        mp_server->setIpMode(ipMode);
+        mp_server->setAddress(serverAddress);
+        mp_server->setIpConnectionLimit(ipConnectionLimit);
+        if (tuning.threads > 0) {
+            mp_server->setNbThreads(tuning.threads);
+        }
         if (!mp_server->start()) {
             QMessageBox messageBox;
             messageBox.critical(0,gt("error-title"),gt("error-launch-server-message"));
             return;
         }
-        kiwix::IpAddress serverAddress = mp_server->getAddress();
-        m_ipAddress = QString::fromStdString(serverAddress.addr.empty() ? serverAddress.addr6 : serverAddress.addr);
-        if (m_ipAddress.contains(':')) m_ipAddress = "[" + m_ipAddress + "]";
-        ui->IpAddress->setText("http://" + m_ipAddress + ":" + QString::number(m_port));
-        ui->IpAddress->setReadOnly(true);
-        m_active = true;
+        serverStarted();
     } else {
-        mp_server->stop();
+        if (m_measured) {
+            mp_proxy->stop();
+        }
+        stopServer();
         m_active = false;
+        updateState();
+    }
+}
+
+void LocalKiwixServer::onServerProcessStarted(bool success)
+{
+    if (!m_starting)
+        return;
+
+    m_starting = false;
+    ui->KiwixServerButton->setEnabled(true);
+    if (!success) {
+        updateState();
+        QMessageBox messageBox;
+        messageBox.critical(0,gt("error-title"),gt("error-launch-server-message"));
+        return;
+    }
+    serverStarted();
+}
+
+void LocalKiwixServer::serverStarted()
+{
+    if (m_measured) {
+        const auto metricsPort = KiwixApp::instance()->getSettingsManager()->getKiwixServerMetricsPort();
+        if (!mp_proxy->start(m_listenAddress, m_port, m_backendPort, metricsPort)) {
+            stopServer();
+            updateState();
+            QMessageBox messageBox;
+            messageBox.critical(0,gt("error-title"),gt("error-launch-server-message"));
+            return;
+        }
     }
+    if (m_ipAddress.contains(':')) m_ipAddress = "[" + m_ipAddress + "]";
+    ui->IpAddress->setText("http://" + m_ipAddress + ":" + QString::number(m_port));
+    ui->IpAddress->setReadOnly(true);
+    m_active = true;
+    updateState();
+}
 
+void LocalKiwixServer::updateState()
+{
     if (m_active) {
         ui->KiwixServerButton->setText(gt("stop-kiwix-server"));
         ui->KiwixServerText->setText(gt("kiwix-server-running-message"));
         ui->stackedWidget->setCurrentIndex(1);
+        if (m_measured) {
+            updateStats();
+            m_statsTimer.start();
+        }
     } else {
+        m_statsTimer.stop();
+        ui->ServerStats->hide();
         ui->KiwixServerButton->setText(gt("start-kiwix-server"));
         ui->KiwixServerText->setText(gt("kiwix-server-description"));
         ui->stackedWidget->setCurrentIndex(0);
     }
 }
+
+void LocalKiwixServer::stopServer()
+{
+    if (m_outOfProcess) {
+        KiwixApp::instance()->getLocalServerProcess()->stop();
+    } else {
+        mp_server->stop();
+    }
+}
+
+void LocalKiwixServer::updateStats()
+{
+    if (!isVisible())
+        return;
+
+    auto metrics = mp_proxy->getMetrics();
+    const auto formatLatency = [&](double fraction) {
+        const qint64 latency = metrics.getLatencyPercentile(fraction);
+        return latency < 0 ? QString("-") : QString::number(latency / 1000.0, 'f', 1);
+    };
+    QStringList lines;
+    lines.append(gt("server-stats-load")
+                 .replace("{{RATE}}", QString::number(metrics.getRequestRate(), 'f', 1))
+                 .replace("{{CONNECTIONS}}", QString::number(metrics.getActiveConnections()))
+                 .replace("{{BYTES}}", QString::fromStdString(kiwix::beautifyFileSize(metrics.getBytesServed()))));
+    lines.append(gt("server-stats-latency")
+                 .replace("{{P50}}", formatLatency(0.5))
+                 .replace("{{P95}}", formatLatency(0.95)));
+    const auto topBooks = metrics.getTopBooks(3);
+    if (!topBooks.isEmpty()) {
+        lines.append(gt("server-stats-top-books").replace("{{BOOKS}}", formatRankedList(topBooks)));
+    }
+    const auto topArticles = metrics.getTopArticles(3);
+    if (!topArticles.isEmpty()) {
+        lines.append(gt("server-stats-top-articles").replace("{{ARTICLES}}", formatRankedList(topArticles)));
+    }
+    if (const quint16 metricsPort = mp_proxy->getMetricsPort()) {
+        lines.append(gt("server-metrics-endpoint")
+                     .replace("{{URL}}", "http://127.0.0.1:" + QString::number(metricsPort) + "/metrics"));
+    }
+    ui->ServerStats->setText(lines.join("\n"));
+    ui->ServerStats->show();
+}
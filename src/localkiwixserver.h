@@ -2,12 +2,16 @@
 #define LOCALKIWIXSERVER_H
 
 #include <QDialog>
+#include <QHostAddress>
+#include <QTimer>
 #include <kiwix/server.h>
 
 namespace Ui {
 class LocalKiwixServer;
 }
 
+class ServerMetricsProxy;
+
 class LocalKiwixServer : public QDialog
 {
     Q_OBJECT
@@ -21,11 +25,26 @@ public slots:
     void openInBrowser();
 
 private:
+    void onServerProcessStarted(bool success);
+    void serverStarted();
+    void stopServer();
+    void updateState();
+    void updateStats();
+
     Ui::LocalKiwixServer *ui;
     kiwix::Server* mp_server;
+    ServerMetricsProxy* mp_proxy;
+    QTimer m_statsTimer;
     bool m_active = false;
+    // Waiting for the child process to be ready
+    bool m_starting = false;
+    bool m_outOfProcess = false;
+    // Whether the server runs behind the proxy measuring its load
+    bool m_measured = false;
     QString m_ipAddress;
+    QHostAddress m_listenAddress;
     int m_port;
+    quint16 m_backendPort = 0;
 };
 
 #endif // LOCALKIWIXSERVER_H
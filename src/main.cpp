@@ -1,6 +1,8 @@
 #include <QtGlobal>
 
 #include "kiwixapp.h"
+#include "serverprocess.h"
+#include "tracing.h"
 
 #include <QCommandLineParser>
 #include <iostream>
@@ -14,6 +16,11 @@
 #endif
 int main(int argc, char *argv[])
 {
+    // Child process of the local Kiwix server (see ServerProcess)
+    if (ServerProcess::isServerCommandLine(argc, argv)) {
+        return runLibraryServer(argc, argv);
+    }
+
 // Small hack to make QtWebEngine works with AppImage.
 // See https://github.com/probonopd/linuxdeployqt/issues/554
     if (qEnvironmentVariableIsSet("APPIMAGE")) {
@@ -35,12 +42,18 @@ int main(int argc, char *argv[])
     QWebEngineUrlScheme scheme("zim");
     QWebEngineUrlScheme::registerScheme(scheme);
 #endif
+    Tracing::initialize(argc, argv);
+    Tracing::Scope constructionScope("KiwixApp::KiwixApp");
     KiwixApp a(argc, argv);
+    constructionScope.end();
 
     QCommandLineParser parser;
     parser.setApplicationDescription(QStringLiteral("The Kiwix Desktop is a viewer/manager of ZIM files for GNU/Linux and Microsoft Windows OSes."));
     parser.addHelpOption();
     parser.addPositionalArgument("zimfile", "The zim file");
+    // Handled by Tracing::initialize()
+    parser.addOption(QCommandLineOption(Tracing::getCommandLineOption(),
+                                        "Write a trace of the startup in Chrome trace format.", "path"));
 
     // Set version string
     std::ostringstream versions;
@@ -66,5 +79,7 @@ int main(int argc, char *argv[])
     for (QString zimfile : positionalArguments) {
         a.openZimFile(zimfile);
     }
-    return a.exec();
+    const int result = a.exec();
+    Tracing::stop();
+    return result;
 }
@@ -55,6 +55,7 @@ MainMenu::MainMenu(QWidget *parent) :
     m_helpMenu.ADD_ACTION(FeedbackAction);
     m_helpMenu.ADD_ACTION(ReportBugAction);
     m_helpMenu.ADD_ACTION(RequestFeatureAction);
+    m_helpMenu.ADD_ACTION(DiagnosticsAction);
     m_helpMenu.ADD_ACTION(AboutAction);
     addMenu(&m_helpMenu);
 
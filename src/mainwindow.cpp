@@ -14,6 +14,7 @@ MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     mp_ui(new Ui::MainWindow),
     mp_about(new About(this)),
+    mp_diagnostics(new DiagnosticsDialog(this)),
     mp_localKiwixServer(new LocalKiwixServer(this))
 {
     QWidget::setAttribute(Qt::WA_AlwaysShowToolTips);
@@ -47,6 +48,8 @@ MainWindow::MainWindow(QWidget *parent) :
             this, &MainWindow::readingListToggled);
     connect(app->getAction(KiwixApp::AboutAction), &QAction::triggered,
             mp_about, &QDialog::show);
+    connect(app->getAction(KiwixApp::DiagnosticsAction), &QAction::triggered,
+            mp_diagnostics, &QDialog::show);
     connect(app->getAction(KiwixApp::DonateAction), &QAction::triggered,
             this, [=]() { QDesktopServices::openUrl(QUrl("https://donate.kiwix.org")); });
     connect(app->getAction(KiwixApp::KiwixServeAction), &QAction::triggered,
@@ -7,6 +7,7 @@
 #include "tabbar.h"
 #include "topwidget.h"
 #include "about.h"
+#include "diagnosticsdialog.h"
 #include "contentmanagerside.h"
 #include "localkiwixserver.h"
 
@@ -42,6 +43,7 @@ private slots:
 private:
     Ui::MainWindow *mp_ui;
     About     *mp_about;
+    DiagnosticsDialog *mp_diagnostics;
     LocalKiwixServer *mp_localKiwixServer;
 };
 
@@ -0,0 +1,91 @@
+#include "metalink.h"
+
+#include <QXmlStreamReader>
+
+namespace
+{
+
+bool isSupportedHashType(const QString& type)
+{
+    return type == "sha-1" || type == "sha-256" || type == "md5";
+}
+
+} // unnamed namespace
+
+bool Metalink::hasPieceHashes() const
+{
+    return pieceLength > 0
+        && !pieceHashes.isEmpty()
+        && isSupportedHashType(pieceHashType);
+}
+
+QCryptographicHash::Algorithm Metalink::pieceHashAlgorithm() const
+{
+    if ( pieceHashType == "sha-256" ) return QCryptographicHash::Sha256;
+    if ( pieceHashType == "md5" )     return QCryptographicHash::Md5;
+    return QCryptographicHash::Sha1;
+}
+
+Metalink Metalink::parse(const QByteArray& xml)
+{
+    Metalink m;
+    QXmlStreamReader reader(xml);
+    bool insideFile = false;
+    bool insidePieces = false;
+    bool fileSeen = false;
+
+    while ( !reader.atEnd() ) {
+        reader.readNext();
+        if ( reader.isEndElement() ) {
+            if ( reader.name() == QLatin1String("file") ) {
+                insideFile = false;
+            } else if ( reader.name() == QLatin1String("pieces") ) {
+                insidePieces = false;
+            }
+            continue;
+        }
+
+        if ( !reader.isStartElement() )
+            continue;
+
+        const auto attrs = reader.attributes();
+        if ( reader.name() == QLatin1String("file") ) {
+            // Only the first file of the metalink is of interest
+            if ( fileSeen )
+                break;
+            fileSeen = insideFile = true;
+            m.fileName = attrs.value("name").toString();
+        } else if ( !insideFile ) {
+            continue;
+        } else if ( reader.name() == QLatin1String("size") ) {
+            m.size = reader.readElementText().trimmed().toLongLong();
+        } else if ( reader.name() == QLatin1String("pieces") ) {
+            insidePieces = true;
+            m.pieceLength = attrs.value("length").toLongLong();
+            m.pieceHashType = attrs.value("type").toString();
+        } else if ( reader.name() == QLatin1String("hash") ) {
+            const auto type = attrs.value("type").toString();
+            const auto digest = reader.readElementText().trimmed().toLatin1().toLower();
+            if ( insidePieces ) {
+                m.pieceHashes.append(digest);
+            } else if ( type == "sha-256" ) {
+                m.sha256 = digest;
+            }
+        } else if ( reader.name() == QLatin1String("url") ) {
+            Mirror mirror;
+            mirror.location = attrs.value("location").toString().toLower();
+            if ( attrs.hasAttribute("priority") ) {
+                mirror.priority = attrs.value("priority").toInt();
+            }
+            mirror.url = QUrl(reader.readElementText().trimmed());
+            if ( mirror.url.isValid() ) {
+                m.mirrors.append(mirror);
+            }
+        }
+    }
+
+    if ( reader.hasError() || !fileSeen ) {
+        return Metalink();
+    }
+    return m;
+}
@@ -0,0 +1,47 @@
+#ifndef METALINK_H
+#define METALINK_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QList>
+#include <QString>
+#include <QUrl>
+
+// The subset of a Metalink 4 (RFC 5854) document describing a single file
+// that is relevant to us (the metalinks published for ZIM files always
+// describe exactly one file).
+struct Metalink
+{
+    struct Mirror
+    {
+        QUrl    url;
+
+        // ISO 3166-1 alpha-2 country code of the mirror (may be empty)
+        QString location;
+
+        // Lower values denote more preferred mirrors
+        int     priority = 999999;
+    };
+
+    QString fileName;
+    qint64  size = -1;
+
+    // Hex-encoded digest of the whole file (empty if not provided)
+    QByteArray sha256;
+
+    // Hex-encoded digests of consecutive pieces of the file
+    QString pieceHashType;
+    qint64  pieceLength = 0;
+    QList<QByteArray> pieceHashes;
+
+    QList<Mirror> mirrors;
+
+    bool isValid() const { return size >= 0; }
+    bool hasPieceHashes() const;
+    QCryptographicHash::Algorithm pieceHashAlgorithm() const;
+
+    // Returns an invalid Metalink if the document cannot be parsed
+    static Metalink parse(const QByteArray& xml);
+};
+
+#endif // METALINK_H
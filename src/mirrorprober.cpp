@@ -0,0 +1,193 @@
+#include "mirrorprober.h"
+
+#include <QDebug>
+#include <QNetworkRequest>
+
+#include <algorithm>
+
+namespace
+{
+
+const int MAX_PROBED_MIRRORS = 8;
+
+// Time allowed for probing all mirrors
+const int PROBING_DEADLINE_MS = 5000;
+
+// Amount of data downloaded from each mirror to estimate its throughput
+const qint64 THROUGHPUT_SAMPLE_SIZE = 256 * 1024;
+
+// Size of the data chunks fetched by aria2 from a single mirror, used for
+// weighting latency against throughput in the ranking of mirrors
+const double SEGMENT_SIZE = 1024 * 1024;
+
+QNetworkRequest createProbeRequest(const QUrl& url)
+{
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
+                         QNetworkRequest::NoLessSafeRedirectPolicy);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+                         QNetworkRequest::AlwaysNetwork);
+    return request;
+}
+
+} // unnamed namespace
+
+double MirrorProber::Result::score() const
+{
+    return rtt + SEGMENT_SIZE / throughput;
+}
+
+MirrorProber::MirrorProber(QNetworkAccessManager* nam, QObject* parent)
+    : QObject(parent)
+    , mp_networkManager(nam)
+{
+    m_deadline.setSingleShot(true);
+    connect(&m_deadline, &QTimer::timeout, this, &MirrorProber::finish);
+}
+
+void MirrorProber::probe(QList<Metalink::Mirror> mirrors)
+{
+    std::stable_sort(mirrors.begin(), mirrors.end(),
+                     [](const Metalink::Mirror& a, const Metalink::Mirror& b) {
+                         return a.priority < b.priority;
+                     });
+
+    const int n = std::min(int(mirrors.size()), MAX_PROBED_MIRRORS);
+    m_probes.resize(n);
+    if ( n == 0 ) {
+        QTimer::singleShot(0, this, &MirrorProber::finish);
+        return;
+    }
+
+    for ( int i = 0; i < n; ++i ) {
+        m_probes[i].result.mirror = mirrors[i];
+        startRttProbe(i);
+    }
+    m_deadline.start(PROBING_DEADLINE_MS);
+}
+
+QList<MirrorProber::Result> MirrorProber::getResults() const
+{
+    QList<Result> results;
+    for ( const Probe& p : m_probes ) {
+        results.append(p.result);
+    }
+    return results;
+}
+
+void MirrorProber::startRttProbe(int i)
+{
+    Probe& p = m_probes[i];
+    p.timer.start();
+    const auto reply = mp_networkManager->head(createProbeRequest(p.result.mirror.url));
+    p.reply = reply;
+    connect(reply, &QNetworkReply::finished, this, [=]() {
+        Probe& p = m_probes[i];
+        reply->deleteLater();
+        p.reply = nullptr;
+        if ( reply->error() != QNetworkReply::NoError ) {
+            probeDone(i);
+            return;
+        }
+
+        p.result.rtt = p.timer.elapsed() / 1000.0;
+        startThroughputProbe(i);
+    });
+}
+
+void MirrorProber::startThroughputProbe(int i)
+{
+    Probe& p = m_probes[i];
+    QNetworkRequest request = createProbeRequest(p.result.mirror.url);
+    request.setRawHeader("Range", "bytes=0-" + QByteArray::number(THROUGHPUT_SAMPLE_SIZE - 1));
+    p.timer.start();
+    p.reply = mp_networkManager->get(request);
+    connect(p.reply, &QNetworkReply::downloadProgress, this, [=](qint64 bytesReceived, qint64) {
+        Probe& p = m_probes[i];
+        if ( p.done || bytesReceived <= 0 )
+            return;
+
+        p.bytesReceived = bytesReceived;
+        if ( p.firstByteTime < 0 ) {
+            p.firstByteTime = p.timer.elapsed();
+            return;
+        }
+
+        const double dt = (p.timer.elapsed() - p.firstByteTime) / 1000.0;
+        if ( dt > 0 ) {
+            p.result.throughput = bytesReceived / dt;
+        }
+
+        // Servers ignoring the Range header would send the whole file
+        if ( bytesReceived >= THROUGHPUT_SAMPLE_SIZE ) {
+            probeDone(i);
+        }
+    });
+    connect(p.reply, &QNetworkReply::finished, this, [=]() {
+        probeDone(i);
+    });
+}
+
+void MirrorProber::probeDone(int i)
+{
+    Probe& p = m_probes[i];
+    if ( p.done )
+        return;
+
+    p.done = true;
+    if ( p.reply ) {
+        if ( p.reply->error() != QNetworkReply::NoError ) {
+            p.result.throughput = -1;
+        } else if ( p.result.throughput < 0 && p.bytesReceived > 0 ) {
+            // The sample arrived in a single chunk
+            p.result.throughput = p.bytesReceived / (std::max(p.timer.elapsed(), qint64(1)) / 1000.0);
+        }
+        p.reply->disconnect(this);
+        p.reply->abort();
+        p.reply->deleteLater();
+        p.reply = nullptr;
+    }
+
+    const bool allDone = std::all_of(m_probes.begin(), m_probes.end(),
+                                     [](const Probe& p) { return p.done; });
+    if ( allDone ) {
+        finish();
+    }
+}
+
+void MirrorProber::finish()
+{
+    if ( m_finished )
+        return;
+
+    m_finished = true;
+    m_deadline.stop();
+
+    Ranking ranking;
+    for ( Probe& p : m_probes ) {
+        if ( p.reply ) {
+            // Keep the partial throughput sample of the probes that didn't
+            // complete in time
+            p.reply->disconnect(this);
+            p.reply->abort();
+            p.reply->deleteLater();
+            p.reply = nullptr;
+        }
+
+        if ( p.result.rtt >= 0 && p.result.throughput > 0 ) {
+            ranking.append(p.result);
+        }
+    }
+
+    std::sort(ranking.begin(), ranking.end(), [](const Result& a, const Result& b) {
+        return a.score() < b.score();
+    });
+
+    for ( const auto& r : ranking ) {
+        qInfo().nospace() << "Mirror " << r.mirror.url.host()
+                          << " (" << r.mirror.location << "): rtt=" << int(r.rtt * 1000)
+                          << "ms, throughput=" << int(r.throughput / 1024) << "KB/s";
+    }
+
+    emit finished(ranking);
+}
@@ -0,0 +1,78 @@
+#ifndef MIRRORPROBER_H
+#define MIRRORPROBER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QTimer>
+#include <QVector>
+
+#include "metalink.h"
+
+// Measures how fast the mirrors of a download can be reached from here and
+// ranks them accordingly.
+//
+// Every mirror is probed in parallel with a HEAD request (its duration gives
+// the round-trip time including connection setup) followed by a small ranged
+// GET request (giving a throughput sample). Mirrors that fail to answer before
+// the probing deadline are left out of the ranking.
+class MirrorProber : public QObject
+{
+    Q_OBJECT
+
+public: // types
+    struct Result
+    {
+        Metalink::Mirror mirror;
+        double rtt = -1;        // seconds
+        double throughput = -1; // bytes/s
+
+        // Estimated time (in seconds) to download a segment from the mirror
+        double score() const;
+    };
+
+    typedef QList<Result> Ranking;
+
+public: // functions
+    MirrorProber(QNetworkAccessManager* nam, QObject* parent = nullptr);
+
+    // Probes (at most MAX_PROBED_MIRRORS of) the given mirrors in the order of
+    // their priorities. finished() is emitted when all probes are complete or
+    // the deadline expires.
+    void probe(QList<Metalink::Mirror> mirrors);
+
+    // All the probed mirrors, in the order of their priorities. Those that
+    // failed have a negative rtt or throughput. Complete once finished() is
+    // emitted.
+    QList<Result> getResults() const;
+
+signals:
+    void finished(MirrorProber::Ranking ranking);
+
+private: // types
+    struct Probe
+    {
+        Result         result;
+        QNetworkReply* reply = nullptr;
+        QElapsedTimer  timer;
+        qint64         firstByteTime = -1; // ms
+        qint64         bytesReceived = 0;
+        bool           done = false;
+    };
+
+private: // functions
+    void startRttProbe(int i);
+    void startThroughputProbe(int i);
+    void probeDone(int i);
+    void finish();
+
+private: // data
+    QNetworkAccessManager* const mp_networkManager;
+    QVector<Probe> m_probes;
+    QTimer         m_deadline;
+    bool           m_finished = false;
+};
+
+#endif // MIRRORPROBER_H
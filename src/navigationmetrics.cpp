@@ -0,0 +1,207 @@
+#include "navigationmetrics.h"
+
+#include <QJsonArray>
+
+#include <algorithm>
+
+namespace
+{
+
+// Number of navigations kept individually for the export
+const int MAX_RECENT_NAVIGATIONS = 100;
+
+} // unnamed namespace
+
+void NavigationMetrics::Phase::add(qint64 duration)
+{
+    if ( duration < 0 )
+        return;
+    count++;
+    total += duration;
+    max = std::max(max, duration);
+}
+
+QJsonObject NavigationMetrics::Phase::toJson() const
+{
+    QJsonObject json;
+    json["count"] = count;
+    json["meanMs"] = mean();
+    json["maxMs"] = max;
+    return json;
+}
+
+NavigationMetrics::NavigationMetrics(QObject* parent)
+    : QObject(parent)
+{
+}
+
+NavigationMetrics::Navigation* NavigationMetrics::findNavigation(const QObject* view)
+{
+    for ( auto& navigation : m_navigations ) {
+        if ( navigation.view == view )
+            return &navigation;
+    }
+    return nullptr;
+}
+
+NavigationMetrics::Navigation* NavigationMetrics::findNavigationForBook(const QString& zimId)
+{
+    for ( auto it = m_navigations.rbegin(); it != m_navigations.rend(); ++it ) {
+        if ( it->zimId == zimId )
+            return &*it;
+    }
+    return nullptr;
+}
+
+void NavigationMetrics::navigationStarted(const QObject* view)
+{
+    navigationAborted(view);
+    Navigation navigation;
+    navigation.view = view;
+    navigation.timer.start();
+    m_navigations.append(navigation);
+}
+
+void NavigationMetrics::navigationAborted(const QObject* view)
+{
+    for ( auto it = m_navigations.begin(); it != m_navigations.end(); ++it ) {
+        if ( it->view == view ) {
+            m_navigations.erase(it);
+            return;
+        }
+    }
+}
+
+void NavigationMetrics::navigationFinished(const QObject* view, bool ok)
+{
+    const auto navigation = findNavigation(view);
+    if ( !navigation )
+        return;
+
+    const qint64 loadFinishedTime = navigation->timer.elapsed();
+    // Pages not served from a book (blank pages, ...)
+    if ( navigation->zimId.isEmpty() ) {
+        navigationAborted(view);
+        return;
+    }
+
+    auto& stats = m_bookStats[navigation->zimId];
+    stats.navigations++;
+    if ( !ok ) {
+        stats.failures++;
+    }
+    stats.timeToFirstRequest.add(navigation->firstRequestTime);
+    stats.timeToDocument.add(navigation->documentServedTime);
+    stats.timeToLoadFinished.add(loadFinishedTime);
+    stats.subresourceRequests += navigation->subresourceRequests;
+    stats.subresourceBytes += navigation->subresourceBytes;
+    stats.documentBytes += navigation->documentBytes;
+
+    m_recentNavigations.append({navigation->zimId, navigation->documentUrl, ok,
+                                navigation->firstRequestTime,
+                                navigation->documentServedTime,
+                                loadFinishedTime,
+                                navigation->documentBytes,
+                                navigation->subresourceRequests,
+                                navigation->subresourceBytes});
+    while ( m_recentNavigations.size() > MAX_RECENT_NAVIGATIONS ) {
+        m_recentNavigations.removeFirst();
+    }
+
+    navigationAborted(view);
+    emit(statsChanged());
+}
+
+void NavigationMetrics::requestStarted(const QString& zimId, const QUrl& url)
+{
+    // The target of a redirected main document
+    for ( const auto& navigation : m_navigations ) {
+        if ( navigation.documentUrl == url && navigation.documentServedTime < 0 )
+            return;
+    }
+
+    // The most recent navigation still waiting for its main document
+    for ( auto it = m_navigations.rbegin(); it != m_navigations.rend(); ++it ) {
+        if ( it->documentUrl.isEmpty() ) {
+            it->zimId = zimId;
+            it->documentUrl = url;
+            it->firstRequestTime = it->timer.elapsed();
+            return;
+        }
+    }
+
+    if ( const auto navigation = findNavigationForBook(zimId) ) {
+        navigation->subresourceRequests++;
+    }
+}
+
+void NavigationMetrics::requestRedirected(const QUrl& url, const QUrl& target)
+{
+    for ( auto& navigation : m_navigations ) {
+        if ( navigation.documentUrl == url && navigation.documentServedTime < 0 ) {
+            navigation.documentUrl = target;
+            return;
+        }
+    }
+}
+
+void NavigationMetrics::requestServed(const QString& zimId, const QUrl& url, qint64 bytes)
+{
+    for ( auto& navigation : m_navigations ) {
+        if ( navigation.documentUrl == url && navigation.documentServedTime < 0 ) {
+            navigation.documentServedTime = navigation.timer.elapsed();
+            navigation.documentBytes = bytes;
+            return;
+        }
+    }
+
+    if ( const auto navigation = findNavigationForBook(zimId) ) {
+        navigation->subresourceBytes += bytes;
+    }
+}
+
+void NavigationMetrics::clear()
+{
+    m_bookStats.clear();
+    m_recentNavigations.clear();
+    emit(statsChanged());
+}
+
+QJsonObject NavigationMetrics::toJson() const
+{
+    QJsonArray books;
+    for ( auto it = m_bookStats.constBegin(); it != m_bookStats.constEnd(); ++it ) {
+        const auto& stats = it.value();
+        QJsonObject book;
+        book["id"] = it.key();
+        book["navigations"] = stats.navigations;
+        book["failures"] = stats.failures;
+        book["timeToFirstRequest"] = stats.timeToFirstRequest.toJson();
+        book["timeToDocument"] = stats.timeToDocument.toJson();
+        book["timeToLoadFinished"] = stats.timeToLoadFinished.toJson();
+        book["subresourceRequests"] = stats.subresourceRequests;
+        book["subresourceBytes"] = stats.subresourceBytes;
+        book["documentBytes"] = stats.documentBytes;
+        books.append(book);
+    }
+
+    QJsonArray navigations;
+    for ( const auto& navigation : m_recentNavigations ) {
+        QJsonObject json;
+        json["bookId"] = navigation.zimId;
+        json["url"] = navigation.url.toString();
+        json["ok"] = navigation.ok;
+        json["firstRequestMs"] = navigation.firstRequestTime;
+        json["documentServedMs"] = navigation.documentServedTime;
+        json["loadFinishedMs"] = navigation.loadFinishedTime;
+        json["documentBytes"] = navigation.documentBytes;
+        json["subresourceRequests"] = navigation.subresourceRequests;
+        json["subresourceBytes"] = navigation.subresourceBytes;
+        navigations.append(json);
+    }
+
+    QJsonObject json;
+    json["books"] = books;
+    json["recentNavigations"] = navigations;
+    return json;
+}
@@ -0,0 +1,106 @@
+#ifndef NAVIGATIONMETRICS_H
+#define NAVIGATIONMETRICS_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QUrl>
+
+// Timing of the article loads, aggregated per book.
+//
+// A navigation starts when a web view starts loading a page. The zim://
+// requests handled by the UrlSchemeHandler are correlated with the views
+// being loaded: the first request after the start of a navigation is its main
+// document and the next requests to the same book are its subresources. The
+// requests of two views loading pages of the same book at the same time can't
+// be told apart, they are counted for the navigation started last.
+class NavigationMetrics : public QObject
+{
+    Q_OBJECT
+
+public: // types
+    // Durations (in ms) of a navigation phase
+    struct Phase
+    {
+        int count = 0;
+        qint64 total = 0;
+        qint64 max = 0;
+
+        void add(qint64 duration);
+        qint64 mean() const { return count ? total / count : -1; }
+        QJsonObject toJson() const;
+    };
+
+    struct BookStats
+    {
+        int navigations = 0;
+        int failures = 0;
+        Phase timeToFirstRequest;
+        Phase timeToDocument;
+        Phase timeToLoadFinished;
+        int subresourceRequests = 0;
+        qint64 subresourceBytes = 0;
+        qint64 documentBytes = 0;
+    };
+
+public: // functions
+    explicit NavigationMetrics(QObject* parent = nullptr);
+
+    // Called by the web views. `view` only identifies the navigation.
+    void navigationStarted(const QObject* view);
+    void navigationFinished(const QObject* view, bool ok);
+    void navigationAborted(const QObject* view);
+
+    // Called by the UrlSchemeHandler for the zim:// content requests
+    void requestStarted(const QString& zimId, const QUrl& url);
+    void requestRedirected(const QUrl& url, const QUrl& target);
+    void requestServed(const QString& zimId, const QUrl& url, qint64 bytes);
+
+    const QMap<QString, BookStats>& getBookStats() const { return m_bookStats; }
+    QJsonObject toJson() const;
+    void clear();
+
+signals:
+    void statsChanged();
+
+private: // types
+    struct Navigation
+    {
+        const QObject* view = nullptr;
+        QElapsedTimer timer;
+        QString zimId;
+        QUrl documentUrl;
+        qint64 firstRequestTime = -1;
+        qint64 documentServedTime = -1;
+        qint64 documentBytes = 0;
+        int subresourceRequests = 0;
+        qint64 subresourceBytes = 0;
+    };
+
+    struct FinishedNavigation
+    {
+        QString zimId;
+        QUrl url;
+        bool ok;
+        qint64 firstRequestTime;
+        qint64 documentServedTime;
+        qint64 loadFinishedTime;
+        qint64 documentBytes;
+        int subresourceRequests;
+        qint64 subresourceBytes;
+    };
+
+private: // functions
+    Navigation* findNavigation(const QObject* view);
+    Navigation* findNavigationForBook(const QString& zimId);
+
+private: // data
+    // In the order they were started
+    QList<Navigation> m_navigations;
+    QMap<QString, BookStats> m_bookStats;
+    QList<FinishedNavigation> m_recentNavigations;
+};
+
+#endif // NAVIGATIONMETRICS_H
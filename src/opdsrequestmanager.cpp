@@ -77,6 +77,19 @@ void OpdsRequestManager::getCategoriesFromOpds()
     });
 }
 
+QString replyContent(QNetworkReply *mp_reply);
+
+void OpdsRequestManager::getBookEntriesByName(const QString& name)
+{
+    QUrlQuery query;
+    query.addQueryItem("name", name);
+    query.addQueryItem("count", QString::number(-1));
+    auto mp_reply = opdsResponseFromPath("/catalog/v2/entries", query);
+    connect(mp_reply, &QNetworkReply::finished, this, [=]() {
+        emit(bookEntriesReceived(name, replyContent(mp_reply)));
+    });
+}
+
 QString replyContent(QNetworkReply *mp_reply)
 {
     QString content;
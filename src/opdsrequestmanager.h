@@ -18,6 +18,7 @@ public:
     void doUpdate(const QString& currentLanguage, const QString& categoryFilter);
     void getLanguagesFromOpds();
     void getCategoriesFromOpds();
+    void getBookEntriesByName(const QString& name);
 
 private:
     QNetworkAccessManager m_networkManager;
@@ -27,6 +28,7 @@ signals:
     void requestReceived(const QString&);
     void languagesReceived(const QString&);
     void categoriesReceived(const QString&);
+    void bookEntriesReceived(const QString& name, const QString& content);
 
 public slots:
     void receiveContent(QNetworkReply*);
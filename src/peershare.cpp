@@ -0,0 +1,387 @@
+#include "peershare.h"
+
+#include "kiwixapp.h"
+#include "library.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QTcpSocket>
+#include <QUuid>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+// Organization-local scope multicast group (RFC 2365)
+const QHostAddress DISCOVERY_GROUP("239.255.77.88");
+const quint16 DEFAULT_DISCOVERY_PORT = 38585;
+
+const int ANNOUNCE_INTERVAL_MS = 5000;
+
+// Peers that haven't announced themselves for this long are forgotten
+const qint64 PEER_EXPIRY_MS = 3 * ANNOUNCE_INTERVAL_MS;
+
+const char ANNOUNCEMENT_TYPE[] = "kiwix-desktop-peer";
+const int PROTOCOL_VERSION = 1;
+
+const char BOOK_PATH_PREFIX[] = "/peer/v1/books/";
+
+const int MAX_CONNECTIONS = 8;
+const int MAX_REQUEST_SIZE = 8 * 1024;
+
+// Amount of file data read at once and the limit of data queued in the
+// socket (the rest is read as the socket buffer drains)
+const qint64 SEND_CHUNK_SIZE = 256 * 1024;
+const qint64 MAX_QUEUED_BYTES = 1024 * 1024;
+
+quint16 getPortFromEnvironment(const char* envVarName, quint16 defaultValue)
+{
+    const char* const envVarVal = getenv(envVarName);
+    return envVarVal
+         ? quint16(atoi(envVarVal))
+         : defaultValue;
+}
+
+} // unnamed namespace
+
+PeerShare::PeerShare(const Library* library, QObject* parent)
+    : QObject(parent)
+    , mp_library(library)
+    , m_instanceId(QUuid::createUuid().toString(QUuid::WithoutBraces))
+    , m_discoveryPort(getPortFromEnvironment("KIWIX_PEER_DISCOVERY_PORT", DEFAULT_DISCOVERY_PORT))
+{
+    connect(&m_discoverySocket, &QUdpSocket::readyRead, this, &PeerShare::readAnnouncements);
+    connect(&m_server, &QTcpServer::newConnection, this, &PeerShare::acceptConnections);
+    connect(&m_announceTimer, &QTimer::timeout, this, &PeerShare::announce);
+}
+
+PeerShare::~PeerShare()
+{
+    for ( const auto& c : m_connections ) {
+        delete c.file;
+    }
+}
+
+bool PeerShare::start()
+{
+    const quint16 httpPort = getPortFromEnvironment("KIWIX_PEER_HTTP_PORT", 0);
+    if ( !m_server.listen(QHostAddress::AnyIPv4, httpPort) ) {
+        qWarning() << "Cannot start the peer file server:" << m_server.errorString();
+        return false;
+    }
+
+    // Several instances on the same host must be able to share the port
+    const bool bound = m_discoverySocket.bind(QHostAddress::AnyIPv4, m_discoveryPort,
+                                              QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint);
+    if ( !bound || !m_discoverySocket.joinMulticastGroup(DISCOVERY_GROUP) ) {
+        qWarning() << "Peer discovery unavailable:" << m_discoverySocket.errorString();
+    }
+    m_discoverySocket.setSocketOption(QAbstractSocket::MulticastTtlOption, 1);
+    m_discoverySocket.setSocketOption(QAbstractSocket::MulticastLoopbackOption, 1);
+
+    qInfo() << "Sharing books with peers on port" << m_server.serverPort();
+    announce();
+    m_announceTimer.start(ANNOUNCE_INTERVAL_MS);
+    return true;
+}
+
+QList<QUrl> PeerShare::getBookSources(const QString& bookId) const
+{
+    QList<const Peer*> peers;
+    for ( const auto& peer : m_peers ) {
+        if ( peer.lastSeen.elapsed() < PEER_EXPIRY_MS && peer.bookIds.contains(bookId) ) {
+            peers.append(&peer);
+        }
+    }
+    std::sort(peers.begin(), peers.end(), [](const Peer* a, const Peer* b) {
+        return a->lastSeen.elapsed() < b->lastSeen.elapsed();
+    });
+
+    QList<QUrl> sources;
+    for ( const auto peer : peers ) {
+        QUrl url;
+        url.setScheme("http");
+        url.setHost(peer->address.toString());
+        url.setPort(peer->port);
+        url.setPath(BOOK_PATH_PREFIX + bookId);
+        sources.append(url);
+    }
+    return sources;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Discovery
+////////////////////////////////////////////////////////////////////////////////
+
+void PeerShare::announce()
+{
+    removeSilentPeers();
+
+    const QJsonObject announcement{
+        { "type",     ANNOUNCEMENT_TYPE },
+        { "version",  PROTOCOL_VERSION },
+        { "instance", m_instanceId },
+        { "port",     int(m_server.serverPort()) },
+        { "books",    QJsonArray::fromStringList(getSharedBookIds()) }
+    };
+    const QByteArray datagram = QJsonDocument(announcement).toJson(QJsonDocument::Compact);
+    m_discoverySocket.writeDatagram(datagram, DISCOVERY_GROUP, m_discoveryPort);
+}
+
+void PeerShare::readAnnouncements()
+{
+    while ( m_discoverySocket.hasPendingDatagrams() ) {
+        QByteArray datagram(int(m_discoverySocket.pendingDatagramSize()), 0);
+        QHostAddress sender;
+        m_discoverySocket.readDatagram(datagram.data(), datagram.size(), &sender);
+        handleAnnouncement(datagram, sender);
+    }
+}
+
+void PeerShare::handleAnnouncement(const QByteArray& datagram, const QHostAddress& sender)
+{
+    const QJsonObject a = QJsonDocument::fromJson(datagram).object();
+    const QString instanceId = a["instance"].toString();
+    if ( a["type"].toString() != ANNOUNCEMENT_TYPE
+         || a["version"].toInt() != PROTOCOL_VERSION
+         || instanceId.isEmpty()
+         || instanceId == m_instanceId )
+        return;
+
+    const bool isNewPeer = !m_peers.contains(instanceId);
+    Peer& peer = m_peers[instanceId];
+    peer.address = sender;
+    peer.port = quint16(a["port"].toInt());
+    peer.bookIds.clear();
+    for ( const auto& id : a["books"].toArray() ) {
+        peer.bookIds.append(id.toString());
+    }
+    peer.lastSeen.start();
+
+    if ( isNewPeer ) {
+        qInfo() << "Found peer" << sender.toString() << "sharing"
+                << peer.bookIds.size() << "books";
+
+        // Let the newcomer know about us without waiting for the next round
+        announce();
+    }
+}
+
+void PeerShare::removeSilentPeers()
+{
+    for ( auto it = m_peers.begin(); it != m_peers.end(); ) {
+        if ( it->lastSeen.elapsed() > PEER_EXPIRY_MS ) {
+            it = m_peers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+QStringList PeerShare::getSharedBookIds() const
+{
+    QStringList bookIds;
+    for ( const auto& bookId : mp_library->getBookIds() ) {
+        if ( !getSharedBookPath(bookId).isEmpty() ) {
+            bookIds.append(bookId);
+        }
+    }
+    return bookIds;
+}
+
+// Only complete files that are not known to be corrupted are shared
+QString PeerShare::getSharedBookPath(const QString& bookId) const
+{
+    try {
+        const auto& book = mp_library->getBookById(bookId);
+        if ( !book.getDownloadId().empty() || !book.isPathValid() )
+            return QString();
+
+        const auto settingsMgr = KiwixApp::instance()->getSettingsManager();
+        const auto integrityCheck = settingsMgr->getSettings(bookId + "/integrityCheck");
+        if ( integrityCheck.toString() == "failed" )
+            return QString();
+
+        const QString path = QString::fromStdString(book.getPath());
+        return QFileInfo(path).isFile() ? path : QString();
+    } catch ( const std::out_of_range& ) {
+        return QString();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// File server
+////////////////////////////////////////////////////////////////////////////////
+
+void PeerShare::acceptConnections()
+{
+    while ( QTcpSocket* socket = m_server.nextPendingConnection() ) {
+        connect(socket, &QTcpSocket::disconnected, this, [=]() { closeConnection(socket); });
+        if ( m_connections.size() >= MAX_CONNECTIONS ) {
+            m_connections.insert(socket, Connection());
+            sendError(socket, 503, "Service Unavailable");
+            continue;
+        }
+
+        m_connections.insert(socket, Connection());
+        connect(socket, &QTcpSocket::readyRead, this, [=]() { readRequest(socket); });
+        connect(socket, &QTcpSocket::bytesWritten, this, [=]() { sendFileData(socket); });
+    }
+}
+
+void PeerShare::readRequest(QTcpSocket* socket)
+{
+    Connection& c = m_connections[socket];
+    if ( c.responded ) {
+        socket->readAll();
+        return;
+    }
+
+    c.request += socket->readAll();
+    const int headerEnd = c.request.indexOf("\r\n\r\n");
+    if ( headerEnd < 0 ) {
+        if ( c.request.size() > MAX_REQUEST_SIZE ) {
+            sendError(socket, 400, "Bad Request");
+        }
+        return;
+    }
+
+    const QList<QByteArray> lines = c.request.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if ( requestLine.size() != 3 ) {
+        sendError(socket, 400, "Bad Request");
+        return;
+    }
+
+    QByteArray rangeHeader;
+    for ( const auto& line : lines.mid(1) ) {
+        const int colon = line.indexOf(':');
+        if ( colon > 0 && line.left(colon).trimmed().toLower() == "range" ) {
+            rangeHeader = line.mid(colon + 1).trimmed();
+        }
+    }
+    sendResponse(socket, requestLine[0], requestLine[1], rangeHeader);
+}
+
+void PeerShare::sendResponse(QTcpSocket* socket, const QByteArray& method, const QByteArray& path,
+                             const QByteArray& rangeHeader)
+{
+    if ( method != "GET" && method != "HEAD" ) {
+        sendError(socket, 405, "Method Not Allowed");
+        return;
+    }
+
+    const QString requestPath = QString::fromUtf8(path);
+    const QString filePath = requestPath.startsWith(BOOK_PATH_PREFIX)
+                           ? getSharedBookPath(requestPath.mid(int(strlen(BOOK_PATH_PREFIX))))
+                           : QString();
+    if ( filePath.isEmpty() ) {
+        sendError(socket, 404, "Not Found");
+        return;
+    }
+
+    const auto file = new QFile(filePath);
+    if ( !file->open(QIODevice::ReadOnly) ) {
+        delete file;
+        sendError(socket, 404, "Not Found");
+        return;
+    }
+
+    const qint64 fileSize = file->size();
+    qint64 first = 0;
+    qint64 last = fileSize - 1;
+    QByteArray status = "200 OK";
+    QByteArray extraHeaders;
+    if ( !rangeHeader.isEmpty() ) {
+        static const QRegularExpression rangeRegex("^bytes=(\\d+)-(\\d*)$");
+        const auto match = rangeRegex.match(QString::fromLatin1(rangeHeader));
+        first = match.hasMatch() ? match.captured(1).toLongLong() : fileSize;
+        if ( match.hasMatch() && !match.captured(2).isEmpty() ) {
+            last = std::min(last, match.captured(2).toLongLong());
+        }
+        if ( first >= fileSize || first > last ) {
+            delete file;
+            Connection& c = m_connections[socket];
+            c.responded = true;
+            socket->write("HTTP/1.1 416 Range Not Satisfiable\r\n"
+                          "Content-Range: bytes */" + QByteArray::number(fileSize) + "\r\n"
+                          "Content-Length: 0\r\n"
+                          "Connection: close\r\n\r\n");
+            socket->disconnectFromHost();
+            return;
+        }
+        status = "206 Partial Content";
+        extraHeaders = "Content-Range: bytes " + QByteArray::number(first) + "-"
+                     + QByteArray::number(last) + "/" + QByteArray::number(fileSize) + "\r\n";
+    }
+
+    Connection& c = m_connections[socket];
+    c.responded = true;
+    socket->write("HTTP/1.1 " + status + "\r\n"
+                  "Content-Type: application/octet-stream\r\n"
+                  "Content-Length: " + QByteArray::number(last - first + 1) + "\r\n"
+                  "Accept-Ranges: bytes\r\n"
+                  + extraHeaders +
+                  "Connection: close\r\n\r\n");
+
+    if ( method == "HEAD" || !file->seek(first) ) {
+        delete file;
+        socket->disconnectFromHost();
+        return;
+    }
+
+    c.file = file;
+    c.bytesLeft = last - first + 1;
+    sendFileData(socket);
+}
+
+void PeerShare::sendError(QTcpSocket* socket, int status, const QByteArray& reason)
+{
+    m_connections[socket].responded = true;
+    socket->write("HTTP/1.1 " + QByteArray::number(status) + " " + reason + "\r\n"
+                  "Content-Length: 0\r\n"
+                  "Connection: close\r\n\r\n");
+    socket->disconnectFromHost();
+}
+
+void PeerShare::sendFileData(QTcpSocket* socket)
+{
+    const auto it = m_connections.find(socket);
+    if ( it == m_connections.end() || it->file == nullptr )
+        return;
+
+    Connection& c = *it;
+    while ( c.bytesLeft > 0 && socket->bytesToWrite() < MAX_QUEUED_BYTES ) {
+        const QByteArray data = c.file->read(std::min(c.bytesLeft, SEND_CHUNK_SIZE));
+        if ( data.isEmpty() ) {
+            // The file was truncated or removed meanwhile
+            socket->abort();
+            return;
+        }
+        socket->write(data);
+        c.bytesLeft -= data.size();
+    }
+
+    if ( c.bytesLeft == 0 ) {
+        delete c.file;
+        c.file = nullptr;
+        socket->disconnectFromHost();
+    }
+}
+
+void PeerShare::closeConnection(QTcpSocket* socket)
+{
+    const auto it = m_connections.find(socket);
+    if ( it != m_connections.end() ) {
+        delete it->file;
+        m_connections.erase(it);
+    }
+    socket->deleteLater();
+}
@@ -0,0 +1,91 @@
+#ifndef PEERSHARE_H
+#define PEERSHARE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QMap>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QUrl>
+
+class Library;
+class QFile;
+class QTcpSocket;
+
+// Sharing of ZIM files between kiwix-desktop instances on the local network.
+//
+// Every instance periodically announces (via UDP multicast) the books that it
+// has fully downloaded, together with the port of a small HTTP server serving
+// the files of those books (with support for range requests). Announcements
+// of the other instances are collected so that books can be downloaded from
+// peers rather than from the internet (see PeerTransfer).
+//
+// The UDP and TCP ports default to DEFAULT_DISCOVERY_PORT and to an arbitrary
+// free port, and can be changed with the KIWIX_PEER_DISCOVERY_PORT and
+// KIWIX_PEER_HTTP_PORT environment variables (e.g. for testing with several
+// instances on the same host).
+class PeerShare : public QObject
+{
+    Q_OBJECT
+
+public: // functions
+    explicit PeerShare(const Library* library, QObject* parent = nullptr);
+    ~PeerShare();
+
+    // Returns false if the file server cannot be started
+    bool start();
+
+    // URLs from which the file of the book can be downloaded, the most
+    // recently heard from peers first
+    QList<QUrl> getBookSources(const QString& bookId) const;
+
+private: // types
+    struct Peer
+    {
+        QHostAddress  address;
+        quint16       port = 0;
+        QStringList   bookIds;
+        QElapsedTimer lastSeen;
+    };
+
+    struct Connection
+    {
+        QByteArray request;
+        QFile*     file = nullptr;
+        qint64     bytesLeft = 0;
+        bool       responded = false;
+    };
+
+private: // functions
+    void announce();
+    void readAnnouncements();
+    void handleAnnouncement(const QByteArray& datagram, const QHostAddress& sender);
+    void removeSilentPeers();
+    QStringList getSharedBookIds() const;
+    QString getSharedBookPath(const QString& bookId) const;
+
+    void acceptConnections();
+    void readRequest(QTcpSocket* socket);
+    void sendResponse(QTcpSocket* socket, const QByteArray& method, const QByteArray& path,
+                      const QByteArray& rangeHeader);
+    void sendError(QTcpSocket* socket, int status, const QByteArray& reason);
+    void sendFileData(QTcpSocket* socket);
+    void closeConnection(QTcpSocket* socket);
+
+private: // data
+    const Library* const mp_library;
+    const QString        m_instanceId;
+    quint16              m_discoveryPort;
+    QUdpSocket           m_discoverySocket;
+    QTcpServer           m_server;
+    QTimer               m_announceTimer;
+    QMap<QString, Peer>  m_peers; // instance id -> peer
+    QHash<QTcpSocket*, Connection> m_connections;
+};
+
+#endif // PEERSHARE_H
@@ -0,0 +1,227 @@
+#include "peertransfer.h"
+
+#include <QDebug>
+#include <QNetworkRequest>
+
+#include <algorithm>
+
+namespace
+{
+
+// Amount of data requested from a peer at once (rounded to whole pieces)
+const qint64 CHUNK_SIZE = 16 * 1024 * 1024;
+
+// A peer not sending any data for this long is considered gone
+const int TRANSFER_TIMEOUT_MS = 30000;
+
+// A peer failing this many times in a row is given up
+const int MAX_SOURCE_FAILURES = 5;
+
+// Delay before requesting again from a peer that failed once (doubled with
+// each further failure)
+const int RETRY_DELAY_MS = 1000;
+
+} // unnamed namespace
+
+PeerTransfer::PeerTransfer(QNetworkAccessManager* nam, const Metalink& metalink,
+                           const QList<QUrl>& sources, const QString& path,
+                           qint64 resumeOffset, QObject* parent)
+    : QObject(parent)
+    , mp_networkManager(nam)
+    , m_metalink(metalink)
+    , m_file(path)
+    , m_pieceHash(metalink.pieceHashAlgorithm())
+    , m_chunkSize(metalink.pieceLength * std::max(qint64(1), CHUNK_SIZE / metalink.pieceLength))
+{
+    for ( const auto& url : sources ) {
+        m_sources.append(Source{url, 0});
+    }
+
+    m_retryTimer.setSingleShot(true);
+    connect(&m_retryTimer, &QTimer::timeout, this, &PeerTransfer::requestNextChunk);
+
+    // Only whole pieces count as transferred
+    resumeOffset = qBound(qint64(0), resumeOffset, metalink.size);
+    m_verifiedLength = resumeOffset - resumeOffset % metalink.pieceLength;
+    m_receivedLength = m_verifiedLength;
+}
+
+void PeerTransfer::start()
+{
+    if ( !m_file.open(QIODevice::ReadWrite) ) {
+        qWarning() << "Cannot write" << m_file.fileName() << ":" << m_file.errorString();
+        finish(false);
+        return;
+    }
+
+    if ( m_file.size() < m_verifiedLength ) {
+        // The file was truncated since the transfer was interrupted
+        m_verifiedLength = m_file.size() - m_file.size() % m_metalink.pieceLength;
+        m_receivedLength = m_verifiedLength;
+    }
+    m_file.resize(m_verifiedLength);
+    m_file.seek(m_verifiedLength);
+    requestNextChunk();
+}
+
+void PeerTransfer::pause()
+{
+    m_paused = true;
+    m_retryTimer.stop();
+    abandonCurrentChunk();
+}
+
+void PeerTransfer::resume()
+{
+    if ( m_paused ) {
+        m_paused = false;
+        requestNextChunk();
+    }
+}
+
+void PeerTransfer::cancel()
+{
+    m_retryTimer.stop();
+    abandonCurrentChunk();
+    m_finished = true;
+    m_file.close();
+}
+
+void PeerTransfer::requestNextChunk()
+{
+    if ( m_finished || m_paused || mp_reply || m_retryTimer.isActive() )
+        return;
+
+    if ( m_verifiedLength >= m_metalink.size ) {
+        finish(true);
+        return;
+    }
+
+    if ( m_sources.isEmpty() ) {
+        finish(false);
+        return;
+    }
+
+    m_chunkEnd = std::min(m_verifiedLength + m_chunkSize, m_metalink.size);
+    QNetworkRequest request(m_sources.first().url);
+    request.setRawHeader("Range", "bytes=" + QByteArray::number(m_verifiedLength)
+                                  + "-" + QByteArray::number(m_chunkEnd - 1));
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+                         QNetworkRequest::AlwaysNetwork);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    request.setTransferTimeout(TRANSFER_TIMEOUT_MS);
+#endif
+    mp_reply = mp_networkManager->get(request);
+    connect(mp_reply, &QNetworkReply::readyRead, this, &PeerTransfer::readChunkData);
+    connect(mp_reply, &QNetworkReply::finished, this, &PeerTransfer::chunkFinished);
+}
+
+void PeerTransfer::readChunkData()
+{
+    const int status = mp_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if ( status != 206 ) {
+        currentSourceFailed(false);
+    } else if ( !consume(mp_reply->readAll()) ) {
+        currentSourceFailed(true);
+    }
+}
+
+void PeerTransfer::chunkFinished()
+{
+    if ( mp_reply->error() == QNetworkReply::NoError && mp_reply->bytesAvailable() > 0 ) {
+        const QNetworkReply* const reply = mp_reply;
+        readChunkData();
+        if ( mp_reply != reply )
+            return; // the source failed
+    }
+
+    if ( mp_reply->error() != QNetworkReply::NoError || m_verifiedLength < m_chunkEnd ) {
+        currentSourceFailed(false);
+        return;
+    }
+
+    m_sources.first().failures = 0;
+    mp_reply->deleteLater();
+    mp_reply = nullptr;
+    m_file.flush();
+    emit progressed(m_verifiedLength);
+    requestNextChunk();
+}
+
+// Writes and hashes the data received for the current chunk. Returns false
+// if the data is bad (or cannot be written).
+bool PeerTransfer::consume(const QByteArray& data)
+{
+    const qint64 pieceLength = m_metalink.pieceLength;
+    qint64 pos = 0;
+    while ( pos < data.size() ) {
+        const qint64 pieceIndex = m_receivedLength / pieceLength;
+        const qint64 pieceEnd = std::min((pieceIndex + 1) * pieceLength, m_metalink.size);
+        const qint64 n = std::min(data.size() - pos, pieceEnd - m_receivedLength);
+        if ( m_receivedLength + n > m_chunkEnd )
+            return false;
+
+        const char* const bytes = data.constData() + pos;
+        if ( m_file.write(bytes, n) != n )
+            return false;
+
+        m_pieceHash.addData(bytes, int(n));
+        m_receivedLength += n;
+        pos += n;
+
+        if ( m_receivedLength == pieceEnd ) {
+            const QByteArray expectedHash = m_metalink.pieceHashes.value(int(pieceIndex)).toLower();
+            if ( m_pieceHash.result().toHex() != expectedHash )
+                return false;
+
+            m_pieceHash.reset();
+            m_verifiedLength = pieceEnd;
+        }
+    }
+    return true;
+}
+
+void PeerTransfer::currentSourceFailed(bool sentBadData)
+{
+    Source source = m_sources.takeFirst();
+    ++source.failures;
+    qInfo() << "Peer" << source.url.host() << "failed to provide"
+            << m_file.fileName() << "at offset" << m_verifiedLength
+            << (sentBadData ? "(bad data)" : "");
+    abandonCurrentChunk();
+
+    // The other peers are tried first
+    if ( !sentBadData && source.failures < MAX_SOURCE_FAILURES ) {
+        m_sources.append(source);
+    }
+
+    if ( !m_sources.isEmpty() && m_sources.first().failures > 0 ) {
+        m_retryTimer.start(RETRY_DELAY_MS << (m_sources.first().failures - 1));
+        return;
+    }
+    requestNextChunk();
+}
+
+void PeerTransfer::abandonCurrentChunk()
+{
+    if ( mp_reply ) {
+        mp_reply->disconnect(this);
+        mp_reply->abort();
+        mp_reply->deleteLater();
+        mp_reply = nullptr;
+    }
+
+    if ( m_file.isOpen() ) {
+        m_file.resize(m_verifiedLength);
+        m_file.seek(m_verifiedLength);
+    }
+    m_receivedLength = m_verifiedLength;
+    m_pieceHash.reset();
+}
+
+void PeerTransfer::finish(bool success)
+{
+    m_finished = true;
+    m_file.close();
+    emit finished(success);
+}
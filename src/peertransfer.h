@@ -0,0 +1,101 @@
+#ifndef PEERTRANSFER_H
+#define PEERTRANSFER_H
+
+#include <QObject>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QTimer>
+#include <QUrl>
+
+#include "metalink.h"
+
+// Downloads the file of a book from other kiwix-desktop instances on the
+// local network (see PeerShare).
+//
+// The file is fetched in chunks with HTTP range requests. Data is hashed as it
+// arrives and every piece is checked against the piece hashes of the metalink
+// of the book; only verified data counts as transferred. When a peer fails the
+// transfer continues from the last verified piece with the next peer; the
+// failed peer is tried again later, after a delay doubling with each of its
+// consecutive failures, and is only given up after MAX_SOURCE_FAILURES of
+// them (or at once if it sends bad data). The transfer can also be resumed
+// later from a given offset.
+class PeerTransfer : public QObject
+{
+    Q_OBJECT
+
+public: // functions
+    // The metalink must provide piece hashes
+    PeerTransfer(QNetworkAccessManager* nam, const Metalink& metalink,
+                 const QList<QUrl>& sources, const QString& path,
+                 qint64 resumeOffset, QObject* parent = nullptr);
+
+    void start();
+    void pause();
+    void resume();
+    void cancel();
+
+    bool isPaused() const { return m_paused; }
+    QString getPath() const { return m_file.fileName(); }
+    qint64 getCompletedLength() const { return m_verifiedLength; }
+    qint64 getTotalLength() const { return m_metalink.size; }
+    const Metalink& getMetalink() const { return m_metalink; }
+
+signals:
+    // Emitted whenever a chunk has been verified and written. The transfer
+    // can be resumed from verifiedLength.
+    void progressed(qint64 verifiedLength);
+
+    // success is false if none of the peers could provide the file
+    void finished(bool success);
+
+private: // types
+    struct Source
+    {
+        QUrl url;
+
+        // Consecutive failures of the peer
+        int  failures = 0;
+    };
+
+private: // functions
+    void requestNextChunk();
+    void readChunkData();
+    void chunkFinished();
+    bool consume(const QByteArray& data);
+
+    // Moves on to the next peer. The current one is tried again later unless
+    // it sent bad data or failed too many times in a row.
+    void currentSourceFailed(bool sentBadData);
+
+    // Stops the current request and discards its data that hasn't been
+    // verified yet
+    void abandonCurrentChunk();
+    void finish(bool success);
+
+private: // data
+    QNetworkAccessManager* const mp_networkManager;
+    const Metalink     m_metalink;
+    QList<Source>      m_sources;
+    QFile              m_file;
+    QNetworkReply*     mp_reply = nullptr;
+    QCryptographicHash m_pieceHash;
+    QTimer             m_retryTimer;
+
+    qint64 m_chunkSize;
+    qint64 m_verifiedLength;
+
+    // Position of the data hashed (and written) so far in the current piece
+    qint64 m_receivedLength;
+
+    // End of the chunk being currently requested
+    qint64 m_chunkEnd = 0;
+
+    bool m_paused = false;
+    bool m_finished = false;
+};
+
+#endif // PEERTRANSFER_H
@@ -1,12 +1,22 @@
 #include "searchbar.h"
 
 #include <QCompleter>
+#include <QDebug>
 #include <QFocusEvent>
+#include <QLoggingCategory>
 #include <QScrollBar>
 
 #include "kiwixapp.h"
 #include "suggestionlistworker.h"
 
+namespace
+{
+
+// Enabled with QT_LOGGING_RULES="kiwix.suggestions.debug=true"
+Q_LOGGING_CATEGORY(suggestionsLog, "kiwix.suggestions", QtInfoMsg)
+
+} // unnamed namespace
+
 BookmarkButton::BookmarkButton(QWidget *parent) :
     QToolButton(parent)
 {
@@ -51,7 +61,8 @@ void BookmarkButton::on_buttonClicked()
 SearchBarLineEdit::SearchBarLineEdit(QWidget *parent) :
     QLineEdit(parent),
     m_suggestionView(new QTreeView),
-    m_completer(&m_suggestionModel, this)
+    m_completer(&m_suggestionModel, this),
+    mp_suggestionWorker(new SuggestionListWorker)
 {
     installEventFilter(this);
     setAlignment(KiwixApp::isRightToLeft() ? Qt::AlignRight : Qt::AlignLeft);
@@ -86,10 +97,18 @@ SearchBarLineEdit::SearchBarLineEdit(QWidget *parent) :
     qRegisterMetaType<QList<SuggestionData>>("QList<SuggestionData>");
     connect(mp_typingTimer, &QTimer::timeout, this, &SearchBarLineEdit::updateCompletion);
 
+    mp_suggestionWorker->moveToThread(&m_suggestionWorkerThread);
+    connect(&m_suggestionWorkerThread, &QThread::finished,
+            mp_suggestionWorker, &QObject::deleteLater);
+    connect(mp_suggestionWorker, &SuggestionListWorker::searchFinished,
+            this, &SearchBarLineEdit::onSuggestionsReceived);
+    m_suggestionWorkerThread.start();
+
     connect(this, &QLineEdit::textEdited, this,
             [=](const QString &text) {
                 m_searchbarInput = text;
                 m_returnPressed = false;
+                m_keystrokeTimer.start();
                 mp_typingTimer->start(100);
     });
     connect(this, &QLineEdit::textChanged, this,
@@ -117,6 +136,12 @@ SearchBarLineEdit::SearchBarLineEdit(QWidget *parent) :
             });
 }
 
+SearchBarLineEdit::~SearchBarLineEdit()
+{
+    m_suggestionWorkerThread.quit();
+    m_suggestionWorkerThread.wait();
+}
+
 void SearchBarLineEdit::hideSuggestions()
 {
     m_suggestionView->hide();
@@ -213,10 +238,7 @@ void SearchBarLineEdit::updateCompletion()
 
 void SearchBarLineEdit::fetchMoreSuggestions()
 {
-    /* TODO: Refactor suggestion worker to re-use zim::SuggestionSearcher for
-       fetching more suggestion in a single archive. Currently we create a 
-       searcher for every fetch, and discarded after one use.
-    */
+    /* The suggestion worker continues the search of the initial suggestions */
     fetchSuggestions(&SearchBarLineEdit::onAdditionalSuggestions);
 }
 
@@ -304,23 +326,65 @@ void SearchBarLineEdit::onAdditionalSuggestions(int start)
 
 void SearchBarLineEdit::fetchSuggestions(NewSuggestionHandlerFuncPtr callback)
 {
+    WebView* current = KiwixApp::instance()->getTabWidget()->currentWebView();
+    if (!current)
+        return;
+
+    const auto zimId = current->url().host().split(".")[0];
+    QStringList zimIds{zimId};
+    const auto settingsManager = KiwixApp::instance()->getSettingsManager();
+    const auto multiZim = settingsManager->getMultiZimSuggestions();
+    if (multiZim == "openTabs") {
+        zimIds += KiwixApp::instance()->getTabWidget()->getTabZimIds();
+    } else if (multiZim == "books") {
+        zimIds += settingsManager->getSuggestionBooks();
+    }
+    zimIds.removeAll(QString());
+    zimIds.removeDuplicates();
+
+    const auto text = m_searchbarInput;
+    const int token = m_token;
     const int start = m_suggestionModel.countOfRegularSuggestions();
-    const auto suggestionWorker = new SuggestionListWorker(m_searchbarInput, m_token, start, this);
-    connect(suggestionWorker, &SuggestionListWorker::searchFinished, this,
-            [=] (const QList<SuggestionData>& suggestionList, int token) {
-                if (token != m_token) {
-                    return;
-                }
+    m_suggestionHandler = callback;
+    m_suggestionStart = start;
+    m_suggestionsAreMerged = multiZim != "library" && zimIds.size() > 1;
+    m_suggestionRequestTimer.start();
+
+    /* Requests still waiting in the queue of the worker are dropped */
+    const auto worker = mp_suggestionWorker;
+    worker->setCurrentToken(token);
+    if (multiZim == "library") {
+        QMetaObject::invokeMethod(worker, [=]() {
+            worker->fetchLibrarySuggestions(zimId, text, token, start);
+        });
+    } else {
+        QMetaObject::invokeMethod(worker, [=]() {
+            worker->fetchSuggestions(zimIds, text, token, start);
+        });
+    }
+}
 
-                m_suggestionModel.append(suggestionList);
-                const int listSize = suggestionList.size();
-                const bool hasFullText = listSize > 0 && suggestionList.back().isFullTextSearchSuggestion();
-                const int maxFetchSize = SuggestionListWorker::getFetchSize() + hasFullText;
-                m_moreSuggestionsAreAvailable = listSize >= maxFetchSize;
-                (this->*callback)(start);
-            });
-    connect(suggestionWorker, &SuggestionListWorker::finished, suggestionWorker, &QObject::deleteLater);
-    suggestionWorker->start();
+void SearchBarLineEdit::onSuggestionsReceived(const QList<SuggestionData>& suggestionList, int token)
+{
+    if (token != m_token || !m_suggestionHandler) {
+        return;
+    }
+
+    if (m_suggestionStart == 0) {
+        // The query itself is not logged
+        qCDebug(suggestionsLog).nospace() << "Suggestions ready "
+                                          << m_keystrokeTimer.elapsed() << "ms after the keystroke ("
+                                          << m_suggestionRequestTimer.elapsed() << "ms after the request)";
+    }
+
+    m_suggestionModel.append(suggestionList);
+    const int listSize = suggestionList.size();
+    const bool hasFullText = listSize > 0 && suggestionList.back().isFullTextSearchSuggestion();
+    const int maxFetchSize = SuggestionListWorker::getFetchSize() + hasFullText;
+    m_moreSuggestionsAreAvailable = !m_suggestionsAreMerged && listSize >= maxFetchSize;
+    const auto callback = m_suggestionHandler;
+    m_suggestionHandler = nullptr;
+    (this->*callback)(m_suggestionStart);
 }
 
 QModelIndex SearchBarLineEdit::getDefaulSuggestionIndex() const
@@ -4,6 +4,7 @@
 #include <QLineEdit>
 #include <QStringListModel>
 #include <QCompleter>
+#include <QElapsedTimer>
 #include <QIcon>
 #include <QToolButton>
 #include <QUrl>
@@ -13,6 +14,7 @@
 #include "suggestionlistmodel.h"
 
 class QTreeView;
+class SuggestionListWorker;
 
 class BookmarkButton : public QToolButton {
     Q_OBJECT
@@ -32,6 +34,7 @@ class SearchBarLineEdit : public QLineEdit
 
 public:
     SearchBarLineEdit(QWidget *parent = nullptr);
+    ~SearchBarLineEdit();
     void hideSuggestions();
     bool eventFilter(QObject *watched, QEvent *event) override;
 
@@ -53,6 +56,19 @@ private:
     int m_token;
     bool m_moreSuggestionsAreAvailable = false;
 
+    QThread m_suggestionWorkerThread;
+    SuggestionListWorker* mp_suggestionWorker;
+    NewSuggestionHandlerFuncPtr m_suggestionHandler = nullptr;
+    int m_suggestionStart = 0;
+    // The suggestions of several books are merged in a single batch, which
+    // can't be continued
+    bool m_suggestionsAreMerged = false;
+
+    // For measuring the latency of suggestions (from the keystroke, and from
+    // the request to the suggestion worker)
+    QElapsedTimer m_keystrokeTimer;
+    QElapsedTimer m_suggestionRequestTimer;
+
     /* We only fetch more suggestions when the user is at the end and tries to
        scroll again. This variable is set whenever the user scrolled to the end,
        indicating the next scroll should trigger a fetch more action. */
@@ -66,6 +82,7 @@ private slots:
     void onInitialSuggestions(int);
     void onAdditionalSuggestions(int start);
     void fetchSuggestions(NewSuggestionHandlerFuncPtr callback);
+    void onSuggestionsReceived(const QList<SuggestionData>& suggestionList, int token);
 
     QModelIndex getDefaulSuggestionIndex() const;
 };
@@ -0,0 +1,185 @@
+#include "servermetrics.h"
+
+#include <QUrl>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+// Window of the request rate
+const qint64 RATE_WINDOW_MS = 10000;
+
+// Number of recent requests from which the latency percentiles are computed
+const int MAX_RECENT_LATENCIES = 1000;
+
+// The articles stop being counted individually past that number, to bound
+// the memory used when the server is crawled
+const int MAX_COUNTED_ARTICLES = 10000;
+
+const char CONTENT_PATH[] = "/content/";
+
+// Book name and article path of a kiwix-serve content URL
+// ("[/root]/content/<book>/<path>")
+QPair<QString, QString> parseContentPath(const QByteArray& rawPath)
+{
+    QString path = QUrl::fromPercentEncoding(rawPath);
+    path = path.left(path.indexOf('?'));
+    const int start = path.indexOf(CONTENT_PATH);
+    if ( start < 0 )
+        return {};
+    const int bookStart = start + int(strlen(CONTENT_PATH));
+    const int bookEnd = path.indexOf('/', bookStart);
+    if ( bookEnd < 0 )
+        return { path.mid(bookStart), QString() };
+    return { path.mid(bookStart, bookEnd - bookStart), path.mid(bookEnd + 1) };
+}
+
+ServerMetrics::RankedList getTopEntries(const QHash<QString, qint64>& counts, int count)
+{
+    ServerMetrics::RankedList entries;
+    for ( auto it = counts.constBegin(); it != counts.constEnd(); ++it ) {
+        entries.append({it.key(), it.value()});
+    }
+    std::sort(entries.begin(), entries.end(), [](const QPair<QString, qint64>& a,
+                                                  const QPair<QString, qint64>& b) {
+        return a.second > b.second;
+    });
+    return entries.mid(0, count);
+}
+
+QByteArray escapeLabelValue(const QString& value)
+{
+    QByteArray escaped = value.toUtf8();
+    escaped.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+    return escaped;
+}
+
+} // unnamed namespace
+
+ServerMetrics::ServerMetrics()
+{
+    m_clock.start();
+}
+
+void ServerMetrics::connectionOpened()
+{
+    m_activeConnections++;
+}
+
+void ServerMetrics::connectionClosed()
+{
+    m_activeConnections--;
+}
+
+void ServerMetrics::recordResponse(const QByteArray& path, int status, const QByteArray& contentType,
+                                   qint64 bytes, qint64 latencyUs)
+{
+    m_requestCount++;
+    m_bytesServed += bytes;
+    m_totalLatencyUs += latencyUs;
+    m_responsesByStatus[status]++;
+
+    m_recentRequestTimes.enqueue(m_clock.elapsed());
+    dropOldRequestTimes();
+
+    if ( m_recentLatencies.size() < MAX_RECENT_LATENCIES ) {
+        m_recentLatencies.append(latencyUs);
+    } else {
+        m_recentLatencies[m_nextLatencyIndex] = latencyUs;
+        m_nextLatencyIndex = (m_nextLatencyIndex + 1) % MAX_RECENT_LATENCIES;
+    }
+
+    const auto content = parseContentPath(path);
+    if ( content.first.isEmpty() )
+        return;
+    m_bookRequests[content.first]++;
+    if ( status == 200 && contentType.startsWith("text/html") ) {
+        const QString article = content.first + "/" + content.second;
+        if ( m_articleRequests.size() < MAX_COUNTED_ARTICLES || m_articleRequests.contains(article) ) {
+            m_articleRequests[article]++;
+        }
+    }
+}
+
+void ServerMetrics::reset()
+{
+    const int activeConnections = m_activeConnections;
+    *this = ServerMetrics();
+    m_activeConnections = activeConnections;
+}
+
+void ServerMetrics::dropOldRequestTimes()
+{
+    const qint64 windowStart = m_clock.elapsed() - RATE_WINDOW_MS;
+    while ( !m_recentRequestTimes.isEmpty() && m_recentRequestTimes.head() < windowStart ) {
+        m_recentRequestTimes.dequeue();
+    }
+}
+
+double ServerMetrics::getRequestRate()
+{
+    dropOldRequestTimes();
+    const qint64 window = std::min(RATE_WINDOW_MS, std::max(qint64(1), m_clock.elapsed()));
+    return m_recentRequestTimes.size() * 1000.0 / window;
+}
+
+qint64 ServerMetrics::getLatencyPercentile(double fraction) const
+{
+    if ( m_recentLatencies.isEmpty() )
+        return -1;
+
+    QList<qint64> latencies = m_recentLatencies;
+    const int index = std::min(int(fraction * latencies.size()), int(latencies.size()) - 1);
+    std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+    return latencies[index];
+}
+
+ServerMetrics::RankedList ServerMetrics::getTopBooks(int count) const
+{
+    return getTopEntries(m_bookRequests, count);
+}
+
+ServerMetrics::RankedList ServerMetrics::getTopArticles(int count) const
+{
+    return getTopEntries(m_articleRequests, count);
+}
+
+QByteArray ServerMetrics::toPrometheus() const
+{
+    QByteArray text;
+    text += "# HELP kiwix_server_requests_total Requests served by the local Kiwix server.\n"
+            "# TYPE kiwix_server_requests_total counter\n";
+    for ( auto it = m_responsesByStatus.constBegin(); it != m_responsesByStatus.constEnd(); ++it ) {
+        text += "kiwix_server_requests_total{code=\"" + QByteArray::number(it.key()) + "\"} "
+              + QByteArray::number(it.value()) + "\n";
+    }
+
+    text += "# HELP kiwix_server_bytes_served_total Bytes sent to the clients.\n"
+            "# TYPE kiwix_server_bytes_served_total counter\n"
+            "kiwix_server_bytes_served_total " + QByteArray::number(m_bytesServed) + "\n";
+
+    text += "# HELP kiwix_server_active_connections Open client connections.\n"
+            "# TYPE kiwix_server_active_connections gauge\n"
+            "kiwix_server_active_connections " + QByteArray::number(m_activeConnections) + "\n";
+
+    text += "# HELP kiwix_server_request_duration_seconds Time to serve a request (quantiles over the last "
+          + QByteArray::number(MAX_RECENT_LATENCIES) + " requests).\n"
+            "# TYPE kiwix_server_request_duration_seconds summary\n";
+    for ( const double quantile : { 0.5, 0.9, 0.99 } ) {
+        const qint64 latency = getLatencyPercentile(quantile);
+        text += "kiwix_server_request_duration_seconds{quantile=\"" + QByteArray::number(quantile) + "\"} "
+              + (latency < 0 ? QByteArray("NaN") : QByteArray::number(latency / 1e6)) + "\n";
+    }
+    text += "kiwix_server_request_duration_seconds_sum " + QByteArray::number(m_totalLatencyUs / 1e6) + "\n"
+            "kiwix_server_request_duration_seconds_count " + QByteArray::number(m_requestCount) + "\n";
+
+    text += "# HELP kiwix_server_book_requests_total Requests for the content of each book.\n"
+            "# TYPE kiwix_server_book_requests_total counter\n";
+    for ( auto it = m_bookRequests.constBegin(); it != m_bookRequests.constEnd(); ++it ) {
+        text += "kiwix_server_book_requests_total{book=\"" + escapeLabelValue(it.key()) + "\"} "
+              + QByteArray::number(it.value()) + "\n";
+    }
+    return text;
+}
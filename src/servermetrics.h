@@ -0,0 +1,63 @@
+#ifndef SERVERMETRICS_H
+#define SERVERMETRICS_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QQueue>
+#include <QString>
+
+// Statistics of the requests served by the local Kiwix server (collected by
+// ServerMetricsProxy).
+class ServerMetrics
+{
+public: // types
+    typedef QList<QPair<QString, qint64>> RankedList;
+
+public: // functions
+    ServerMetrics();
+
+    void connectionOpened();
+    void connectionClosed();
+    void recordResponse(const QByteArray& path, int status, const QByteArray& contentType,
+                        qint64 bytes, qint64 latencyUs);
+    void reset();
+
+    int getActiveConnections() const { return m_activeConnections; }
+    qint64 getRequestCount() const { return m_requestCount; }
+    qint64 getBytesServed() const { return m_bytesServed; }
+
+    // Requests per second over the last few seconds
+    double getRequestRate();
+
+    // Latency (in µs) under which fall the given fraction of the recent
+    // requests, -1 if there were none
+    qint64 getLatencyPercentile(double fraction) const;
+
+    RankedList getTopBooks(int count) const;
+    RankedList getTopArticles(int count) const;
+
+    // Text exposition format of Prometheus
+    QByteArray toPrometheus() const;
+
+private: // functions
+    void dropOldRequestTimes();
+
+private: // data
+    QElapsedTimer        m_clock;
+    int                  m_activeConnections = 0;
+    qint64               m_requestCount = 0;
+    qint64               m_bytesServed = 0;
+    qint64               m_totalLatencyUs = 0;
+    QMap<int, qint64>    m_responsesByStatus;
+    QQueue<qint64>       m_recentRequestTimes; // for the request rate
+    QList<qint64>        m_recentLatencies;    // ring buffer
+    int                  m_nextLatencyIndex = 0;
+    QHash<QString, qint64> m_bookRequests;
+    QHash<QString, qint64> m_articleRequests;
+};
+
+#endif // SERVERMETRICS_H
@@ -0,0 +1,485 @@
+#include "servermetricsproxy.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QTcpSocket>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+// Amount of response data queued in a client socket, the rest is read from
+// the server as the client socket drains
+const qint64 MAX_QUEUED_BYTES = 1024 * 1024;
+
+// The headers of longer messages are not parsed (the message is forwarded
+// without being measured)
+const int MAX_HEADERS_SIZE = 64 * 1024;
+
+const char HEADERS_END[] = "\r\n\r\n";
+
+QByteArray getHeaderValue(const QList<QByteArray>& lines, const QByteArray& name)
+{
+    for ( const auto& line : lines ) {
+        const int colon = line.indexOf(':');
+        if ( colon > 0 && line.left(colon).trimmed().toLower() == name ) {
+            return line.mid(colon + 1).trimmed();
+        }
+    }
+    return QByteArray();
+}
+
+} // unnamed namespace
+
+ServerMetricsProxy::ServerMetricsProxy()
+    : m_server(this),
+      m_metricsServer(this)
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &ServerMetricsProxy::acceptConnections);
+    connect(&m_metricsServer, &QTcpServer::newConnection, this, &ServerMetricsProxy::acceptMetricsConnections);
+
+    // The servers and the sockets, being children, move along
+    moveToThread(&m_thread);
+    m_thread.setObjectName("ServerMetricsProxy");
+    m_thread.start();
+}
+
+ServerMetricsProxy::~ServerMetricsProxy()
+{
+    stop();
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void ServerMetricsProxy::runInThread(const std::function<void()>& function) const
+{
+    if ( QThread::currentThread() == &m_thread || !m_thread.isRunning() ) {
+        function();
+    } else {
+        QMetaObject::invokeMethod(const_cast<ServerMetricsProxy*>(this), function,
+                                  Qt::BlockingQueuedConnection);
+    }
+}
+
+quint16 ServerMetricsProxy::findFreeLoopbackPort()
+{
+    QTcpServer server;
+    if ( !server.listen(QHostAddress::LocalHost, 0) )
+        return 0;
+    return server.serverPort();
+}
+
+bool ServerMetricsProxy::start(const QHostAddress& address, quint16 port, quint16 backendPort, quint16 metricsPort)
+{
+    bool started = false;
+    runInThread([&]() { started = listen(address, port, backendPort, metricsPort); });
+    return started;
+}
+
+void ServerMetricsProxy::stop()
+{
+    runInThread([this]() { close(); });
+}
+
+void ServerMetricsProxy::setConnectionLimits(int connectionLimit, int ipConnectionLimit)
+{
+    runInThread([=]() {
+        m_connectionLimit = connectionLimit;
+        m_ipConnectionLimit = ipConnectionLimit;
+    });
+}
+
+quint16 ServerMetricsProxy::getMetricsPort() const
+{
+    quint16 port = 0;
+    runInThread([&]() {
+        port = m_metricsServer.isListening() ? m_metricsServer.serverPort() : 0;
+    });
+    return port;
+}
+
+ServerMetrics ServerMetricsProxy::getMetrics() const
+{
+    QMutexLocker locker(&m_metricsMutex);
+    return m_metrics;
+}
+
+bool ServerMetricsProxy::listen(const QHostAddress& address, quint16 port, quint16 backendPort, quint16 metricsPort)
+{
+    close();
+    if ( !m_server.listen(address, port) ) {
+        qWarning() << "Cannot start the local server proxy:" << m_server.errorString();
+        return false;
+    }
+    m_backendPort = backendPort;
+    {
+        QMutexLocker locker(&m_metricsMutex);
+        m_metrics.reset();
+    }
+
+    if ( metricsPort != 0 && !m_metricsServer.listen(QHostAddress::LocalHost, metricsPort) ) {
+        qWarning() << "Cannot start the metrics endpoint:" << m_metricsServer.errorString();
+    }
+    return true;
+}
+
+void ServerMetricsProxy::close()
+{
+    m_server.close();
+    m_metricsServer.close();
+    for ( const auto client : m_connections.keys() ) {
+        closeConnection(client);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Proxy
+////////////////////////////////////////////////////////////////////////////////
+
+void ServerMetricsProxy::acceptConnections()
+{
+    while ( m_connectionLimit <= 0 || m_connections.size() < m_connectionLimit ) {
+        QTcpSocket* const client = m_server.nextPendingConnection();
+        if ( !client )
+            return;
+
+        const QHostAddress clientAddress = client->peerAddress();
+        int& ipConnections = m_ipConnections[clientAddress];
+        if ( m_ipConnectionLimit > 0 && ipConnections >= m_ipConnectionLimit ) {
+            client->abort();
+            client->deleteLater();
+            continue;
+        }
+        ipConnections++;
+
+        const auto backend = new QTcpSocket(this);
+        backend->setReadBufferSize(MAX_QUEUED_BYTES);
+        m_connections.insert(client, Connection());
+        m_connections[client].backend = backend;
+        m_connections[client].clientAddress = clientAddress;
+        {
+            QMutexLocker locker(&m_metricsMutex);
+            m_metrics.connectionOpened();
+        }
+
+        connect(client, &QTcpSocket::readyRead, this, [=]() { forwardRequestData(client); });
+        connect(client, &QTcpSocket::bytesWritten, this, [=]() { forwardResponseData(client); });
+        connect(client, &QTcpSocket::disconnected, this, [=]() { closeConnection(client); });
+        connect(backend, &QTcpSocket::readyRead, this, [=]() { forwardResponseData(client); });
+        const auto backendClosed = [=]() {
+            // Whatever is left is sent regardless of the queue limit
+            const auto it = m_connections.find(client);
+            if ( it == m_connections.end() )
+                return;
+            while ( backend->bytesAvailable() > 0 ) {
+                const QByteArray data = backend->readAll();
+                parseResponses(*it, data);
+                client->write(data);
+            }
+            client->disconnectFromHost();
+        };
+        connect(backend, &QTcpSocket::disconnected, this, backendClosed);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+        connect(backend, &QTcpSocket::errorOccurred, this, backendClosed);
+#else
+        connect(backend, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error),
+                this, backendClosed);
+#endif
+
+        // Written data is buffered until the connection is established
+        backend->connectToHost(QHostAddress::LocalHost, m_backendPort);
+        forwardRequestData(client);
+    }
+
+    // Resumed by closeConnection()
+    m_server.pauseAccepting();
+}
+
+void ServerMetricsProxy::forwardRequestData(QTcpSocket* client)
+{
+    const auto it = m_connections.find(client);
+    if ( it == m_connections.end() )
+        return;
+
+    const QByteArray data = client->readAll();
+    if ( data.isEmpty() )
+        return;
+    parseRequests(*it, data);
+    it->backend->write(data);
+}
+
+void ServerMetricsProxy::forwardResponseData(QTcpSocket* client)
+{
+    const auto it = m_connections.find(client);
+    if ( it == m_connections.end() )
+        return;
+
+    const qint64 room = MAX_QUEUED_BYTES - client->bytesToWrite();
+    if ( room <= 0 )
+        return;
+    const QByteArray data = it->backend->read(room);
+    if ( data.isEmpty() )
+        return;
+    parseResponses(*it, data);
+    client->write(data);
+}
+
+void ServerMetricsProxy::closeConnection(QTcpSocket* client)
+{
+    const auto it = m_connections.find(client);
+    if ( it == m_connections.end() )
+        return;
+
+    if ( it->state == ParserState::Body && it->bodyType == BodyType::UntilClose ) {
+        finishResponse(*it);
+    }
+    QTcpSocket* const backend = it->backend;
+    const auto ipConnections = m_ipConnections.find(it->clientAddress);
+    if ( ipConnections != m_ipConnections.end() && --ipConnections.value() <= 0 ) {
+        m_ipConnections.erase(ipConnections);
+    }
+    m_connections.erase(it);
+    {
+        QMutexLocker locker(&m_metricsMutex);
+        m_metrics.connectionClosed();
+    }
+
+    disconnect(client, nullptr, this, nullptr);
+    disconnect(backend, nullptr, this, nullptr);
+    backend->abort();
+    client->abort();
+    backend->deleteLater();
+    client->deleteLater();
+
+    if ( m_server.isListening() && m_connectionLimit > 0 && m_connections.size() < m_connectionLimit ) {
+        m_server.resumeAccepting();
+        // The connections already queued by QTcpServer don't signal again
+        acceptConnections();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// HTTP parsing
+////////////////////////////////////////////////////////////////////////////////
+
+void ServerMetricsProxy::parseRequests(Connection& c, const QByteArray& data)
+{
+    QByteArray input = data;
+    while ( !input.isEmpty() ) {
+        if ( c.requestBodyLeft > 0 ) {
+            const qint64 n = std::min(c.requestBodyLeft, qint64(input.size()));
+            c.requestBodyLeft -= n;
+            input = input.mid(int(n));
+            continue;
+        }
+
+        c.requestBuffer += input;
+        input.clear();
+        const int headersEnd = c.requestBuffer.indexOf(HEADERS_END);
+        if ( headersEnd < 0 ) {
+            if ( c.requestBuffer.size() > MAX_HEADERS_SIZE ) {
+                c.requestBuffer.clear();
+            }
+            return;
+        }
+
+        const QList<QByteArray> lines = c.requestBuffer.left(headersEnd).split('\n');
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        if ( requestLine.size() == 3 ) {
+            Request request;
+            request.method = requestLine[0];
+            request.path = requestLine[1];
+            request.timer.start();
+            c.requests.enqueue(request);
+        }
+        c.requestBodyLeft = getHeaderValue(lines.mid(1), "content-length").toLongLong();
+        input = c.requestBuffer.mid(headersEnd + int(strlen(HEADERS_END)));
+        c.requestBuffer.clear();
+    }
+}
+
+void ServerMetricsProxy::parseResponses(Connection& c, const QByteArray& data)
+{
+    QByteArray input = data;
+    int pos = 0;
+    while ( pos < input.size() ) {
+        const int available = input.size() - pos;
+        switch ( c.state ) {
+        case ParserState::Headers: {
+            c.responseBuffer += input.mid(pos);
+            pos = input.size();
+            const int headersEnd = c.responseBuffer.indexOf(HEADERS_END);
+            if ( headersEnd < 0 ) {
+                if ( c.responseBuffer.size() > MAX_HEADERS_SIZE ) {
+                    // Not HTTP, stop parsing this connection
+                    c.responseBytes += c.responseBuffer.size();
+                    c.responseBuffer.clear();
+                    c.state = ParserState::Body;
+                    c.bodyType = BodyType::UntilClose;
+                }
+                break;
+            }
+            const int headersSize = headersEnd + int(strlen(HEADERS_END));
+            const QByteArray headers = c.responseBuffer.left(headersEnd);
+            input = c.responseBuffer.mid(headersSize);
+            pos = 0;
+            c.responseBuffer.clear();
+            c.responseBytes += headersSize;
+            startResponseBody(c, headers);
+            break;
+        }
+
+        case ParserState::Body:
+            if ( c.bodyType == BodyType::UntilClose ) {
+                c.responseBytes += available;
+                pos = input.size();
+                break;
+            }
+            [[fallthrough]];
+        case ParserState::ChunkData: {
+            const int n = int(std::min(c.bodyLeft, qint64(available)));
+            c.bodyLeft -= n;
+            c.responseBytes += n;
+            pos += n;
+            if ( c.bodyLeft == 0 ) {
+                if ( c.state == ParserState::Body ) {
+                    finishResponse(c);
+                } else {
+                    c.state = ParserState::ChunkSize;
+                }
+            }
+            break;
+        }
+
+        case ParserState::ChunkSize:
+        case ParserState::ChunkTrailer: {
+            const int lineEnd = input.indexOf('\n', pos);
+            if ( lineEnd < 0 ) {
+                c.responseBuffer += input.mid(pos);
+                c.responseBytes += available;
+                pos = input.size();
+                break;
+            }
+            const QByteArray line = (c.responseBuffer + input.mid(pos, lineEnd - pos)).trimmed();
+            c.responseBuffer.clear();
+            c.responseBytes += lineEnd + 1 - pos;
+            pos = lineEnd + 1;
+
+            if ( c.state == ParserState::ChunkTrailer ) {
+                if ( line.isEmpty() ) {
+                    finishResponse(c);
+                }
+                break;
+            }
+            bool ok = false;
+            const qint64 chunkSize = line.left(line.indexOf(';')).trimmed().toLongLong(&ok, 16);
+            if ( !ok ) {
+                c.state = ParserState::Body;
+                c.bodyType = BodyType::UntilClose;
+            } else if ( chunkSize == 0 ) {
+                c.state = ParserState::ChunkTrailer;
+            } else {
+                // The chunk data is followed by a CRLF
+                c.bodyLeft = chunkSize + 2;
+                c.state = ParserState::ChunkData;
+            }
+            break;
+        }
+        }
+    }
+}
+
+void ServerMetricsProxy::startResponseBody(Connection& c, const QByteArray& headers)
+{
+    const QList<QByteArray> lines = headers.split('\n');
+    const QList<QByteArray> statusLine = lines.first().trimmed().split(' ');
+    c.status = statusLine.size() >= 2 ? statusLine[1].toInt() : 0;
+    c.contentType = getHeaderValue(lines.mid(1), "content-type");
+
+    // Informational responses precede the actual response
+    if ( c.status >= 100 && c.status < 200 ) {
+        c.responseBytes = 0;
+        return;
+    }
+
+    const bool isHeadRequest = !c.requests.isEmpty() && c.requests.head().method == "HEAD";
+    const QByteArray transferEncoding = getHeaderValue(lines.mid(1), "transfer-encoding").toLower();
+    const QByteArray contentLength = getHeaderValue(lines.mid(1), "content-length");
+    if ( isHeadRequest || c.status == 204 || c.status == 304 ) {
+        finishResponse(c);
+    } else if ( transferEncoding.contains("chunked") ) {
+        c.state = ParserState::ChunkSize;
+        c.bodyType = BodyType::Chunked;
+    } else if ( !contentLength.isEmpty() ) {
+        c.bodyLeft = contentLength.toLongLong();
+        c.bodyType = BodyType::Length;
+        c.state = ParserState::Body;
+        if ( c.bodyLeft <= 0 ) {
+            finishResponse(c);
+        }
+    } else {
+        c.bodyType = BodyType::UntilClose;
+        c.state = ParserState::Body;
+    }
+}
+
+void ServerMetricsProxy::finishResponse(Connection& c)
+{
+    if ( !c.requests.isEmpty() ) {
+        const Request request = c.requests.dequeue();
+        QMutexLocker locker(&m_metricsMutex);
+        m_metrics.recordResponse(request.path, c.status, c.contentType, c.responseBytes,
+                                 request.timer.nsecsElapsed() / 1000);
+    }
+    c.state = ParserState::Headers;
+    c.bodyType = BodyType::None;
+    c.bodyLeft = 0;
+    c.status = 0;
+    c.contentType.clear();
+    c.responseBytes = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Metrics endpoint
+////////////////////////////////////////////////////////////////////////////////
+
+void ServerMetricsProxy::acceptMetricsConnections()
+{
+    while ( QTcpSocket* socket = m_metricsServer.nextPendingConnection() ) {
+        connect(socket, &QTcpSocket::readyRead, this, [=]() { replyMetrics(socket); });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void ServerMetricsProxy::replyMetrics(QTcpSocket* socket)
+{
+    if ( !socket->canReadLine() )
+        return;
+
+    const QList<QByteArray> requestLine = socket->readLine().trimmed().split(' ');
+    socket->readAll();
+    disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+
+    const bool isMetricsRequest = requestLine.size() == 3
+                               && (requestLine[0] == "GET" || requestLine[0] == "HEAD")
+                               && requestLine[1].split('?').first() == "/metrics";
+    if ( !isMetricsRequest ) {
+        socket->write("HTTP/1.1 404 Not Found\r\n"
+                      "Content-Length: 0\r\n"
+                      "Connection: close\r\n\r\n");
+        socket->disconnectFromHost();
+        return;
+    }
+
+    const QByteArray body = getMetrics().toPrometheus();
+    socket->write("HTTP/1.1 200 OK\r\n"
+                  "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                  "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                  "Connection: close\r\n\r\n");
+    if ( requestLine[0] == "GET" ) {
+        socket->write(body);
+    }
+    socket->disconnectFromHost();
+}
@@ -0,0 +1,128 @@
+#ifndef SERVERMETRICSPROXY_H
+#define SERVERMETRICSPROXY_H
+
+#include "servermetrics.h"
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QMutex>
+#include <QQueue>
+#include <QTcpServer>
+#include <QThread>
+
+#include <functional>
+
+class QTcpSocket;
+
+// HTTP proxy in front of the local Kiwix server, measuring what it serves.
+//
+// kiwix::Server offers no way to observe its requests, so it listens on a
+// loopback port and the clients connect to this proxy instead. The proxy
+// forwards the bytes unchanged in both directions and parses just enough of
+// the HTTP messages (request line, status line, message length) to time the
+// requests and count the responses.
+//
+// The proxy runs in a thread of its own, so that the traffic doesn't compete
+// with the user interface; the public functions can be called from any
+// thread. Proxying still costs a copy of every byte, and the server then sees
+// all its clients as 127.0.0.1, so it's only used when the metrics are
+// enabled (see LocalKiwixServer).
+//
+// The metrics are also served in the text format of Prometheus on a port
+// only reachable from the local host.
+class ServerMetricsProxy : public QObject
+{
+    Q_OBJECT
+
+public: // functions
+    // Has no parent, as it lives in its own thread
+    ServerMetricsProxy();
+    ~ServerMetricsProxy();
+
+    // Listens on `address:port` and forwards to `127.0.0.1:backendPort`. The
+    // metrics endpoint is not started if `metricsPort` is 0 (a failure to
+    // start it is not an error).
+    bool start(const QHostAddress& address, quint16 port, quint16 backendPort, quint16 metricsPort);
+    void stop();
+
+    // Connections accepted at the same time, in total and per client
+    // address (0 for no limit). kiwix::Server only sees connections from the
+    // proxy, so the limits are enforced here: the connections over the total
+    // wait in the backlog of the listening socket, those over the limit of
+    // their address are closed (as kiwix-serve --ipConnectionLimit does).
+    void setConnectionLimits(int connectionLimit, int ipConnectionLimit);
+
+    // Port of the metrics endpoint, 0 if it's not running
+    quint16 getMetricsPort() const;
+
+    // Copy of the current metrics
+    ServerMetrics getMetrics() const;
+
+    // A free port of the loopback interface, 0 if there is none
+    static quint16 findFreeLoopbackPort();
+
+private: // types
+    struct Request
+    {
+        QByteArray    method;
+        QByteArray    path;
+        QElapsedTimer timer;
+    };
+
+    enum class BodyType { None, Length, Chunked, UntilClose };
+    enum class ParserState { Headers, Body, ChunkSize, ChunkData, ChunkTrailer };
+
+    struct Connection
+    {
+        QTcpSocket*     backend = nullptr;
+        QHostAddress    clientAddress;
+
+        // Client -> server
+        QByteArray      requestBuffer;
+        qint64          requestBodyLeft = 0;
+        QQueue<Request> requests;
+
+        // Server -> client
+        ParserState     state = ParserState::Headers;
+        QByteArray      responseBuffer;
+        BodyType        bodyType = BodyType::None;
+        qint64          bodyLeft = 0;
+        int             status = 0;
+        QByteArray      contentType;
+        qint64          responseBytes = 0;
+    };
+
+private: // functions
+    // Runs the function in the thread of the proxy and waits for it
+    void runInThread(const std::function<void()>& function) const;
+    bool listen(const QHostAddress& address, quint16 port, quint16 backendPort, quint16 metricsPort);
+    void close();
+
+    void acceptConnections();
+    void forwardRequestData(QTcpSocket* client);
+    void forwardResponseData(QTcpSocket* client);
+    void parseRequests(Connection& c, const QByteArray& data);
+    void parseResponses(Connection& c, const QByteArray& data);
+    void startResponseBody(Connection& c, const QByteArray& headers);
+    void finishResponse(Connection& c);
+    void closeConnection(QTcpSocket* client);
+
+    void acceptMetricsConnections();
+    void replyMetrics(QTcpSocket* socket);
+
+private: // data
+    QThread       m_thread;
+    QTcpServer    m_server;
+    QTcpServer    m_metricsServer;
+    quint16       m_backendPort = 0;
+    ServerMetrics m_metrics;
+    mutable QMutex m_metricsMutex;
+    QHash<QTcpSocket*, Connection> m_connections; // by client socket
+    QHash<QHostAddress, int> m_ipConnections;     // count by client address
+    int           m_connectionLimit = 0;
+    int           m_ipConnectionLimit = 0;
+};
+
+#endif // SERVERMETRICSPROXY_H
@@ -0,0 +1,319 @@
+#include "serverprocess.h"
+#include "kiwixapp.h"
+#include "contentcache.h"
+#include "servertuning.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFileSystemWatcher>
+
+#include <kiwix/manager.h>
+#include <kiwix/name_mapper.h>
+#include <kiwix/server.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#endif
+
+namespace
+{
+
+const char SERVE_LIBRARY_OPTION[] = "--serve-library";
+
+// Printed by the child once the server accepts connections
+const char READY_MESSAGE[] = "ready";
+
+const int STARTUP_TIMEOUT_MS = 10000;
+const int SHUTDOWN_TIMEOUT_MS = 3000;
+
+// Delays before restarting a crashed server: doubled at every crash and
+// reset once the server has been running for a while
+const int MIN_RESTART_DELAY_MS = 1000;
+const int MAX_RESTART_DELAY_MS = 30000;
+const qint64 STABLE_UPTIME_MS = 60000;
+
+// Changes of library.xml are applied once it hasn't changed for that long
+const int LIBRARY_RELOAD_DELAY_MS = 1000;
+
+const qint64 MiB = 1024 * 1024;
+
+const char* const IP_MODE_NAMES[] = { "ipv4", "ipv6", "all", "auto" };
+const kiwix::IpMode IP_MODES[] = {
+    kiwix::IpMode::IPV4, kiwix::IpMode::IPV6, kiwix::IpMode::ALL, kiwix::IpMode::AUTO
+};
+
+QString getIpModeName(kiwix::IpMode ipMode)
+{
+    for ( size_t i = 0; i < std::size(IP_MODES); ++i ) {
+        if ( IP_MODES[i] == ipMode )
+            return IP_MODE_NAMES[i];
+    }
+    return "auto";
+}
+
+kiwix::IpMode getIpMode(const QString& name)
+{
+    for ( size_t i = 0; i < std::size(IP_MODES); ++i ) {
+        if ( name == IP_MODE_NAMES[i] )
+            return IP_MODES[i];
+    }
+    return kiwix::IpMode::AUTO;
+}
+
+void applyResourceLimits(int cpus, int memoryLimit)
+{
+#ifdef Q_OS_LINUX
+    if ( cpus > 0 ) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        for ( int i = 0; i < cpus && i < CPU_SETSIZE; ++i ) {
+            CPU_SET(i, &cpuSet);
+        }
+        if ( sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0 ) {
+            qWarning() << "Cannot restrict the server to" << cpus << "CPUs";
+        }
+    }
+#else
+    if ( cpus > 0 ) {
+        qWarning() << "Restricting the CPUs of the server is not supported on this platform";
+    }
+#endif
+
+#ifdef Q_OS_UNIX
+    if ( memoryLimit > 0 ) {
+        struct rlimit limit;
+        limit.rlim_cur = limit.rlim_max = rlim_t(memoryLimit) * MiB;
+        if ( setrlimit(RLIMIT_AS, &limit) != 0 ) {
+            qWarning() << "Cannot limit the memory of the server to" << memoryLimit << "MiB";
+        }
+    }
+#else
+    if ( memoryLimit > 0 ) {
+        qWarning() << "Limiting the memory of the server is not supported on this platform";
+    }
+#endif
+}
+
+} // unnamed namespace
+
+ServerProcess::ServerProcess(QObject* parent)
+    : QObject(parent)
+{
+    // The server logs go to our own output
+    m_process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    connect(&m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &ServerProcess::onFinished);
+    connect(&m_process, &QProcess::readyReadStandardOutput, this, &ServerProcess::readOutput);
+    connect(&m_process, &QProcess::errorOccurred, this, [=](QProcess::ProcessError error) {
+        if ( error == QProcess::FailedToStart ) {
+            startupFailed();
+        }
+    });
+
+    m_startupTimer.setSingleShot(true);
+    connect(&m_startupTimer, &QTimer::timeout, this, &ServerProcess::startupFailed);
+    m_restartTimer.setSingleShot(true);
+    connect(&m_restartTimer, &QTimer::timeout, this, &ServerProcess::launch);
+}
+
+ServerProcess::~ServerProcess()
+{
+    stop();
+}
+
+bool ServerProcess::isServerCommandLine(int argc, char* argv[])
+{
+    for ( int i = 1; i < argc; ++i ) {
+        if ( strcmp(argv[i], SERVE_LIBRARY_OPTION) == 0 )
+            return true;
+    }
+    return false;
+}
+
+void ServerProcess::start(const QString& libraryPath, const QString& address, kiwix::IpMode ipMode,
+                          quint16 port, int ipConnectionLimit)
+{
+    stop();
+
+    const auto settingsManager = KiwixApp::instance()->getSettingsManager();
+    const auto tuning = ServerTuning::get(*settingsManager);
+    m_arguments = QStringList{
+        SERVE_LIBRARY_OPTION, libraryPath,
+        "--address", address,
+        "--ip-mode", getIpModeName(ipMode),
+        "--port", QString::number(port),
+        "--ip-connection-limit", QString::number(ipConnectionLimit),
+        "--threads", QString::number(tuning.threads),
+        "--cpus", QString::number(settingsManager->getKiwixServerProcessCpus()),
+        "--memory-limit", QString::number(settingsManager->getKiwixServerProcessMemoryLimit()),
+        "--cache-size", QString::number(ServerTuning::getCacheSize(*settingsManager))
+    };
+
+    m_starting = true;
+    m_startupTimer.start(STARTUP_TIMEOUT_MS);
+    m_process.start(QCoreApplication::applicationFilePath(), m_arguments);
+}
+
+void ServerProcess::readOutput()
+{
+    // Only the startup message is of interest
+    while ( m_process.canReadLine() ) {
+        const QByteArray line = m_process.readLine().trimmed();
+        if ( m_starting && line == READY_MESSAGE ) {
+            m_starting = false;
+            m_startupTimer.stop();
+            m_running = true;
+            m_restartDelay = MIN_RESTART_DELAY_MS;
+            m_uptime.start();
+            emit(started(true));
+        }
+    }
+}
+
+void ServerProcess::startupFailed()
+{
+    if ( !m_starting )
+        return;
+
+    qWarning() << "The server process failed to start";
+    m_starting = false;
+    m_startupTimer.stop();
+    // onFinished() ignores the end of the process as it isn't running
+    m_process.kill();
+    emit(started(false));
+}
+
+void ServerProcess::stop()
+{
+    m_starting = false;
+    m_running = false;
+    m_startupTimer.stop();
+    m_restartTimer.stop();
+    if ( m_process.state() == QProcess::NotRunning )
+        return;
+
+    // The server exits when its standard input is closed
+    m_process.closeWriteChannel();
+    if ( !m_process.waitForFinished(SHUTDOWN_TIMEOUT_MS) ) {
+        m_process.kill();
+        m_process.waitForFinished(SHUTDOWN_TIMEOUT_MS);
+    }
+}
+
+void ServerProcess::launch()
+{
+    if ( !m_running )
+        return;
+
+    qInfo() << "Restarting the server process";
+    m_uptime.start();
+    m_process.start(QCoreApplication::applicationFilePath(), m_arguments);
+}
+
+void ServerProcess::onFinished()
+{
+    if ( m_starting ) {
+        startupFailed();
+        return;
+    }
+    if ( !m_running )
+        return;
+
+    if ( m_uptime.elapsed() > STABLE_UPTIME_MS ) {
+        m_restartDelay = MIN_RESTART_DELAY_MS;
+    }
+    qWarning() << "The server process exited unexpectedly (exit code" << m_process.exitCode()
+               << "), restarting it in" << m_restartDelay << "ms";
+    m_restartTimer.start(m_restartDelay);
+    m_restartDelay = std::min(2 * m_restartDelay, MAX_RESTART_DELAY_MS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Child process
+////////////////////////////////////////////////////////////////////////////////
+
+int runLibraryServer(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    const QCommandLineOption libraryOption(QString(SERVE_LIBRARY_OPTION).mid(2), "Library to serve.", "path");
+    const QCommandLineOption addressOption("address", "Address to listen on (all the addresses of the IP mode if empty).", "address");
+    const QCommandLineOption ipModeOption("ip-mode", "ipv4, ipv6, all or auto.", "mode", "auto");
+    const QCommandLineOption portOption("port", "Port to listen on.", "port");
+    const QCommandLineOption ipConnectionLimitOption("ip-connection-limit", "Connections per client address (0 for no limit).", "count", "0");
+    const QCommandLineOption threadsOption("threads", "Number of worker threads (0 for the default).", "count", "0");
+    const QCommandLineOption cpusOption("cpus", "Number of CPUs to run on (0 for all).", "count", "0");
+    const QCommandLineOption memoryOption("memory-limit", "Memory limit in MiB (0 for none).", "MiB", "0");
+    const QCommandLineOption cacheOption("cache-size", "Content cache size in MiB (0 for the default).", "MiB", "0");
+    parser.addOptions({libraryOption, addressOption, ipModeOption, portOption, ipConnectionLimitOption,
+                       threadsOption, cpusOption, memoryOption, cacheOption});
+    parser.process(app);
+
+    applyResourceLimits(parser.value(cpusOption).toInt(), parser.value(memoryOption).toInt());
+    // Only the cluster cache is of use here
+    ContentCache contentCache;
+    contentCache.setBudget(parser.value(cacheOption).toLongLong() * MiB);
+
+    const std::string libraryPath = parser.value(libraryOption).toStdString();
+    const auto library = kiwix::Library::create();
+    kiwix::Manager(library).readFile(libraryPath, true, true);
+    const auto nameMapper = std::make_shared<kiwix::UpdatableNameMapper>(library, false);
+
+    kiwix::Server server(library, nameMapper);
+    server.setAddress(parser.value(addressOption).toStdString());
+    server.setIpMode(getIpMode(parser.value(ipModeOption)));
+    server.setPort(parser.value(portOption).toInt());
+    server.setIpConnectionLimit(parser.value(ipConnectionLimitOption).toInt());
+    if ( const int threads = parser.value(threadsOption).toInt() ) {
+        server.setNbThreads(threads);
+    }
+    if ( !server.start() ) {
+        std::cerr << "Cannot start the server" << std::endl;
+        return 1;
+    }
+    std::cout << READY_MESSAGE << std::endl;
+
+    // Same as kiwix-serve --monitorLibrary
+    QFileSystemWatcher watcher({parser.value(libraryOption)});
+    QTimer reloadTimer;
+    reloadTimer.setSingleShot(true);
+    reloadTimer.setInterval(LIBRARY_RELOAD_DELAY_MS);
+    QObject::connect(&watcher, &QFileSystemWatcher::fileChanged, &reloadTimer, [&]() {
+        // The file is replaced rather than modified in place
+        if ( !watcher.files().contains(parser.value(libraryOption)) ) {
+            watcher.addPath(parser.value(libraryOption));
+        }
+        reloadTimer.start();
+    });
+    QObject::connect(&reloadTimer, &QTimer::timeout, [&]() {
+        const auto revision = library->getRevision();
+        if ( kiwix::Manager(library).readFile(libraryPath, true, true) ) {
+            library->removeBooksNotUpdatedSince(revision);
+            nameMapper->update();
+        }
+    });
+
+    // The parent closes our standard input to stop us, it's also closed if
+    // the parent dies
+    std::thread([&app]() {
+        std::string line;
+        while ( std::getline(std::cin, line) ) {}
+        QMetaObject::invokeMethod(&app, "quit", Qt::QueuedConnection);
+    }).detach();
+
+    const int result = app.exec();
+    server.stop();
+    return result;
+}
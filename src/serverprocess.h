@@ -0,0 +1,65 @@
+#ifndef SERVERPROCESS_H
+#define SERVERPROCESS_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QTimer>
+
+#include <kiwix/server.h>
+
+// Runs the local Kiwix server in a child process, so that the load of its
+// clients doesn't slow down the user interface.
+//
+// The child is kiwix-desktop itself, started with --serve-library (see
+// runLibraryServer()). It serves the books of library.xml, which it reloads
+// when the file changes, on the address given (a loopback one when the
+// clients connect through ServerMetricsProxy). Its worker threads, the CPUs
+// it may run on and its memory can be limited through the settings. The
+// process is restarted when it exits unexpectedly, with a delay growing if it
+// keeps crashing.
+class ServerProcess : public QObject
+{
+    Q_OBJECT
+
+public: // functions
+    explicit ServerProcess(QObject* parent = nullptr);
+    ~ServerProcess();
+
+    // Starts the server on address:port (all the addresses of ipMode if
+    // address is empty) without waiting for it, started() is emitted once it
+    // accepts connections
+    void start(const QString& libraryPath, const QString& address, kiwix::IpMode ipMode,
+               quint16 port, int ipConnectionLimit);
+    void stop();
+    bool isRunning() const { return m_running; }
+
+    // True if the arguments of the process start a server instead of the
+    // application
+    static bool isServerCommandLine(int argc, char* argv[]);
+
+signals:
+    // success is false if the server couldn't be started
+    void started(bool success);
+
+private: // functions
+    void launch();
+    void readOutput();
+    void onFinished();
+    void startupFailed();
+
+private: // data
+    QProcess      m_process;
+    QStringList   m_arguments;
+    bool          m_starting = false;
+    bool          m_running = false;
+    QTimer        m_startupTimer;
+    int           m_restartDelay = 0;
+    QElapsedTimer m_uptime;
+    QTimer        m_restartTimer;
+};
+
+// Entry point of the child process
+int runLibraryServer(int argc, char* argv[]);
+
+#endif // SERVERPROCESS_H
@@ -0,0 +1,145 @@
+#include "servertuning.h"
+#include "settingsmanager.h"
+
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+const int BENCHMARK_BUFFER_SIZE = 256 * 1024;
+const int BENCHMARK_ROUNDS = 32;
+
+const int MAX_THREADS = 64;
+
+// Connections mostly wait for the next request of their client (keep-alive)
+const int CONNECTIONS_PER_THREAD = 16;
+const int MIN_CONNECTION_LIMIT = 64;
+// Browsers open up to 6 connections per host
+const int MIN_IP_CONNECTION_LIMIT = 8;
+
+const qint64 MiB = 1024 * 1024;
+const int MIN_CACHE_SIZE = 64;
+const int MAX_CACHE_SIZE = 1024;
+
+qint64 runBenchmarkRounds(const QByteArray& buffer)
+{
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray digest = buffer.left(32);
+    for ( int i = 0; i < BENCHMARK_ROUNDS; ++i ) {
+        // Depends on the previous round so that it cannot be optimized away
+        digest = QCryptographicHash::hash(buffer + digest, QCryptographicHash::Sha1);
+    }
+    return std::max(timer.nsecsElapsed(), qint64(1));
+}
+
+// Number of cores running the same work in parallel without slowing down
+int measureParallelCores()
+{
+    const int cores = std::max(1, int(std::thread::hardware_concurrency()));
+    const QByteArray buffer(BENCHMARK_BUFFER_SIZE, 'k');
+    runBenchmarkRounds(buffer); // warm up
+    const qint64 singleTime = runBenchmarkRounds(buffer);
+    if ( cores == 1 )
+        return 1;
+
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<std::thread> threads;
+    for ( int i = 0; i < cores; ++i ) {
+        threads.emplace_back([&buffer]() { runBenchmarkRounds(buffer); });
+    }
+    for ( auto& thread : threads ) {
+        thread.join();
+    }
+    const double speedup = double(cores) * singleTime / std::max(timer.nsecsElapsed(), qint64(1));
+    return std::max(1, std::min(cores, int(std::lround(speedup))));
+}
+
+qint64 getPhysicalMemory()
+{
+#ifdef Q_OS_LINUX
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    return pages > 0 && pageSize > 0 ? qint64(pages) * pageSize : 0;
+#else
+    return 0;
+#endif
+}
+
+ServerTuning autotune()
+{
+    ServerTuning tuning;
+    // Serving also waits for the disk, hence more threads than cores
+    tuning.threads = std::min(MAX_THREADS, 2 * measureParallelCores());
+    tuning.connectionLimit = std::max(MIN_CONNECTION_LIMIT, tuning.threads * CONNECTIONS_PER_THREAD);
+    tuning.ipConnectionLimit = std::max(MIN_IP_CONNECTION_LIMIT, tuning.connectionLimit / 4);
+    return tuning;
+}
+
+} // unnamed namespace
+
+ServerTuning ServerTuning::get(const SettingsManager& settings)
+{
+    ServerTuning tuning;
+    tuning.threads = settings.getKiwixServerThreads();
+    tuning.connectionLimit = settings.getKiwixServerConnectionLimit();
+    tuning.ipConnectionLimit = settings.getKiwixServerIpConnectionLimit();
+    if ( !settings.getKiwixServerAutotune() )
+        return tuning;
+
+    static const ServerTuning autotuned = autotune();
+    if ( tuning.threads == 0 ) {
+        tuning.threads = autotuned.threads;
+    }
+    if ( tuning.connectionLimit == 0 ) {
+        tuning.connectionLimit = autotuned.connectionLimit;
+    }
+    if ( tuning.ipConnectionLimit == 0 ) {
+        tuning.ipConnectionLimit = autotuned.ipConnectionLimit;
+    }
+    return tuning;
+}
+
+ServerTuning ServerTuning::getApplied(const SettingsManager& settings)
+{
+    ServerTuning tuning = get(settings);
+    if ( !settings.getKiwixServerMetrics() ) {
+        // kiwix::Server has no total limit, only the metrics proxy has one
+        tuning.connectionLimit = 0;
+    }
+    return tuning;
+}
+
+int ServerTuning::getCacheSize(const SettingsManager& settings)
+{
+    const int cacheSize = settings.getContentCacheSize();
+    if ( cacheSize != 0 || !settings.getKiwixServerAutotune() )
+        return cacheSize;
+
+    const qint64 memory = getPhysicalMemory();
+    if ( memory == 0 )
+        return 0;
+    return int(std::max(qint64(MIN_CACHE_SIZE), std::min(qint64(MAX_CACHE_SIZE), memory / 64 / MiB)));
+}
+
+QString ServerTuning::toString() const
+{
+    const auto format = [](int value, const char* none) {
+        return value == 0 ? QString(none) : QString::number(value);
+    };
+    return QString("%1 threads, %2 connections, %3 connections per address")
+           .arg(format(threads, "default"))
+           .arg(format(connectionLimit, "unlimited"))
+           .arg(format(ipConnectionLimit, "unlimited"));
+}
@@ -0,0 +1,38 @@
+#ifndef SERVERTUNING_H
+#define SERVERTUNING_H
+
+#include <QString>
+
+class SettingsManager;
+
+// Sizing of the local Kiwix server.
+//
+// The values come from the settings. When autotuning is enabled, those left
+// to 0 are chosen from the host: the number of cores that actually run in
+// parallel (measured by a short benchmark, as containers, SMT and power
+// saving make the core count misleading) and the physical memory.
+struct ServerTuning
+{
+    // Worker threads of kiwix::Server, 0 for its default
+    int threads = 0;
+    // Connections accepted at the same time, in total and per client
+    // address (0 for no limit). Further connections wait in the backlog of
+    // the listening socket, or are refused when over the per address limit.
+    // The total limit is only enforced by ServerMetricsProxy, hence when the
+    // load of the server is measured.
+    int connectionLimit = 0;
+    int ipConnectionLimit = 0;
+
+    // The first call with autotuning enabled runs the benchmark (about 100 ms)
+    static ServerTuning get(const SettingsManager& settings);
+    // Like get(), without the limits that aren't enforced with the settings
+    // (what the local server actually applies)
+    static ServerTuning getApplied(const SettingsManager& settings);
+
+    // Memory (in MiB) of the ContentCache, 0 for the default of libzim
+    static int getCacheSize(const SettingsManager& settings);
+
+    QString toString() const;
+};
+
+#endif // SERVERTUNING_H
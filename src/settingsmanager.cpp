@@ -85,12 +85,7 @@ QVariant SettingsManager::getSettings(const QString &key)
 
 qreal SettingsManager::getZoomFactorByZimId(const QString &id)
 {
-    auto zoomFactor = m_zoomFactor;
-    QString key = id + "/zoomFactor";
-    if (settingsExists(key)) {
-        zoomFactor = getSettings(key).toDouble();
-    }
-    return zoomFactor;
+    return m_settings.value(id + "/zoomFactor", m_zoomFactor).toDouble();
 }
 
 void SettingsManager::setKiwixServerPort(int port)
@@ -195,8 +190,31 @@ void SettingsManager::initSettings()
     m_kiwixServerPort = m_settings.value("localKiwixServer/port", 8080).toInt();
     m_zoomFactor = m_settings.value("view/zoomFactor", 1).toDouble();
     m_kiwixServerIpAddress = m_settings.value("localKiwixServer/ipAddress", QString("0.0.0.0")).toString();
+    m_kiwixServerMetrics = m_settings.value("localKiwixServer/metrics", false).toBool();
+    m_kiwixServerMetricsPort = m_settings.value("localKiwixServer/metricsPort", 9464).toInt();
+    m_kiwixServerOutOfProcess = m_settings.value("localKiwixServer/outOfProcess", false).toBool();
+    m_kiwixServerThreads = m_settings.value("localKiwixServer/threads", 0).toInt();
+    m_kiwixServerProcessCpus = m_settings.value("localKiwixServer/processCpus", 0).toInt();
+    m_kiwixServerProcessMemoryLimit = m_settings.value("localKiwixServer/processMemoryLimit", 0).toInt();
+    m_kiwixServerConnectionLimit = m_settings.value("localKiwixServer/connectionLimit", 0).toInt();
+    m_kiwixServerIpConnectionLimit = m_settings.value("localKiwixServer/ipConnectionLimit", 0).toInt();
+    m_kiwixServerAutotune = m_settings.value("localKiwixServer/autotune", false).toBool();
     m_moveToTrash = m_settings.value("moveToTrash", true).toBool();
     m_reopenTab = m_settings.value("reopenTab", false).toBool();
+
+    // Sharing of books with other instances on the local network can also
+    // be enabled/disabled with the KIWIX_PEER_SHARING environment variable
+    const char* const peerSharingEnvVar = getenv("KIWIX_PEER_SHARING");
+    m_peerSharing = peerSharingEnvVar
+                  ? atoi(peerSharingEnvVar) != 0
+                  : m_settings.value("peerSharing/enabled", false).toBool();
+    m_multiZimSuggestions = m_settings.value("suggestions/multiZim", QString("")).toString();
+    m_suggestionBooks = m_settings.value("suggestions/books", QStringList()).toStringList();
+    m_sidecarIndexing = m_settings.value("fulltextIndexing/enabled", false).toBool();
+    m_tabFreezeDelay = m_settings.value("tabs/freezeDelay", 5 * 60).toInt();
+    m_tabDiscardDelay = m_settings.value("tabs/discardDelay", 30 * 60).toInt();
+    m_tabMemoryLimit = m_settings.value("tabs/memoryLimit", 0).toInt();
+    m_contentCacheSize = m_settings.value("contentCache/size", 0).toInt();
     QString defaultLang = QLocale::languageToString(QLocale().language()) + '|' + QLocale().name().split("_").at(0);
 
     /*
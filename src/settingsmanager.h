@@ -2,8 +2,8 @@
 #define SETTINGSMANAGER_H
 
 #include <QObject>
-#include <QSettings>
 #include "settingsview.h"
+#include "settingsstore.h"
 
 class SettingsManager : public QObject
 {
@@ -25,11 +25,49 @@ public:
     qreal getZoomFactorByZimId(const QString &id);
     int getKiwixServerPort() const { return m_kiwixServerPort; }
     QString getKiwixServerIpAddress() const { return m_kiwixServerIpAddress; }
+    // Whether the load of the local server is measured (through
+    // ServerMetricsProxy), and the loopback port of its metrics endpoint (0 to
+    // disable)
+    bool getKiwixServerMetrics() const { return m_kiwixServerMetrics; }
+    int getKiwixServerMetricsPort() const { return m_kiwixServerMetricsPort; }
+    // Whether the local server runs in a child process, with that many
+    // worker threads (0 for the default), CPUs (0 for all) and MiB of memory
+    // (0 for no limit)
+    bool getKiwixServerOutOfProcess() const { return m_kiwixServerOutOfProcess; }
+    int getKiwixServerThreads() const { return m_kiwixServerThreads; }
+    int getKiwixServerProcessCpus() const { return m_kiwixServerProcessCpus; }
+    int getKiwixServerProcessMemoryLimit() const { return m_kiwixServerProcessMemoryLimit; }
+    // Connections accepted by the local server at the same time, in total
+    // (only enforced when the load is measured, see getKiwixServerMetrics())
+    // and per client address (0 for no limit)
+    int getKiwixServerConnectionLimit() const { return m_kiwixServerConnectionLimit; }
+    int getKiwixServerIpConnectionLimit() const { return m_kiwixServerIpConnectionLimit; }
+    // Whether the sizes of the local server (and of the content cache) left
+    // to 0 are chosen from the host (see ServerTuning)
+    bool getKiwixServerAutotune() const { return m_kiwixServerAutotune; }
     qreal getZoomFactor() const { return m_zoomFactor; }
     QString getDownloadDir() const { return m_downloadDir; }
     QString getMonitorDir() const { return m_monitorDir; }
     bool getMoveToTrash() const { return m_moveToTrash; }
     bool getReopenTab() const { return m_reopenTab; }
+    bool getPeerSharing() const { return m_peerSharing; }
+    // Books whose titles are also suggested in the search bar: none (""),
+    // those open in tabs ("openTabs"), those listed in getSuggestionBooks()
+    // ("books") or all the local books, through their title index ("library")
+    QString getMultiZimSuggestions() const { return m_multiZimSuggestions; }
+    QStringList getSuggestionBooks() const { return m_suggestionBooks; }
+    // Whether fulltext indexes are built for the books lacking one (opt-in,
+    // as it is CPU and disk intensive)
+    bool getSidecarIndexing() const { return m_sidecarIndexing; }
+    // Background tabs are frozen, then discarded, after these delays (in
+    // seconds, 0 for never) or when the memory used exceeds the limit (in MiB,
+    // 0 for no limit)
+    int getTabFreezeDelay() const { return m_tabFreezeDelay; }
+    int getTabDiscardDelay() const { return m_tabDiscardDelay; }
+    int getTabMemoryLimit() const { return m_tabMemoryLimit; }
+    // Memory (in MiB) for the decoded content of the books, 0 for the
+    // default of libzim (see ContentCache)
+    int getContentCacheSize() const { return m_contentCacheSize; }
     FilterList getLanguageList() { return deducePair(m_langList); }
     QStringList getCategoryList() { return m_categoryList; }
     FilterList getContentType() { return deducePair(m_contentTypeList); }
@@ -63,15 +101,32 @@ signals:
     void contentTypeChanged(QList<QVariant> contentTypeList);
 
 private:
-    QSettings m_settings;
+    SettingsStore m_settings;
     SettingsView *m_view;
     int m_kiwixServerPort;
     QString m_kiwixServerIpAddress;
+    bool m_kiwixServerMetrics;
+    int m_kiwixServerMetricsPort;
+    bool m_kiwixServerOutOfProcess;
+    int m_kiwixServerThreads;
+    int m_kiwixServerProcessCpus;
+    int m_kiwixServerProcessMemoryLimit;
+    int m_kiwixServerConnectionLimit;
+    int m_kiwixServerIpConnectionLimit;
+    bool m_kiwixServerAutotune;
     qreal m_zoomFactor;
     QString m_downloadDir;
     QString m_monitorDir;
     bool m_moveToTrash;
     bool m_reopenTab;
+    bool m_peerSharing;
+    QString m_multiZimSuggestions;
+    QStringList m_suggestionBooks;
+    bool m_sidecarIndexing;
+    int m_tabFreezeDelay;
+    int m_tabDiscardDelay;
+    int m_tabMemoryLimit;
+    int m_contentCacheSize;
     QList<QVariant> m_langList;
     QStringList m_categoryList;
     QList<QVariant> m_contentTypeList;
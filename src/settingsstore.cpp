@@ -0,0 +1,136 @@
+#include "settingsstore.h"
+
+#include <QDebug>
+#include <QtConcurrent/QtConcurrent>
+
+namespace
+{
+
+// Changes are written once no other change has been made for that long
+const int FLUSH_DELAY_MS = 1000;
+
+bool isKeyUnder(const QString& key, const QString& group)
+{
+    return key == group || key.startsWith(group + "/");
+}
+
+} // unnamed namespace
+
+SettingsStore::SettingsStore(const QString& fileName, QSettings::Format format, QObject* parent)
+    : QObject(parent),
+      m_fileName(fileName),
+      m_format(format)
+{
+    const QSettings backend(fileName, format);
+    for ( const auto& key : backend.allKeys() ) {
+        m_values.insert(key, backend.value(key));
+    }
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FLUSH_DELAY_MS);
+    connect(&m_flushTimer, &QTimer::timeout, this, &SettingsStore::startFlush);
+    // Changes made while a write was running
+    connect(&m_flushWatcher, &QFutureWatcher<void>::finished, this, [=]() {
+        if ( !m_removedKeys.isEmpty() || !m_changedValues.isEmpty() ) {
+            m_flushTimer.start();
+        }
+    });
+}
+
+SettingsStore::~SettingsStore()
+{
+    flush();
+}
+
+QVariant SettingsStore::value(const QString& key, const QVariant& defaultValue) const
+{
+    return m_values.value(key, defaultValue);
+}
+
+bool SettingsStore::contains(const QString& key) const
+{
+    return m_values.contains(key);
+}
+
+void SettingsStore::setValue(const QString& key, const QVariant& value)
+{
+    const auto it = m_values.constFind(key);
+    if ( it != m_values.constEnd() && *it == value )
+        return;
+
+    m_values.insert(key, value);
+    m_changedValues.insert(key, value);
+    m_flushTimer.start();
+}
+
+void SettingsStore::remove(const QString& key)
+{
+    bool removed = false;
+    for ( auto it = m_values.begin(); it != m_values.end(); ) {
+        if ( isKeyUnder(it.key(), key) ) {
+            it = m_values.erase(it);
+            removed = true;
+        } else {
+            ++it;
+        }
+    }
+    if ( !removed )
+        return;
+
+    for ( auto it = m_changedValues.begin(); it != m_changedValues.end(); ) {
+        if ( isKeyUnder(it.key(), key) ) {
+            it = m_changedValues.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_removedKeys.insert(key);
+    m_flushTimer.start();
+}
+
+void SettingsStore::flush()
+{
+    m_flushTimer.stop();
+    m_flushWatcher.waitForFinished();
+    writeChanges(m_fileName, m_format, m_removedKeys, m_changedValues);
+    m_removedKeys.clear();
+    m_changedValues.clear();
+}
+
+void SettingsStore::startFlush()
+{
+    if ( m_flushWatcher.isRunning() ) {
+        // Restarted once the running write has finished
+        return;
+    }
+    if ( m_removedKeys.isEmpty() && m_changedValues.isEmpty() )
+        return;
+
+    const auto removedKeys = m_removedKeys;
+    const auto changedValues = m_changedValues;
+    m_removedKeys.clear();
+    m_changedValues.clear();
+    m_flushWatcher.setFuture(QtConcurrent::run(&SettingsStore::writeChanges,
+                                               m_fileName, m_format,
+                                               removedKeys, changedValues));
+}
+
+void SettingsStore::writeChanges(const QString& fileName, QSettings::Format format,
+                                 const QSet<QString>& removedKeys,
+                                 const QMap<QString, QVariant>& changedValues)
+{
+    if ( removedKeys.isEmpty() && changedValues.isEmpty() )
+        return;
+
+    QSettings backend(fileName, format);
+    for ( const auto& key : removedKeys ) {
+        backend.remove(key);
+    }
+    for ( auto it = changedValues.constBegin(); it != changedValues.constEnd(); ++it ) {
+        backend.setValue(it.key(), it.value());
+    }
+    backend.sync();
+    if ( backend.status() != QSettings::NoError ) {
+        qWarning() << "Cannot write the settings to" << fileName;
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef SETTINGSSTORE_H
+#define SETTINGSSTORE_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QMap>
+#include <QSet>
+#include <QSettings>
+#include <QTimer>
+#include <QVariant>
+
+// In-memory front of a QSettings file.
+//
+// All the values are loaded when the store is created, so reading a value
+// never touches the backend. Changes are applied to memory immediately and
+// written to the backend in a background thread once no change has been made
+// for a short while (several changes in a row result in a single write). The
+// file is replaced atomically by QSettings, so a crash during a write leaves
+// the previous version intact. Pending changes are written synchronously when
+// the store is destroyed.
+//
+// The store must only be used from the thread it was created in.
+class SettingsStore : public QObject
+{
+    Q_OBJECT
+
+public: // functions
+    SettingsStore(const QString& fileName, QSettings::Format format, QObject* parent = nullptr);
+    ~SettingsStore();
+
+    QVariant value(const QString& key, const QVariant& defaultValue = QVariant()) const;
+    bool contains(const QString& key) const;
+    void setValue(const QString& key, const QVariant& value);
+
+    // Like QSettings::remove(), also removes the keys under `key`
+    void remove(const QString& key);
+
+    // Writes the pending changes now and waits for the write to complete
+    void flush();
+
+private: // functions
+    void startFlush();
+
+    // Each write uses its own QSettings object, created in the thread doing
+    // the write, as a QSettings object is not thread-safe.
+    static void writeChanges(const QString& fileName, QSettings::Format format,
+                             const QSet<QString>& removedKeys,
+                             const QMap<QString, QVariant>& changedValues);
+
+private: // data
+    const QString m_fileName;
+    const QSettings::Format m_format;
+    QMap<QString, QVariant> m_values;
+
+    // Changes not written yet. The removals are applied before the values,
+    // setValue() after remove() being recorded as a changed value only.
+    QSet<QString> m_removedKeys;
+    QMap<QString, QVariant> m_changedValues;
+
+    QTimer m_flushTimer;
+    QFutureWatcher<void> m_flushWatcher;
+};
+
+#endif // SETTINGSSTORE_H
@@ -0,0 +1,427 @@
+#include "sidecarindexer.h"
+#include "library.h"
+
+#include <zim/archive.h>
+#include <zim/entry.h>
+#include <zim/item.h>
+#include <xapian.h>
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// The library changes in bursts (e.g. when a directory is scanned)
+const int UPDATE_DELAY_MS = 10000;
+
+// Number of entries whose text is extracted in parallel
+const zim::entry_index_type BATCH_SIZE = 256;
+
+// Number of entries between two checkpoints
+const zim::entry_index_type COMMIT_INTERVAL = 4096;
+
+// Cap on the amount of data read from the archives
+const qint64 MAX_READ_RATE = 8 * 1024 * 1024; // bytes/s
+
+// Text kept with each document to build the snippets of the results
+const size_t EXCERPT_LENGTH = 1024;
+
+const Xapian::valueno TITLE_VALUE = 0;
+const Xapian::valueno EXCERPT_VALUE = 1;
+
+const std::string NEXT_ENTRY_KEY = "kiwix-desktop:nextEntry";
+const std::string COMPLETE_KEY = "kiwix-desktop:complete";
+const std::string LANGUAGE_KEY = "kiwix-desktop:language";
+const std::string STEMMER_KEY = "kiwix-desktop:stemmer";
+
+struct ExtractedEntry
+{
+    bool        indexable = false;
+    qint64      size = 0;
+    std::string path;
+    std::string title;
+    std::string text;
+};
+
+bool startsWithTag(const std::string& html, size_t pos, const char* tag)
+{
+    const size_t length = strlen(tag);
+    if (html.size() < pos + length + 1)
+        return false;
+    for (size_t i = 0; i < length; ++i) {
+        if (tolower(static_cast<unsigned char>(html[pos + i])) != tag[i])
+            return false;
+    }
+    const char next = html[pos + length];
+    return next == '>' || next == '/' || isspace(static_cast<unsigned char>(next));
+}
+
+void appendEntity(const std::string& entity, std::string* text)
+{
+    if (entity == "amp") *text += '&';
+    else if (entity == "lt") *text += '<';
+    else if (entity == "gt") *text += '>';
+    else if (entity == "quot") *text += '"';
+    else if (entity == "apos" || entity == "#39") *text += '\'';
+    else *text += ' ';
+}
+
+// Visible text of an HTML page (good enough for indexing)
+std::string htmlToText(const std::string& html)
+{
+    std::string text;
+    text.reserve(html.size() / 2);
+    size_t pos = 0;
+    while (pos < html.size()) {
+        const char c = html[pos];
+        if (c == '<') {
+            for (const char* skippedElement : {"script", "style"}) {
+                if (startsWithTag(html, pos + 1, skippedElement)) {
+                    const size_t end = html.find(std::string("</") + skippedElement, pos);
+                    pos = end == std::string::npos ? html.size() : end;
+                    break;
+                }
+            }
+            pos = html.find('>', pos);
+            pos = pos == std::string::npos ? html.size() : pos + 1;
+            text += ' ';
+        } else if (c == '&') {
+            const size_t end = html.find(';', pos);
+            if (end != std::string::npos && end - pos <= 8) {
+                appendEntity(html.substr(pos + 1, end - pos - 1), &text);
+                pos = end + 1;
+            } else {
+                text += c;
+                ++pos;
+            }
+        } else {
+            const bool space = isspace(static_cast<unsigned char>(c));
+            if (!space || (!text.empty() && text.back() != ' ')) {
+                text += space ? ' ' : c;
+            }
+            ++pos;
+        }
+    }
+    return text;
+}
+
+std::string truncateUtf8(const std::string& text, size_t length)
+{
+    if (text.size() <= length)
+        return text;
+    // Don't cut a multi-byte character
+    while (length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80)
+        --length;
+    return text.substr(0, length);
+}
+
+ExtractedEntry extractEntry(const zim::Archive& archive, zim::entry_index_type index)
+{
+    ExtractedEntry extracted;
+    try {
+        const auto entry = archive.getEntryByPath(index);
+        if (entry.isRedirect())
+            return extracted;
+        const auto item = entry.getItem();
+        if (item.getMimetype().rfind("text/html", 0) != 0)
+            return extracted;
+        const auto blob = item.getData();
+        extracted.size = qint64(blob.size());
+        extracted.text = htmlToText(std::string(blob.data(), blob.size()));
+        extracted.path = item.getPath();
+        extracted.title = item.getTitle();
+        extracted.indexable = true;
+    } catch (const std::exception& e) {
+        qWarning() << "Cannot extract the text of entry" << index << ":" << e.what();
+    }
+    return extracted;
+}
+
+// Stemmers of Xapian, by the ISO 639-3 code of their language (the one used
+// by the books)
+const std::map<std::string, std::string> STEMMER_LANGUAGES = {
+    {"ara", "arabic"},
+    {"cat", "catalan"},
+    {"dan", "danish"},
+    {"deu", "german"},
+    {"ell", "greek"},
+    {"eng", "english"},
+    {"eus", "basque"},
+    {"fin", "finnish"},
+    {"fra", "french"},
+    {"gle", "irish"},
+    {"hin", "hindi"},
+    {"hun", "hungarian"},
+    {"hye", "armenian"},
+    {"ind", "indonesian"},
+    {"ita", "italian"},
+    {"lit", "lithuanian"},
+    {"nep", "nepali"},
+    {"nld", "dutch"},
+    {"nno", "norwegian"},
+    {"nob", "norwegian"},
+    {"nor", "norwegian"},
+    {"por", "portuguese"},
+    {"ron", "romanian"},
+    {"rus", "russian"},
+    {"spa", "spanish"},
+    {"srp", "serbian"},
+    {"swe", "swedish"},
+    {"tam", "tamil"},
+    {"tur", "turkish"},
+    {"yid", "yiddish"},
+};
+
+// Name of the Xapian stemmer of the (first) language of a book, empty if
+// there is none
+std::string getStemmerName(const std::string& languages)
+{
+    const auto language = QString::fromStdString(languages).split(',').first().trimmed().toLower();
+    const auto it = STEMMER_LANGUAGES.find(language.toStdString());
+    return it != STEMMER_LANGUAGES.end() ? it->second : std::string();
+}
+
+Xapian::Stem getStemmer(const std::string& name)
+{
+    if ( name.empty() )
+        return Xapian::Stem();
+    try {
+        return Xapian::Stem(name);
+    } catch (const Xapian::Error&) {
+        // Stemmers of the recent versions of Xapian only
+        return Xapian::Stem();
+    }
+}
+
+} // unnamed namespace
+
+SidecarIndexer::SidecarIndexer(Library* library, const QString& directory, QObject* parent)
+    : QObject(parent)
+    , mp_library(library)
+    , m_directory(directory)
+{
+    QDir().mkpath(m_directory);
+
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(UPDATE_DELAY_MS);
+    connect(&m_updateTimer, &QTimer::timeout, this, &SidecarIndexer::update);
+    connect(library, &Library::booksChanged, &m_updateTimer, QOverload<>::of(&QTimer::start));
+    connect(&m_indexingWatcher, &QFutureWatcher<void>::finished, this, [=]() {
+        if ( m_updatePending ) {
+            m_updatePending = false;
+            update();
+        }
+    });
+    m_updateTimer.start();
+}
+
+SidecarIndexer::~SidecarIndexer()
+{
+    m_stopping = true;
+    m_indexingWatcher.waitForFinished();
+}
+
+QString SidecarIndexer::getIndexPath(const QString& bookId) const
+{
+    return QDir(m_directory).filePath(bookId);
+}
+
+bool SidecarIndexer::hasIndex(const QString& bookId) const
+{
+    QMutexLocker locker(&m_indexedBooksMutex);
+    return m_indexedBooks.contains(bookId);
+}
+
+void SidecarIndexer::update()
+{
+    if ( m_indexingWatcher.isRunning() ) {
+        m_updatePending = true;
+        return;
+    }
+
+    QSet<QString> libraryBookIds;
+    QList<Book> booksToIndex;
+    {
+        QMutexLocker locker(&m_indexedBooksMutex);
+        for ( const auto& bookId : mp_library->getBookIds() ) {
+            libraryBookIds.insert(bookId);
+            const auto& book = mp_library->getBookById(bookId);
+            if ( !book.getDownloadId().empty() || !book.isPathValid()
+              || m_indexedBooks.contains(bookId) || m_booksWithEmbeddedIndex.contains(bookId) )
+                continue;
+
+            const auto languages = QString::fromStdString(book.getCommaSeparatedLanguages());
+            booksToIndex.append({bookId, QString::fromStdString(book.getPath()),
+                                 languages.split(',').first()});
+        }
+        m_indexedBooks.intersect(libraryBookIds);
+    }
+
+    for ( const auto& fileInfo : QDir(m_directory).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot) ) {
+        if ( !libraryBookIds.contains(fileInfo.fileName()) ) {
+            QDir(fileInfo.absoluteFilePath()).removeRecursively();
+        }
+    }
+
+    if ( !booksToIndex.isEmpty() ) {
+        m_indexingWatcher.setFuture(QtConcurrent::run([=]() {
+            indexBooks(booksToIndex);
+        }));
+    }
+}
+
+void SidecarIndexer::indexBooks(const QList<Book>& books)
+{
+    // Indexing must not slow down the rest of the application
+    QThread* const thread = QThread::currentThread();
+    const auto priority = thread->priority();
+    thread->setPriority(QThread::LowestPriority);
+
+    for ( const auto& book : books ) {
+        if ( m_stopping )
+            break;
+
+        try {
+            if ( indexBook(book) ) {
+                QMutexLocker locker(&m_indexedBooksMutex);
+                m_indexedBooks.insert(book.id);
+            }
+        } catch ( const Xapian::Error& e ) {
+            qWarning() << "Cannot index" << book.path << ":" << QString::fromStdString(e.get_description());
+        } catch ( const std::exception& e ) {
+            qWarning() << "Cannot index" << book.path << ":" << e.what();
+        }
+    }
+
+    thread->setPriority(priority);
+}
+
+bool SidecarIndexer::indexBook(const Book& book)
+{
+    const QString indexPath = getIndexPath(book.id);
+    const bool started = QDir(indexPath).exists();
+    if ( started && Xapian::Database(indexPath.toStdString()).get_metadata(COMPLETE_KEY) == "1" )
+        return true;
+
+    const zim::Archive archive(book.path.toStdString());
+    if ( !started && archive.hasFulltextIndex() ) {
+        QMutexLocker locker(&m_indexedBooksMutex);
+        m_booksWithEmbeddedIndex.insert(book.id);
+        return false;
+    }
+
+    Xapian::WritableDatabase db(indexPath.toStdString(), Xapian::DB_CREATE_OR_OPEN);
+    const auto entryCount = archive.getEntryCount();
+    auto nextEntry = zim::entry_index_type(std::stoul("0" + db.get_metadata(NEXT_ENTRY_KEY)));
+    if ( nextEntry == 0 ) {
+        qInfo() << "Building the fulltext index of" << book.path;
+    } else {
+        qInfo() << "Resuming the fulltext index of" << book.path << "at entry" << nextEntry << "of" << entryCount;
+    }
+
+    // A resumed index keeps the stemmer it was started with, its terms and
+    // the ones of the queries must match
+    const std::string language = book.language.toStdString();
+    const std::string stemmerName = nextEntry == 0 ? getStemmerName(language) : db.get_metadata(STEMMER_KEY);
+    db.set_metadata(LANGUAGE_KEY, language);
+    db.set_metadata(STEMMER_KEY, stemmerName);
+    Xapian::TermGenerator generator;
+    generator.set_stemmer(getStemmer(stemmerName));
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 bytesRead = 0;
+    zim::entry_index_type lastCommit = nextEntry;
+    while ( nextEntry < entryCount ) {
+        if ( m_stopping )
+            break;
+
+        std::vector<zim::entry_index_type> batch;
+        for ( auto i = nextEntry; i < entryCount && batch.size() < BATCH_SIZE; ++i ) {
+            batch.push_back(i);
+        }
+        const auto extractedEntries = QtConcurrent::blockingMapped<QList<ExtractedEntry>>(
+            batch, [&archive](zim::entry_index_type index) {
+                return extractEntry(archive, index);
+            });
+
+        for ( const auto& extracted : extractedEntries ) {
+            bytesRead += extracted.size;
+            if ( !extracted.indexable )
+                continue;
+
+            Xapian::Document document;
+            document.set_data(extracted.path);
+            document.add_value(TITLE_VALUE, extracted.title);
+            document.add_value(EXCERPT_VALUE, truncateUtf8(extracted.text, EXCERPT_LENGTH));
+            generator.set_document(document);
+            generator.index_text(extracted.title, 5);
+            generator.increase_termpos();
+            generator.index_text(extracted.text);
+            db.add_document(document);
+        }
+        nextEntry += zim::entry_index_type(batch.size());
+
+        if ( nextEntry - lastCommit >= COMMIT_INTERVAL ) {
+            db.set_metadata(NEXT_ENTRY_KEY, std::to_string(nextEntry));
+            db.commit();
+            lastCommit = nextEntry;
+        }
+
+        // Throttle the reading of the archive
+        const qint64 expectedTime = bytesRead * 1000 / MAX_READ_RATE;
+        while ( timer.elapsed() < expectedTime && !m_stopping ) {
+            QThread::msleep(std::min<qint64>(100, expectedTime - timer.elapsed()));
+        }
+    }
+
+    db.set_metadata(NEXT_ENTRY_KEY, std::to_string(nextEntry));
+    const bool complete = nextEntry >= entryCount;
+    if ( complete ) {
+        db.set_metadata(COMPLETE_KEY, "1");
+        qInfo() << "Built the fulltext index of" << book.path << "in" << timer.elapsed() << "ms";
+    }
+    db.commit();
+    return complete;
+}
+
+SidecarIndexer::SearchResults SidecarIndexer::search(const QString& bookId, const QString& pattern,
+                                                     int start, int pageLength) const
+{
+    if ( !hasIndex(bookId) )
+        throw std::out_of_range("No fulltext index for book " + bookId.toStdString());
+
+    const Xapian::Database db(getIndexPath(bookId).toStdString());
+    const Xapian::Stem stemmer = getStemmer(db.get_metadata(STEMMER_KEY));
+    Xapian::QueryParser parser;
+    parser.set_database(db);
+    parser.set_stemmer(stemmer);
+    parser.set_stemming_strategy(Xapian::QueryParser::STEM_SOME);
+    Xapian::Enquire enquire(db);
+    enquire.set_query(parser.parse_query(pattern.toStdString()));
+    const Xapian::MSet mset = enquire.get_mset(Xapian::doccount(start), Xapian::doccount(pageLength));
+
+    SearchResults results;
+    results.estimatedMatches = int(mset.get_matches_estimated());
+    for ( auto it = mset.begin(); it != mset.end(); ++it ) {
+        const Xapian::Document document = it.get_document();
+        const std::string snippet = mset.snippet(document.get_value(EXCERPT_VALUE), 300, stemmer);
+        results.results.append({QString::fromStdString(document.get_data()),
+                                QString::fromStdString(document.get_value(TITLE_VALUE)),
+                                QString::fromStdString(snippet)});
+    }
+    return results;
+}
@@ -0,0 +1,89 @@
+#ifndef SIDECARINDEXER_H
+#define SIDECARINDEXER_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+
+#include <atomic>
+
+class Library;
+
+// Builds fulltext (Xapian) indexes of the local books which don't embed one,
+// so that they can be searched too.
+//
+// Indexes are stored in the fulltext-index directory of the data directory
+// (one Xapian database per book). They are built in the background, one book
+// at a time: the HTML entries of the book are read in batches, their text is
+// extracted in parallel and then added to the database. The reading rate is
+// capped so that indexing doesn't hog the disk, and the database is committed
+// together with the position reached every now and then, so that indexing
+// resumes from there after a restart. Only complete indexes are searched.
+class SidecarIndexer : public QObject
+{
+    Q_OBJECT
+
+public: // types
+    struct SearchResult
+    {
+        QString path;
+        QString title;
+        QString snippet; // HTML
+    };
+
+    struct SearchResults
+    {
+        int estimatedMatches = 0;
+        QList<SearchResult> results;
+    };
+
+public: // functions
+    SidecarIndexer(Library* library, const QString& directory, QObject* parent = nullptr);
+    ~SidecarIndexer();
+
+    // Thread-safe
+    bool hasIndex(const QString& bookId) const;
+
+    // Throws (std::exception or Xapian::Error) if the index cannot be searched
+    SearchResults search(const QString& bookId, const QString& pattern,
+                         int start, int pageLength) const;
+
+public slots:
+    // Brings the indexes in line with the library (done shortly after the
+    // library changes)
+    void update();
+
+private: // types
+    struct Book
+    {
+        QString id;
+        QString path;
+        QString language;
+    };
+
+private: // functions
+    QString getIndexPath(const QString& bookId) const;
+    void indexBooks(const QList<Book>& books);
+
+    // Returns true once the index of the book is complete
+    bool indexBook(const Book& book);
+
+private: // data
+    Library* const mp_library;
+    const QString  m_directory;
+
+    mutable QMutex m_indexedBooksMutex;
+    QSet<QString>  m_indexedBooks;
+    QSet<QString>  m_booksWithEmbeddedIndex;
+
+    QTimer                m_updateTimer;
+    QFutureWatcher<void>  m_indexingWatcher;
+    bool                  m_updatePending = false;
+    std::atomic<bool>     m_stopping{false};
+};
+
+#endif // SIDECARINDEXER_H
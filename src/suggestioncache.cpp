@@ -0,0 +1,138 @@
+#include "suggestioncache.h"
+
+#include <QDebug>
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <algorithm>
+
+namespace
+{
+
+// Number of queries whose suggestions are cached (for all archives)
+const int MAX_CACHED_QUERIES = 64;
+
+// Period (in queries) of reporting the cache statistics
+const int STATS_REPORTING_PERIOD = 100;
+
+// Case folded text without accents, as in the title indexes of libzim
+QString normalize(const QString& text)
+{
+    QString result;
+    const QString decomposed = text.toCaseFolded().normalized(QString::NormalizationForm_D);
+    result.reserve(decomposed.size());
+    for ( const QChar c : decomposed ) {
+        if ( c.category() != QChar::Mark_NonSpacing ) {
+            result.append(c);
+        }
+    }
+    return result.normalized(QString::NormalizationForm_C);
+}
+
+// Queries giving the same results share a key
+QString cacheKey(const QString& zimId, SuggestionCache::Backend backend, const QString& query)
+{
+    const bool titleIndex = backend == SuggestionCache::Backend::TITLE_INDEX;
+    return zimId + "/" + (titleIndex ? normalize(query) : query);
+}
+
+QStringList splitIntoWords(const QString& text)
+{
+    static const QRegularExpression separators("[^\\w]+", QRegularExpression::UseUnicodePropertiesOption);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    return normalize(text).split(separators, Qt::SkipEmptyParts);
+#else
+    return normalize(text).split(separators, QString::SkipEmptyParts);
+#endif
+}
+
+class QueryMatcher
+{
+public:
+    explicit QueryMatcher(const QString& query)
+        : m_words(splitIntoWords(query))
+        , m_lastWordIsPartial(!query.isEmpty() && !query.back().isSpace())
+    {}
+
+    bool matches(const QString& title) const
+    {
+        const QStringList titleWords = splitIntoWords(title);
+        for ( int i = 0; i < m_words.size(); ++i ) {
+            const bool partial = m_lastWordIsPartial && i == m_words.size() - 1;
+            const auto& w = m_words[i];
+            const bool found = std::any_of(titleWords.begin(), titleWords.end(),
+                [&](const QString& tw) { return partial ? tw.startsWith(w) : tw == w; });
+            if ( !found )
+                return false;
+        }
+        return true;
+    }
+
+private:
+    const QStringList m_words;
+    const bool m_lastWordIsPartial;
+};
+
+} // unnamed namespace
+
+SuggestionCache::SuggestionCache()
+    : m_cache(MAX_CACHED_QUERIES)
+{
+}
+
+bool SuggestionCache::lookup(const QString& zimId, Backend backend, const QString& query, Suggestions* result)
+{
+    if ( const auto cached = m_cache.object(cacheKey(zimId, backend, query)) ) {
+        *result = *cached;
+        return true;
+    }
+
+    // The results of findByTitle() are only reused for the same query
+    if ( backend != Backend::TITLE_INDEX )
+        return false;
+
+    // The longest cached query refined by this one
+    for ( int n = query.size() - 1; n > 0; --n ) {
+        const auto cached = m_cache.object(cacheKey(zimId, backend, query.left(n)));
+        if ( !cached )
+            continue;
+
+        const QueryMatcher matcher(query);
+        result->clear();
+        for ( const auto& s : *cached ) {
+            if ( matcher.matches(s.title) ) {
+                result->append(s);
+            }
+        }
+        insert(zimId, backend, query, *result);
+        return true;
+    }
+    return false;
+}
+
+void SuggestionCache::insert(const QString& zimId, Backend backend, const QString& query,
+                             const Suggestions& suggestions)
+{
+    m_cache.insert(cacheKey(zimId, backend, query), new Suggestions(suggestions));
+}
+
+void SuggestionCache::recordQuery(bool cacheHit, qint64 nsecs)
+{
+    ++m_nbQueries;
+    if ( cacheHit ) {
+        ++m_nbHits;
+        m_hitTime += nsecs;
+    } else {
+        m_missTime += nsecs;
+    }
+
+    if ( m_nbQueries % STATS_REPORTING_PERIOD != 0 )
+        return;
+
+    const int nbMisses = m_nbQueries - m_nbHits;
+    const double avgMissTime = nbMisses > 0 ? double(m_missTime) / nbMisses : 0;
+    const double savedTime = m_nbHits * avgMissTime - m_hitTime;
+    qInfo().nospace() << "Suggestion cache: " << m_nbHits << "/" << m_nbQueries
+                      << " hits (" << int(100.0 * m_nbHits / m_nbQueries) << "%), ~"
+                      << int(savedTime / 1e6) << "ms saved";
+}
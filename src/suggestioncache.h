@@ -0,0 +1,64 @@
+#ifndef SUGGESTIONCACHE_H
+#define SUGGESTIONCACHE_H
+
+#include <QCache>
+#include <QList>
+#include <QString>
+
+// Cache of the complete sets of title suggestions of recent queries.
+//
+// The queries are cached as libzim answers them for the book (see Backend).
+// Backspacing to a cached query is a plain hit.
+//
+// For the books having a title index, a query extending a cached query (e.g.
+// "photos" after "photo") is also answered by filtering the cached
+// suggestions, provided that those were all of the matches of the shorter
+// query. The filter mirrors how the title index is built and queried: case
+// and accents are ignored, every word of the query but the last one must be
+// a word of the title, and the last word must be a prefix of a word of the
+// title (or a whole word too, if followed by a space).
+class SuggestionCache
+{
+public: // types
+    struct Suggestion
+    {
+        QString title;
+        QString path;
+    };
+
+    typedef QList<Suggestion> Suggestions;
+
+    // How libzim computes the suggestions of a book
+    enum class Backend
+    {
+        TITLE_INDEX, // Xapian title index, case and accents insensitive words
+        TITLE_PREFIX // no title index: case sensitive prefix of the titles
+    };
+
+    // Queries having more matches than that are not cached
+    static const int MAX_RESULTS = 200;
+
+public: // functions
+    SuggestionCache();
+
+    // Returns false if the query cannot be answered from the cache
+    bool lookup(const QString& zimId, Backend backend, const QString& query, Suggestions* result);
+
+    // The suggestions must be all the matches of the query
+    void insert(const QString& zimId, Backend backend, const QString& query,
+                const Suggestions& suggestions);
+
+    // Statistics of the queries (answered from the cache or not). They are
+    // reported in the log every now and then.
+    void recordQuery(bool cacheHit, qint64 nsecs);
+
+private: // data
+    QCache<QString, Suggestions> m_cache;
+
+    int    m_nbQueries = 0;
+    int    m_nbHits = 0;
+    qint64 m_missTime = 0; // ns
+    qint64 m_hitTime = 0;  // ns
+};
+
+#endif // SUGGESTIONCACHE_H
@@ -2,58 +2,326 @@
 #include "kiwixapp.h"
 #include <zim/suggestion.h>
 
-SuggestionListWorker::SuggestionListWorker(const QString& text, int token, int start, QObject *parent)
-: QThread(parent),
-  m_text(text),
-  m_token(token),
-  m_start(start)
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QVector>
+
+#include <functional>
+
+namespace
+{
+
+// Number of archives whose suggestion searchers are kept around
+const int MAX_CACHED_SEARCHERS = 4;
+
+// Time given to the books to answer a multi-book query (they are searched in
+// parallel). The suggestions of the books answering later are left out.
+const int MULTI_ZIM_DEADLINE_MS = 150;
+
+// Enabled with QT_LOGGING_RULES="kiwix.suggestions.debug=true"
+Q_LOGGING_CATEGORY(suggestionsLog, "kiwix.suggestions", QtInfoMsg)
+
+class Task : public QRunnable
+{
+public:
+    explicit Task(const std::function<void()>& function) : m_function(function) {}
+    void run() override { m_function(); }
+
+private:
+    std::function<void()> m_function;
+};
+
+} // unnamed namespace
+
+SuggestionListWorker::SuggestionListWorker(QObject *parent)
+: QObject(parent)
 {
 }
 
-void SuggestionListWorker::run()
+SuggestionListWorker::~SuggestionListWorker()
 {
-    QList<SuggestionData> suggestionList;
+    m_threadPool.waitForDone();
+}
+
+SuggestionListWorker::SearcherPtr SuggestionListWorker::getSuggestionSearcher(const QString& zimId)
+{
+    for (int i = 0; i < m_searchers.size(); ++i) {
+        if (m_searchers[i].first == zimId) {
+            m_searchers.move(i, 0);
+            return m_searchers.first().second;
+        }
+    }
+
+    const auto archive = KiwixApp::instance()->getLibrary()->getArchive(zimId);
+    const auto searcher = std::make_shared<Searcher>();
+    searcher->searcher.reset(new zim::SuggestionSearcher(*archive));
+    m_searchers.prepend({zimId, searcher});
+    while (m_searchers.size() > MAX_CACHED_SEARCHERS) {
+        // Pool tasks still using an evicted searcher keep it alive
+        m_searchers.removeLast();
+    }
+    return searcher;
+}
+
+zim::SuggestionSearch& SuggestionListWorker::getSuggestionSearch(const QString& zimId, const QString& text)
+{
+    if (!mp_liveSearch || zimId != m_liveSearchZimId || text != m_liveSearchText) {
+        const auto searcher = getSuggestionSearcher(zimId);
+        mp_liveSearch.reset(new zim::SuggestionSearch(searcher->searcher->suggest(text.toStdString())));
+        m_liveSearchZimId = zimId;
+        m_liveSearchText = text;
+    }
+    return *mp_liveSearch;
+}
+
+namespace
+{
+
+// Throws std::out_of_range if the book is not in the library
+SuggestionCache::Backend getCacheBackend(const QString& zimId)
+{
+    const auto archive = KiwixApp::instance()->getLibrary()->getArchive(zimId);
+    return archive->hasTitleIndex() ? SuggestionCache::Backend::TITLE_INDEX
+                                    : SuggestionCache::Backend::TITLE_PREFIX;
+}
+
+SuggestionCache::Suggestions toSuggestions(const zim::SuggestionResultSet& results)
+{
+    SuggestionCache::Suggestions suggestions;
+    for (auto current : results) {
+        suggestions.append({QString::fromStdString(current.getTitle()),
+                            QString::fromStdString(current.getPath())});
+    }
+    return suggestions;
+}
+
+QUrl getSuggestionUrl(const QString& zimId, const QString& path)
+{
+    QUrl url;
+    url.setScheme("zim");
+    url.setHost(zimId + ".zim");
+    url.setPath(QString("/") + path);
+    return url;
+}
+
+// Proposes the fulltext search of the book
+void appendFulltextSuggestion(QList<SuggestionData>* suggestionList, const QString& zimId, const QString& searchText)
+{
+    const auto archive = KiwixApp::instance()->getLibrary()->getArchive(zimId);
+    const auto sidecarIndexer = KiwixApp::instance()->getSidecarIndexer();
+    if (!archive->hasFulltextIndex() && !(sidecarIndexer && sidecarIndexer->hasIndex(zimId)))
+        return;
+
+    // The host is used to determine the currentZimId
+    // The content query item is used to know in which zim search (as for kiwix-serve)
+    QUrl url;
+    url.setScheme("zim");
+    url.setHost(zimId + ".search");
+    QUrlQuery query;
+    query.addQueryItem("content", zimId);
+    query.addQueryItem("pattern", searchText);
+    url.setQuery(query);
+    const auto text = searchText + " (" + gt("fulltext-search") + ")";
+    suggestionList->append({text, url});
+}
+
+// State shared between a multi-book query and its pool tasks (which may
+// outlive the query if they miss the deadline)
+struct MultiZimQuery
+{
+    QMutex mutex;
+    QSemaphore answers;
+    QVector<bool> answered;
+    QVector<bool> complete;
+    QVector<SuggestionCache::Suggestions> suggestions;
+};
+
+} // unnamed namespace
+
+SuggestionCache::Suggestions SuggestionListWorker::getSuggestions(const QString& zimId, const QString& text, int start)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const auto backend = getCacheBackend(zimId);
+    SuggestionCache::Suggestions suggestions;
+    const bool cacheHit = m_cache.lookup(zimId, backend, text, &suggestions);
+    if (cacheHit) {
+        suggestions = suggestions.mid(start, getFetchSize());
+    } else {
+        const auto searcher = getSuggestionSearcher(zimId);
+        std::lock_guard<std::mutex> lock(searcher->mutex);
+        auto& search = getSuggestionSearch(zimId, text);
+        if (start == 0 && search.getEstimatedMatches() <= SuggestionCache::MAX_RESULTS) {
+            /* Small result sets are fetched completely so that refinements
+               of the query can be answered from the cache */
+            suggestions = toSuggestions(search.getResults(0, SuggestionCache::MAX_RESULTS + 1));
+            if (suggestions.size() <= SuggestionCache::MAX_RESULTS) {
+                m_cache.insert(zimId, backend, text, suggestions);
+            }
+            suggestions = suggestions.mid(0, getFetchSize());
+        } else {
+            suggestions = toSuggestions(search.getResults(start, getFetchSize()));
+        }
+    }
+
+    if (start == 0) {
+        m_cache.recordQuery(cacheHit, timer.nsecsElapsed());
+    }
+    return suggestions;
+}
+
+QList<SuggestionData> SuggestionListWorker::getMultiZimSuggestions(const QStringList& zimIds, const QString& text, int token)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const int bookCount = zimIds.size();
+    const auto query = std::make_shared<MultiZimQuery>();
+    query->answered.fill(false, bookCount);
+    query->complete.fill(false, bookCount);
+    query->suggestions.resize(bookCount);
+
+    QVector<SuggestionCache::Backend> backends(bookCount);
+    int pendingCount = 0;
+    for (int i = 0; i < bookCount; ++i) {
+        SearcherPtr searcher;
+        try {
+            backends[i] = getCacheBackend(zimIds[i]);
+            SuggestionCache::Suggestions cached;
+            if (m_cache.lookup(zimIds[i], backends[i], text, &cached)) {
+                query->answered[i] = true;
+                query->suggestions[i] = cached;
+                continue;
+            }
+            searcher = getSuggestionSearcher(zimIds[i]);
+        } catch (std::out_of_range& e) {
+            continue;
+        }
+
+        ++pendingCount;
+        const std::string pattern = text.toStdString();
+        m_threadPool.start(new Task([=]() {
+            // Superseded by a newer query while waiting in the pool (the
+            // book is left out, without waiting for the deadline)
+            if (token != m_currentToken) {
+                query->answers.release();
+                return;
+            }
+
+            SuggestionCache::Suggestions suggestions;
+            bool complete = false;
+            {
+                std::lock_guard<std::mutex> lock(searcher->mutex);
+                auto search = searcher->searcher->suggest(pattern);
+                if (search.getEstimatedMatches() <= SuggestionCache::MAX_RESULTS) {
+                    suggestions = toSuggestions(search.getResults(0, SuggestionCache::MAX_RESULTS + 1));
+                    complete = suggestions.size() <= SuggestionCache::MAX_RESULTS;
+                } else {
+                    suggestions = toSuggestions(search.getResults(0, getFetchSize()));
+                }
+            }
+            QMutexLocker locker(&query->mutex);
+            query->answered[i] = true;
+            query->complete[i] = complete;
+            query->suggestions[i] = suggestions;
+            query->answers.release();
+        }));
+    }
+
+    for (int answerCount = 0; answerCount < pendingCount; ++answerCount) {
+        const int timeLeft = MULTI_ZIM_DEADLINE_MS - int(timer.elapsed());
+        if (timeLeft <= 0 || !query->answers.tryAcquire(1, timeLeft))
+            break;
+    }
+
+    QMutexLocker locker(&query->mutex);
+    QVector<SuggestionCache::Suggestions> bookSuggestions(bookCount);
+    for (int i = 0; i < bookCount; ++i) {
+        if (!query->answered[i]) {
+            qCDebug(suggestionsLog) << "Suggestions of" << zimIds[i] << "for" << text << "left out (too slow)";
+            continue;
+        }
+        if (query->complete[i]) {
+            m_cache.insert(zimIds[i], backends[i], text, query->suggestions[i]);
+        }
+        bookSuggestions[i] = query->suggestions[i];
+    }
+    locker.unlock();
 
-    WebView *current = KiwixApp::instance()->getTabWidget()->currentWebView();
-    if(!current)
+    /* libzim doesn't expose relevance scores, so the ranked lists of the
+       books are interleaved (the current book first in every round), after
+       the titles matching the query exactly */
+    QList<SuggestionData> exactMatches;
+    QList<SuggestionData> otherMatches;
+    const QString foldedText = text.trimmed().toCaseFolded();
+    for (int rank = 0; exactMatches.size() + otherMatches.size() < getFetchSize(); ++rank) {
+        bool anyLeft = false;
+        for (int i = 0; i < bookCount; ++i) {
+            if (rank >= bookSuggestions[i].size())
+                continue;
+            anyLeft = true;
+            const auto& suggestion = bookSuggestions[i][rank];
+            const SuggestionData data{suggestion.title, getSuggestionUrl(zimIds[i], suggestion.path)};
+            if (suggestion.title.toCaseFolded() == foldedText) {
+                exactMatches.append(data);
+            } else {
+                otherMatches.append(data);
+            }
+        }
+        if (!anyLeft)
+            break;
+    }
+    return (exactMatches + otherMatches).mid(0, getFetchSize());
+}
+
+void SuggestionListWorker::fetchSuggestions(const QStringList& zimIds, const QString& searchText, int token, int start)
+{
+    // Superseded by a newer query while waiting in the queue
+    if (token != m_currentToken || zimIds.isEmpty())
         return;
-    auto qurl = current->url();
-    auto currentZimId = qurl.host().split(".")[0];
+
+    const QString zimId = zimIds.first();
+    QList<SuggestionData> suggestionList;
     try {
-        auto archive = KiwixApp::instance()->getLibrary()->getArchive(currentZimId);
-        QUrl url;
-        url.setScheme("zim");
-        url.setHost(currentZimId + ".zim");
-        auto prefix = m_text.toStdString();
-        auto suggestionSearcher = zim::SuggestionSearcher(*archive);
-        auto suggestionSearch = suggestionSearcher.suggest(prefix);
-        const auto suggestions = suggestionSearch.getResults(m_start, getFetchSize());
-        for (auto current : suggestions) {
-            QString path = QString("/") + QString::fromStdString(current.getPath());
-            url.setPath(path);
-            const auto text = QString::fromStdString(current.getTitle());
-            suggestionList.append({text, url});
-        }
-
-        // Propose fulltext search
-        url.setPath("");
-        if (archive->hasFulltextIndex()) {
-            // The host is used to determine the currentZimId
-            // The content query item is used to know in which zim search (as for kiwix-serve)
-            url.setHost(currentZimId + ".search");
-            QUrlQuery query;
-            query.addQueryItem("content", currentZimId);
-            query.addQueryItem("pattern", m_text);
-            url.setQuery(query);
-            const auto text = m_text + " (" + gt("fulltext-search") + ")";
-            suggestionList.append({text, url});
+        if (zimIds.size() == 1) {
+            for (const auto& current : getSuggestions(zimId, searchText, start)) {
+                suggestionList.append({current.title, getSuggestionUrl(zimId, current.path)});
+            }
+        } else if (start == 0) {
+            // The suggestions of several books are only given in one batch
+            suggestionList = getMultiZimSuggestions(zimIds, searchText, token);
         }
+        appendFulltextSuggestion(&suggestionList, zimId, searchText);
     } catch (std::out_of_range& e) {
         // Impossible to find the requested archive (bug ?)
-        // We could propose a suggestion to do multi-zim search with:
-        // url.setHost("library.search");
-        // but we don't have a correct UI to select on which zim search, how to display results, ...
-        // So do nothing for now
+        // Fulltext search across several books would need a UI to select
+        // the books and display the results, so do nothing for now
+    }
+    emit(searchFinished(suggestionList, token));
+}
+
+void SuggestionListWorker::fetchLibrarySuggestions(const QString& zimId, const QString& searchText, int token, int start)
+{
+    if (token != m_currentToken)
+        return;
+
+    QList<SuggestionData> suggestionList;
+    if (const auto titleIndex = KiwixApp::instance()->getTitleIndex()) {
+        const auto matches = titleIndex->lookup(searchText, start + getFetchSize(), zimId);
+        for (const auto& match : matches.mid(start)) {
+            suggestionList.append({match.title, getSuggestionUrl(match.bookId, match.path)});
+        }
+    }
+    try {
+        appendFulltextSuggestion(&suggestionList, zimId, searchText);
+    } catch (std::out_of_range& e) {
+        // Not a book of the library
     }
-    emit(searchFinished(suggestionList, m_token));
+    emit(searchFinished(suggestionList, token));
 }
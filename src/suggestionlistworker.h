@@ -1,26 +1,89 @@
 #ifndef SUGGESTIONLISTWORKER_H
 #define SUGGESTIONLISTWORKER_H
 
-#include <QThread>
+#include <QObject>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "suggestioncache.h"
+
+namespace zim
+{
+class SuggestionSearcher;
+class SuggestionSearch;
+}
 
 struct SuggestionData;
 
-class SuggestionListWorker : public QThread
+// Long-lived service computing title suggestions. It is meant to live in a
+// dedicated thread (all its slots are invoked via queued calls) and keeps the
+// suggestion searchers of the recently used archives, as well as the last
+// suggestion search (so that fetching more results of the same query doesn't
+// start from scratch).
+//
+// When several books are queried, their title indexes are searched in
+// parallel (in a thread pool) and the results of the books that didn't
+// answer in time are left out.
+class SuggestionListWorker : public QObject
 {
     Q_OBJECT
 public:
     static int getFetchSize() { return 15; };
 
-    SuggestionListWorker(const QString& text, int token, int start, QObject *parent = nullptr);
-    void run() override;
+    explicit SuggestionListWorker(QObject *parent = nullptr);
+    ~SuggestionListWorker();
+
+    // Thread-safe. Queued requests with an older token are dropped without
+    // being executed.
+    void setCurrentToken(int token) { m_currentToken = token; }
+
+public slots:
+    // The first of the books is the one of the current tab (the only one
+    // for which the fulltext search is proposed)
+    void fetchSuggestions(const QStringList& zimIds, const QString& searchText, int token, int start);
+
+    // Suggestions from the title index of all the local books
+    void fetchLibrarySuggestions(const QString& zimId, const QString& searchText, int token, int start);
 
 signals:
     void searchFinished(const QList<SuggestionData>& suggestionList, int token);
 
-private:
-    QString m_text;
-    int m_token = 0;
-    int m_start;
+private: // types
+    // zim::SuggestionSearcher must not be used from several threads at once
+    struct Searcher
+    {
+        std::mutex mutex;
+        std::unique_ptr<zim::SuggestionSearcher> searcher;
+    };
+
+    typedef std::shared_ptr<Searcher> SearcherPtr;
+
+private: // functions
+    SearcherPtr getSuggestionSearcher(const QString& zimId);
+    zim::SuggestionSearch& getSuggestionSearch(const QString& zimId, const QString& text);
+    SuggestionCache::Suggestions getSuggestions(const QString& zimId, const QString& text, int start);
+    // The pool tasks of a query superseded by a newer token are dropped
+    QList<SuggestionData> getMultiZimSuggestions(const QStringList& zimIds, const QString& text, int token);
+
+private: // data
+    std::atomic<int> m_currentToken{0};
+
+    // Most recently used first
+    QList<QPair<QString, SearcherPtr>> m_searchers;
+
+    QString m_liveSearchZimId;
+    QString m_liveSearchText;
+    std::unique_ptr<zim::SuggestionSearch> mp_liveSearch;
+
+    SuggestionCache m_cache;
+    QThreadPool m_threadPool;
 };
 
 #endif // SUGGESTIONLISTWORKER_H
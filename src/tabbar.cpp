@@ -5,6 +5,7 @@ class QMenu;
 #include "kiwixapp.h"
 #include <QAction>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QWebEnginePage>
 #include <QToolButton>
 #include <QToolTip>
@@ -152,7 +153,7 @@ void TabBar::setCloseTabButton(int index)
 
     QToolButton *tb = new QToolButton(this);
     tb->setObjectName("closeTabButton");
-    QAction *a = new QAction(QIcon(":/icons/close.svg"), gt("close-tab"), tb);
+    QAction *a = new QAction(QIcon(":/icons/close.svg"), gt(TranslationKey::CloseTab), tb);
     a->setToolTip(getAction(KiwixApp::CloseCurrentTabAction)->toolTip());
     tb->setDefaultAction(a);
     setTabButton(index, QTabBar::RightSide, tb);
@@ -168,7 +169,13 @@ void TabBar::setCloseTabButton(int index)
 
 ZimView* TabBar::createNewTab(bool setCurrent, bool nextToCurrentTab)
 {
-    auto tab = new ZimView(this, this);
+    QElapsedTimer timer;
+    timer.start();
+    WebView* const webView = m_webViewPool.take();
+    auto tab = new ZimView(this, this, webView);
+    if (setCurrent) {
+        tab->getWebView()->measureTimeToFirstPaint(timer, webView ? "(pre-created view)" : "(new view)");
+    }
     const int index = nextToCurrentTab ? currentIndex() + 1 : realTabCount();
     mp_stackedWidget->insertWidget(index, tab);
     insertTab(index, "");
@@ -179,6 +186,7 @@ ZimView* TabBar::createNewTab(bool setCurrent, bool nextToCurrentTab)
 
     connect(tab, &ZimView::webActionEnabledChanged,
             this, &TabBar::onWebviewHistoryActionChanged);
+    m_tabHibernator.addView(tab);
 
     KiwixApp::instance()->saveListOfOpenTabs();
     return tab;
@@ -224,6 +232,8 @@ void TabBar::setTitleOf(const QString& title, ZimView* tab)
 void TabBar::setIconOf(const QIcon &icon, ZimView *tab)
 {
     CURRENTIFNULL(tab);
+    if (tab && tab->isDiscarded())
+        return;
     setTabIcon(mp_stackedWidget->indexOf(tab), icon);
 }
 
@@ -280,7 +290,7 @@ void TabBar::closeTabsByZimId(const QString &id)
     // should this comment indeed become outdated ;)
     for (int i = 0 ; i < realTabCount() ; ++i ) {
         auto *zv = qobject_cast<ZimView*>(mp_stackedWidget->widget(i));
-        if (zv && zv->getWebView()->zimId() == id) {
+        if (zv && zv->getZimId() == id) {
             closeTab(i);
         }
     }
@@ -291,19 +301,31 @@ QStringList TabBar::getTabUrls() const {
     for (int index = 0; index <= mp_stackedWidget->count(); index++)
     {
         if (ZimView* zv = qobject_cast<ZimView*>(mp_stackedWidget->widget(index)))
-            idList.push_back(zv->getWebView()->url().url());
+            idList.push_back(zv->getUrl().url());
         else if (qobject_cast<SettingsView*>(mp_stackedWidget->widget(index)))
             idList.push_back("SettingsTab");
     }
     return idList;
 }
 
+QStringList TabBar::getTabTitles() const {
+    QStringList titleList;
+    for (int index = 0; index <= mp_stackedWidget->count(); index++)
+    {
+        if (qobject_cast<ZimView*>(mp_stackedWidget->widget(index)))
+            titleList.push_back(tabData(index).toString());
+        else if (qobject_cast<SettingsView*>(mp_stackedWidget->widget(index)))
+            titleList.push_back("");
+    }
+    return titleList;
+}
+
 QStringList TabBar::getTabZimIds() const
 { 
     QStringList idList;
     for (int index = 0; index <= mp_stackedWidget->count(); index++)
         if (ZimView* zv = qobject_cast<ZimView*>(mp_stackedWidget->widget(index)))
-            idList.push_back(zv->getWebView()->zimId());
+            idList.push_back(zv->getZimId());
     return idList;
 }
 
@@ -388,6 +410,10 @@ void TabBar::on_webview_titleChanged(const QString& title)
     if (! tab)
         return;
 
+    // A discarded tab keeps the title of its page until it is reloaded
+    if (tab->isDiscarded())
+        return;
+
     setTitleOf(title, tab);
 
     if (currentZimView() == tab)
@@ -8,6 +8,8 @@
 #include "zimview.h"
 #include "contentmanagerview.h"
 #include "fullscreenwindow.h"
+#include "tabhibernator.h"
+#include "webviewpool.h"
 #include <QMouseEvent>
 #include <QWebEngineFullScreenRequest>
 
@@ -50,6 +52,8 @@ public:
     void openFindInPageBar();
     void closeTabsByZimId(const QString &id);
     QStringList getTabUrls() const;
+    // Same order as getTabUrls()
+    QStringList getTabTitles() const;
     QStringList getTabZimIds() const;
 
     // The "+" (new tab) button is implemented as a tab (that is always placed at the end).
@@ -88,6 +92,8 @@ private:
 private:
     QStackedWidget*     mp_stackedWidget;
     QScopedPointer<FullScreenWindow> m_fullScreenWindow;
+    TabHibernator       m_tabHibernator;
+    WebViewPool         m_webViewPool;
 
 private slots:
     void onTabMoved(int from, int to);
@@ -0,0 +1,170 @@
+#include "tabhibernator.h"
+#include "kiwixapp.h"
+#include "zimview.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QSet>
+#include <QWebEnginePage>
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+const int CHECK_INTERVAL_MS = 10000;
+
+// Time given to the renderer processes to release the memory of the
+// discarded pages before it is measured
+const int RECLAIM_DELAY_MS = 5000;
+
+const qint64 MiB = 1024 * 1024;
+
+// Resident memory of a process (in bytes), or -1 if it cannot be measured
+qint64 getProcessMemory(qint64 pid)
+{
+#ifdef Q_OS_LINUX
+    QFile statm(QString("/proc/%1/statm").arg(pid));
+    if ( !statm.open(QIODevice::ReadOnly) )
+        return -1;
+    const auto fields = statm.readAll().split(' ');
+    if ( fields.size() < 2 )
+        return -1;
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    Q_UNUSED(pid);
+    return -1;
+#endif
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+// Whether the page can be put in that state without side effects, such as
+// stopping its audio or losing what was typed in its forms (the states are
+// ordered by decreasing resource usage)
+bool canEnterState(const QWebEnginePage* page, QWebEnginePage::LifecycleState state)
+{
+    return !page->recentlyAudible() && int(state) <= int(page->recommendedState());
+}
+#endif
+
+} // unnamed namespace
+
+TabHibernator::TabHibernator(QObject* parent)
+    : QObject(parent)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    m_checkTimer.setInterval(CHECK_INTERVAL_MS);
+    connect(&m_checkTimer, &QTimer::timeout, this, &TabHibernator::checkViews);
+    m_checkTimer.start();
+#endif
+}
+
+void TabHibernator::addView(ZimView* view)
+{
+    m_views.append(view);
+}
+
+qint64 TabHibernator::getMemoryUsage() const
+{
+    qint64 memory = getProcessMemory(QCoreApplication::applicationPid());
+    if ( memory < 0 )
+        return -1;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    // Pages may share a renderer process
+    QSet<qint64> rendererPids;
+    for ( const auto& view : m_views ) {
+        if ( view ) {
+            rendererPids.insert(view->getWebView()->page()->renderProcessPid());
+        }
+    }
+    rendererPids.remove(0);
+    for ( const auto pid : rendererPids ) {
+        memory += std::max(qint64(0), getProcessMemory(pid));
+    }
+#endif
+    return memory;
+}
+
+void TabHibernator::checkViews()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    m_views.removeAll(nullptr);
+
+    const auto settingsManager = KiwixApp::instance()->getSettingsManager();
+    const qint64 freezeDelay = settingsManager->getTabFreezeDelay() * qint64(1000);
+    const qint64 discardDelay = settingsManager->getTabDiscardDelay() * qint64(1000);
+    const qint64 memoryLimit = settingsManager->getTabMemoryLimit() * MiB;
+
+    QList<ZimView*> viewsToDiscard;
+    ZimView* longestHiddenView = nullptr;
+    qint64 longestHiddenTime = -1;
+    for ( const auto& view : m_views ) {
+        const qint64 hiddenTime = view->getHiddenTime();
+        QWebEnginePage* const page = view->getWebView()->page();
+        if ( hiddenTime < 0 || page->lifecycleState() == QWebEnginePage::LifecycleState::Discarded )
+            continue;
+
+        const bool canDiscard = canEnterState(page, QWebEnginePage::LifecycleState::Discarded);
+        if ( canDiscard && discardDelay > 0 && hiddenTime >= discardDelay ) {
+            viewsToDiscard.append(view);
+            continue;
+        }
+
+        if ( freezeDelay > 0 && hiddenTime >= freezeDelay
+          && page->lifecycleState() == QWebEnginePage::LifecycleState::Active
+          && canEnterState(page, QWebEnginePage::LifecycleState::Frozen) ) {
+            page->setLifecycleState(QWebEnginePage::LifecycleState::Frozen);
+        }
+
+        if ( canDiscard && hiddenTime > longestHiddenTime ) {
+            longestHiddenView = view;
+            longestHiddenTime = hiddenTime;
+        }
+    }
+
+    if ( viewsToDiscard.isEmpty() && memoryLimit > 0 && longestHiddenView ) {
+        const qint64 memoryUsage = getMemoryUsage();
+        if ( memoryUsage > memoryLimit ) {
+            qInfo() << "Memory usage" << memoryUsage / MiB << "MiB is over the limit of"
+                    << memoryLimit / MiB << "MiB, discarding a background tab";
+            viewsToDiscard.append(longestHiddenView);
+        }
+    }
+
+    if ( !viewsToDiscard.isEmpty() ) {
+        discardViews(viewsToDiscard);
+    }
+#endif
+}
+
+void TabHibernator::discardViews(const QList<ZimView*>& views)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    const qint64 memoryBefore = getMemoryUsage();
+    for ( const auto view : views ) {
+        view->getWebView()->page()->setLifecycleState(QWebEnginePage::LifecycleState::Discarded);
+    }
+
+    if ( memoryBefore < 0 )
+        return;
+
+    const int count = views.size();
+    QTimer::singleShot(RECLAIM_DELAY_MS, this, [=]() {
+        const qint64 memoryAfter = getMemoryUsage();
+        if ( memoryAfter < 0 )
+            return;
+        const qint64 reclaimed = std::max(qint64(0), memoryBefore - memoryAfter);
+        m_reclaimedMemory += reclaimed;
+        qInfo() << "Discarding" << count << "background tab(s) reclaimed" << reclaimed / MiB
+                << "MiB (" << m_reclaimedMemory / MiB << "MiB in total)";
+    });
+#else
+    Q_UNUSED(views);
+#endif
+}
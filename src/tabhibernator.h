@@ -0,0 +1,47 @@
+#ifndef TABHIBERNATOR_H
+#define TABHIBERNATOR_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+
+class ZimView;
+
+// Caps the resources used by the tabs that are not displayed.
+//
+// Background tabs are frozen (their page stops running) and then discarded
+// (their page is unloaded, keeping its URL, title and history) after the idle
+// delays of the settings. When the memory used by the application and its
+// renderer processes exceeds the configured limit, the background tab hidden
+// for the longest time is discarded too. A discarded tab is reloaded by
+// QtWebEngine as soon as it is displayed again. Pages playing audio, and
+// those for which QtWebEngine doesn't recommend it (see
+// QWebEnginePage::recommendedState()), are left alone.
+class TabHibernator : public QObject
+{
+    Q_OBJECT
+
+public: // functions
+    explicit TabHibernator(QObject* parent = nullptr);
+
+    void addView(ZimView* view);
+
+    // Total memory reclaimed so far by discarding tabs (in bytes)
+    qint64 getReclaimedMemory() const { return m_reclaimedMemory; }
+
+private: // functions
+    void checkViews();
+    void discardViews(const QList<ZimView*>& views);
+
+    // Memory used by the application and its renderer processes (in bytes),
+    // or -1 if it cannot be measured on this platform
+    qint64 getMemoryUsage() const;
+
+private: // data
+    QList<QPointer<ZimView>> m_views;
+    QTimer m_checkTimer;
+    qint64 m_reclaimedMemory = 0;
+};
+
+#endif // TABHIBERNATOR_H
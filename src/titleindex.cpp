@@ -0,0 +1,379 @@
+#include "titleindex.h"
+
+#include <zim/archive.h>
+#include <zim/entry.h>
+
+#include <QDebug>
+#include <QSaveFile>
+#include <QTemporaryFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const char MAGIC[8] = {'K', 'X', 'T', 'I', 'T', 'L', 'E', '\0'};
+const quint32 VERSION = 1;
+const qint64 HEADER_SIZE = sizeof(MAGIC) + 3 * sizeof(quint32);
+
+class Reader
+{
+public:
+    Reader(const uchar* begin, const uchar* end) : mp_pos(begin), mp_end(end) {}
+
+    bool atEnd() const { return mp_pos >= mp_end; }
+
+    bool readVarint(quint64* value)
+    {
+        *value = 0;
+        for (int shift = 0; shift < 64 && mp_pos < mp_end; shift += 7) {
+            const uchar byte = *mp_pos++;
+            *value |= quint64(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    bool readString(std::string* str)
+    {
+        quint64 length;
+        if (!readVarint(&length) || length > quint64(mp_end - mp_pos))
+            return false;
+        str->assign(reinterpret_cast<const char*>(mp_pos), length);
+        mp_pos += length;
+        return true;
+    }
+
+    // Reads the next entry of a block, key containing the key of the previous one
+    bool readEntry(std::string* key, std::string* title, std::string* path)
+    {
+        quint64 sharedLength;
+        std::string suffix;
+        if (!readVarint(&sharedLength) || sharedLength > key->size() || !readString(&suffix))
+            return false;
+        key->resize(sharedLength);
+        key->append(suffix);
+        if (!readString(title) || !readString(path))
+            return false;
+        if (title->empty()) {
+            *title = *key;
+        }
+        return true;
+    }
+
+private:
+    const uchar* mp_pos;
+    const uchar* mp_end;
+};
+
+void writeVarint(QByteArray* out, quint64 value)
+{
+    while (value >= 0x80) {
+        out->append(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out->append(char(value));
+}
+
+void writeString(QByteArray* out, const std::string& str)
+{
+    writeVarint(out, str.size());
+    out->append(str.data(), int(str.size()));
+}
+
+template<typename T>
+QByteArray toLittleEndian(T value)
+{
+    QByteArray bytes(sizeof(T), '\0');
+    qToLittleEndian(value, bytes.data());
+    return bytes;
+}
+
+std::string toKey(const QString& text)
+{
+    return text.toCaseFolded().toStdString();
+}
+
+struct Record
+{
+    std::string key;
+    std::string title; // empty if identical to the key
+    std::string path;
+};
+
+bool lessThan(const Record& a, const Record& b)
+{
+    return a.key != b.key ? a.key < b.key : a.path < b.path;
+}
+
+// Records sorted in memory at once when building an index (a few tens of MB)
+const size_t RUN_SIZE = 100000;
+
+const int RUN_WRITE_BUFFER_SIZE = 1024 * 1024;
+
+// Sorted records kept in a temporary file while the index is built, read
+// back in order through a memory mapping
+class SortedRun
+{
+public:
+    explicit SortedRun(const QString& fileTemplate) : m_file(fileTemplate) {}
+
+    // Sorts the records and moves them to the file
+    bool write(std::vector<Record>* records)
+    {
+        std::sort(records->begin(), records->end(), lessThan);
+        if (!m_file.open())
+            return false;
+
+        QByteArray data;
+        for (const Record& record : *records) {
+            writeString(&data, record.key);
+            writeString(&data, record.title);
+            writeString(&data, record.path);
+            if (data.size() >= RUN_WRITE_BUFFER_SIZE) {
+                if (m_file.write(data) != data.size())
+                    return false;
+                data.clear();
+            }
+        }
+        records->clear();
+        return m_file.write(data) == data.size() && m_file.flush();
+    }
+
+    // Maps the file and reads its first record
+    bool open()
+    {
+        const qint64 size = m_file.size();
+        const uchar* const data = m_file.map(0, size);
+        if (!data)
+            return false;
+        mp_reader.reset(new Reader(data, data + size));
+        return next();
+    }
+
+    bool atEnd() const { return m_atEnd; }
+    const Record& current() const { return m_current; }
+
+    // Returns false if the file is corrupted
+    bool next()
+    {
+        if (mp_reader->atEnd()) {
+            m_atEnd = true;
+            return true;
+        }
+        return mp_reader->readString(&m_current.key)
+            && mp_reader->readString(&m_current.title)
+            && mp_reader->readString(&m_current.path);
+    }
+
+private:
+    QTemporaryFile          m_file;
+    std::unique_ptr<Reader> mp_reader;
+    Record                  m_current;
+    bool                    m_atEnd = false;
+};
+
+} // unnamed namespace
+
+std::unique_ptr<TitleIndex> TitleIndex::open(const QString& path)
+{
+    std::unique_ptr<TitleIndex> index(new TitleIndex);
+    index->m_file.setFileName(path);
+    if (!index->m_file.open(QIODevice::ReadOnly))
+        return nullptr;
+
+    const qint64 size = index->m_file.size();
+    if (size < HEADER_SIZE)
+        return nullptr;
+
+    const uchar* const data = index->m_file.map(0, size);
+    if (!data || memcmp(data, MAGIC, sizeof(MAGIC)) != 0
+        || qFromLittleEndian<quint32>(data + sizeof(MAGIC)) != VERSION) {
+        return nullptr;
+    }
+
+    index->mp_data = data;
+    index->m_size = size;
+    index->m_entryCount = qFromLittleEndian<quint32>(data + sizeof(MAGIC) + 4);
+    index->m_blockCount = qFromLittleEndian<quint32>(data + sizeof(MAGIC) + 8);
+
+    // Check the block table once so that lookups can trust it
+    const qint64 tableEnd = HEADER_SIZE + qint64(index->m_blockCount) * 8;
+    if (tableEnd > size)
+        return nullptr;
+    qint64 previousOffset = tableEnd;
+    for (quint32 block = 0; block < index->m_blockCount; ++block) {
+        const auto offset = qint64(qFromLittleEndian<quint64>(data + HEADER_SIZE + block * 8));
+        if (offset < previousOffset || offset > size)
+            return nullptr;
+        previousOffset = offset;
+    }
+    return index;
+}
+
+TitleIndex::~TitleIndex()
+{
+    if (mp_data) {
+        m_file.unmap(const_cast<uchar*>(mp_data));
+    }
+}
+
+const uchar* TitleIndex::blockBegin(quint32 block) const
+{
+    return mp_data + qFromLittleEndian<quint64>(mp_data + HEADER_SIZE + block * 8);
+}
+
+const uchar* TitleIndex::blockEnd(quint32 block) const
+{
+    return block + 1 < m_blockCount ? blockBegin(block + 1) : mp_data + m_size;
+}
+
+QList<TitleIndex::Entry> TitleIndex::lookup(const QString& prefix, int maxResults) const
+{
+    const std::string prefixKey = toKey(prefix);
+    std::string key, title, path;
+
+    // First block starting with a key not lower than the prefix. Matching
+    // entries may also end the previous block.
+    quint32 low = 0;
+    quint32 high = m_blockCount;
+    while (low < high) {
+        const quint32 middle = low + (high - low) / 2;
+        Reader reader(blockBegin(middle), blockEnd(middle));
+        key.clear();
+        if (reader.readEntry(&key, &title, &path) && key < prefixKey) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    QList<Entry> entries;
+    for (quint32 block = low > 0 ? low - 1 : 0; block < m_blockCount; ++block) {
+        Reader reader(blockBegin(block), blockEnd(block));
+        key.clear();
+        while (!reader.atEnd()) {
+            if (!reader.readEntry(&key, &title, &path))
+                return entries; // corrupted
+            if (key < prefixKey)
+                continue;
+            if (key.compare(0, prefixKey.size(), prefixKey) != 0 || entries.size() >= maxResults)
+                return entries;
+            entries.append({QString::fromStdString(title), QString::fromStdString(path)});
+        }
+    }
+    return entries;
+}
+
+bool TitleIndex::build(const zim::Archive& archive, const QString& path,
+                       const std::atomic<bool>& cancel)
+{
+    // The titles are not in the order of their keys in the archive, so they
+    // are sorted by runs written next to the index, then merged (the memory
+    // used doesn't depend on the size of the archive)
+    std::vector<std::unique_ptr<SortedRun>> runs;
+    std::vector<Record> records;
+    records.reserve(std::min(RUN_SIZE, size_t(archive.getEntryCount())));
+    quint32 entryCount = 0;
+    const auto writeRun = [&]() {
+        runs.emplace_back(new SortedRun(path + ".run-XXXXXX"));
+        if (runs.back()->write(&records))
+            return true;
+        qWarning() << "Cannot write a temporary file of title index" << path;
+        return false;
+    };
+
+    for (const auto& entry : archive.iterByTitle()) {
+        if (cancel)
+            return false;
+        const std::string title = entry.getTitle();
+        if (title.empty())
+            continue;
+        std::string key = toKey(QString::fromStdString(title));
+        const bool sameAsKey = key == title;
+        records.push_back({std::move(key), sameAsKey ? std::string() : title, entry.getPath()});
+        ++entryCount;
+        if (records.size() == RUN_SIZE && !writeRun())
+            return false;
+    }
+    if (!records.empty() && !writeRun())
+        return false;
+    std::vector<Record>().swap(records);
+
+    const auto runGreater = [](const SortedRun* a, const SortedRun* b) {
+        return lessThan(b->current(), a->current());
+    };
+    std::priority_queue<SortedRun*, std::vector<SortedRun*>, decltype(runGreater)> queue(runGreater);
+    for (const auto& run : runs) {
+        if (!run->open()) {
+            qWarning() << "Cannot read a temporary file of title index" << path;
+            return false;
+        }
+        queue.push(run.get());
+    }
+
+    const auto blockCount = quint32((entryCount + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot write title index" << path << ":" << file.errorString();
+        return false;
+    }
+
+    QByteArray header(MAGIC, sizeof(MAGIC));
+    header += toLittleEndian<quint32>(VERSION);
+    header += toLittleEndian<quint32>(entryCount);
+    header += toLittleEndian<quint32>(blockCount);
+    file.write(header);
+    file.write(QByteArray(int(blockCount) * 8, '\0')); // block table, written last
+
+    QByteArray blockTable;
+    QByteArray block;
+    std::string previousKey;
+    qint64 offset = HEADER_SIZE + qint64(blockCount) * 8;
+    for (quint32 i = 0; !queue.empty(); ++i) {
+        if (i % BLOCK_SIZE == 0) {
+            if (cancel) {
+                file.cancelWriting();
+                return false;
+            }
+            file.write(block);
+            offset += block.size();
+            block.clear();
+            blockTable += toLittleEndian<quint64>(quint64(offset));
+            previousKey.clear();
+        }
+
+        SortedRun* const run = queue.top();
+        queue.pop();
+        const Record& record = run->current();
+        size_t shared = 0;
+        const size_t maxShared = std::min(previousKey.size(), record.key.size());
+        while (shared < maxShared && previousKey[shared] == record.key[shared])
+            ++shared;
+        writeVarint(&block, shared);
+        writeString(&block, record.key.substr(shared));
+        writeString(&block, record.title);
+        writeString(&block, record.path);
+        previousKey = record.key;
+
+        if (!run->next()) {
+            qWarning() << "Corrupted temporary file of title index" << path;
+            file.cancelWriting();
+            return false;
+        }
+        if (!run->atEnd()) {
+            queue.push(run);
+        }
+    }
+    file.write(block);
+
+    file.seek(HEADER_SIZE);
+    file.write(blockTable);
+    return file.commit();
+}
@@ -0,0 +1,72 @@
+#ifndef TITLEINDEX_H
+#define TITLEINDEX_H
+
+#include <QFile>
+#include <QList>
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace zim
+{
+class Archive;
+}
+
+// Compact, memory-mapped index of the titles of all the entries of a book.
+//
+// Entries are sorted by case folded title and stored in blocks of
+// BLOCK_SIZE front-coded entries (each key only stores what differs from the
+// previous one). The first key of every block is complete, so a lookup is a
+// binary search on the block table followed by the decoding of a few blocks.
+//
+// File layout (little endian):
+//   header:       "KXTITLE\0", u32 version, u32 entry count, u32 block count
+//   block table:  u64 offset of every block
+//   blocks:       for every entry: varint shared key length, varint key
+//                 suffix length, key suffix, varint title length (0 if the
+//                 title is the key), title, varint path length, path
+class TitleIndex
+{
+public: // types
+    struct Entry
+    {
+        QString title;
+        QString path;
+    };
+
+    static const int BLOCK_SIZE = 32;
+
+public: // functions
+    // Returns nullptr if the file is missing or not a valid index
+    static std::unique_ptr<TitleIndex> open(const QString& path);
+
+    // Writes the index of all the entries of the archive (sorting them in
+    // temporary files next to the index). Returns false if the index could
+    // not be written or cancel was set in the meantime.
+    static bool build(const zim::Archive& archive, const QString& path,
+                      const std::atomic<bool>& cancel);
+
+    ~TitleIndex();
+
+    // Entries whose case folded title starts with the case folded prefix
+    // (in title order)
+    QList<Entry> lookup(const QString& prefix, int maxResults) const;
+
+    quint32 getEntryCount() const { return m_entryCount; }
+
+private: // functions
+    TitleIndex() = default;
+    const uchar* blockBegin(quint32 block) const;
+    const uchar* blockEnd(quint32 block) const;
+
+private: // data
+    QFile        m_file;
+    const uchar* mp_data = nullptr;
+    qint64       m_size = 0;
+    quint32      m_entryCount = 0;
+    quint32      m_blockCount = 0;
+};
+
+#endif // TITLEINDEX_H
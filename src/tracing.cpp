@@ -0,0 +1,148 @@
+#include "tracing.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+
+#include <vector>
+
+namespace
+{
+
+const char TRACE_FILE_ENV_VAR[] = "KIWIX_TRACE_FILE";
+
+// The events after that many (about 3 MiB) are dropped, so that tracing a
+// long session doesn't use ever more memory. The startup and the first
+// navigations easily fit.
+const size_t MAX_EVENT_COUNT = 100000;
+
+struct Event
+{
+    const char* name;
+    qint64      start;
+    qint64      duration;
+    int         threadId;
+};
+
+QElapsedTimer g_clock;
+QString g_fileName;
+QMutex g_mutex;
+std::vector<Event> g_events;
+qint64 g_droppedEventCount = 0;
+int g_threadCount = 0;
+int g_mainThreadId = 0;
+
+// Small numbers are easier to read in the trace viewers than the ids of the
+// system. Only called with g_mutex locked.
+int getThreadId()
+{
+    thread_local int threadId = -1;
+    if ( threadId < 0 ) {
+        threadId = ++g_threadCount;
+    }
+    return threadId;
+}
+
+} // unnamed namespace
+
+std::atomic<bool> Tracing::s_enabled{false};
+
+void Tracing::initialize(int argc, char* argv[])
+{
+    // Parsed here as the constructor of the application is traced too
+    const QByteArray option = QByteArray("--") + getCommandLineOption();
+    const QByteArray optionWithValue = option + "=";
+    for ( int i = 1; i < argc; ++i ) {
+        const QByteArray argument(argv[i]);
+        if ( argument == option && i + 1 < argc ) {
+            start(QString::fromLocal8Bit(argv[i + 1]));
+            return;
+        }
+        if ( argument.startsWith(optionWithValue) ) {
+            start(QString::fromLocal8Bit(argument.mid(optionWithValue.size())));
+            return;
+        }
+    }
+
+    const QString fileName = qEnvironmentVariable(TRACE_FILE_ENV_VAR);
+    if ( !fileName.isEmpty() ) {
+        start(fileName);
+    }
+}
+
+void Tracing::start(const QString& fileName)
+{
+    QMutexLocker locker(&g_mutex);
+    g_fileName = fileName;
+    g_events.clear();
+    g_droppedEventCount = 0;
+    g_clock.start();
+    g_mainThreadId = getThreadId();
+    s_enabled = true;
+}
+
+qint64 Tracing::now()
+{
+    return g_clock.nsecsElapsed() / 1000;
+}
+
+void Tracing::addEvent(const char* name, qint64 start, qint64 duration)
+{
+    QMutexLocker locker(&g_mutex);
+    if ( !isEnabled() )
+        return;
+
+    if ( g_events.size() < MAX_EVENT_COUNT ) {
+        g_events.push_back(Event{name, start, duration, getThreadId()});
+    } else {
+        g_droppedEventCount++;
+    }
+}
+
+void Tracing::stop()
+{
+    if ( !isEnabled() )
+        return;
+
+    QMutexLocker locker(&g_mutex);
+    s_enabled = false;
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    for ( const auto& event : g_events ) {
+        events.append(QJsonObject{
+            {"name", event.name},
+            {"cat", "kiwix"},
+            {"ph", "X"},
+            {"ts", event.start},
+            {"dur", event.duration},
+            {"pid", pid},
+            {"tid", event.threadId}
+        });
+    }
+    events.append(QJsonObject{
+        {"name", "thread_name"},
+        {"ph", "M"},
+        {"pid", pid},
+        {"tid", g_mainThreadId},
+        {"args", QJsonObject{{"name", "main"}}}
+    });
+    g_events.clear();
+    if ( g_droppedEventCount > 0 ) {
+        qWarning() << "The trace is truncated," << g_droppedEventCount
+                   << "events were dropped after the first" << MAX_EVENT_COUNT;
+    }
+
+    QSaveFile file(g_fileName);
+    const QJsonObject trace{{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+    if ( !file.open(QIODevice::WriteOnly)
+      || file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact)) < 0
+      || !file.commit() ) {
+        qWarning() << "Cannot write the trace to" << g_fileName;
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QString>
+
+#include <atomic>
+
+// Timing of the phases of the application in the Trace Event Format of
+// Chrome, to be opened in chrome://tracing or https://ui.perfetto.dev.
+//
+// Tracing is enabled by the --trace-file <path> option or by the
+// KIWIX_TRACE_FILE environment variable, and the trace is written when the
+// application exits. Only the first events are kept (see MAX_EVENT_COUNT),
+// so the trace of a long session is truncated. When it is disabled, a traced
+// scope costs the test of a flag.
+//
+//     void Library::save()
+//     {
+//         KIWIX_TRACE_SCOPE("Library::save");
+//         ...
+//     }
+class Tracing
+{
+public: // types
+    // Records the time between its construction and end() (or its
+    // destruction). `name` must outlive the trace (a string literal).
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name)
+            : m_name(name),
+              m_start(isEnabled() ? now() : -1)
+        {}
+        ~Scope() { end(); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        void end()
+        {
+            if ( m_start >= 0 ) {
+                addEvent(m_name, m_start, now() - m_start);
+                m_start = -1;
+            }
+        }
+
+    private:
+        const char* m_name;
+        qint64      m_start;
+    };
+
+public: // functions
+    // Starts tracing if it's requested on the command line or in the
+    // environment. Must be called before the QApplication is created.
+    static void initialize(int argc, char* argv[]);
+    // Must be called from the main thread
+    static void start(const QString& fileName);
+    // Writes the trace and stops tracing
+    static void stop();
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    static const char* getCommandLineOption() { return "trace-file"; }
+
+private: // functions
+    // Microseconds since the start of tracing
+    static qint64 now();
+    static void addEvent(const char* name, qint64 start, qint64 duration);
+
+private: // data
+    static std::atomic<bool> s_enabled;
+};
+
+#define KIWIX_TRACE_CONCAT_(a, b) a##b
+#define KIWIX_TRACE_CONCAT(a, b) KIWIX_TRACE_CONCAT_(a, b)
+#define KIWIX_TRACE_SCOPE(name) \
+    Tracing::Scope KIWIX_TRACE_CONCAT(kiwixTraceScope, __LINE__)(name)
+
+#endif // TRACING_H
@@ -1,52 +1,134 @@
 #include "translation.h"
 #include <QFile>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include <QResource>
+#include <QtEndian>
 #include <QDebug>
 #include <stdexcept>
 
+namespace
+{
+
+// Layout of the tables (see resources/generate_translation_tables.py), in
+// 32 bits words:
+//   keys.tr:   magic, version, key count N, bucket count B, seeds[B],
+//              slots[N], offsets[N], lengths[N], UTF-16 keys
+//   <lang>.tr: magic, version, key count N, offsets[N], lengths[N],
+//              UTF-16 texts
+const char KEYS_MAGIC[] = "KXTK";
+const char TEXTS_MAGIC[] = "KXTT";
+const quint32 TABLE_VERSION = 1;
+const int KEYS_HEADER_SIZE = 4;
+const int TEXTS_HEADER_SIZE = 3;
+
+// Must be the same as key_hash() in generate_translation_tables.py
+quint32 keyHash(const QString &key, quint32 seed)
+{
+    quint32 h = 0x811C9DC5 ^ seed;
+    for (const QChar c : key) {
+        h ^= c.unicode();
+        h *= 0x01000193;
+    }
+    h ^= h >> 16;
+    h *= 0x85EBCA6B;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35;
+    h ^= h >> 16;
+    return h;
+}
+
+// The data of the resource itself when it can be used in place, a copy
+// otherwise
+QByteArray loadTable(const QString &path)
+{
+    QResource resource(path);
+    if (!resource.isValid())
+        return QByteArray();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    const bool compressed = resource.compressionAlgorithm() != QResource::NoCompression;
+#else
+    const bool compressed = resource.isCompressed();
+#endif
+    const bool aligned = reinterpret_cast<quintptr>(resource.data()) % alignof(quint32) == 0;
+    if (!compressed && aligned) {
+        return QByteArray::fromRawData(reinterpret_cast<const char*>(resource.data()), resource.size());
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.readAll();
+}
+
+bool isValidTable(const QByteArray &table, const char *magic, int headerSize)
+{
+    return table.size() >= headerSize * 4
+        && table.startsWith(magic)
+        && qFromLittleEndian<quint32>(table.constData() + 4) == TABLE_VERSION;
+}
+
+} // unnamed namespace
+
 Translation::Translation()
 {
 }
 
 void Translation::setTranslation(QLocale locale)
 {
-    auto defaultText = JsonFileToQMap(":/i18n/en.json");
-    if (defaultText.isEmpty()) {
+    m_keys = loadTable(":/translations/keys.tr");
+    if (!isValidTable(m_keys, KEYS_MAGIC, KEYS_HEADER_SIZE)) {
         throw std::runtime_error("Invalid translation file");
     }
-    if (locale.bcp47Name() == "en") {
-        m_translations = defaultText;
-        return;
+    m_keyCount = readValue(m_keys, 2);
+    m_bucketCount = readValue(m_keys, 3);
+
+    // The texts missing in a language are taken from English at build time
+    m_texts = loadTable(":/translations/" + locale.bcp47Name() + ".tr");
+    if (!isValidTable(m_texts, TEXTS_MAGIC, TEXTS_HEADER_SIZE)) {
+        m_texts = loadTable(":/translations/en.tr");
     }
-    m_translations = JsonFileToQMap(":/i18n/" + locale.bcp47Name() + ".json");
-    for (auto &key : defaultText.keys()) {
-        if (!m_translations.contains(key) || m_translations.value(key).isEmpty()) {
-            m_translations.insert(key, defaultText.value(key));
-        }
+    if (!isValidTable(m_texts, TEXTS_MAGIC, TEXTS_HEADER_SIZE)
+     || int(readValue(m_texts, 2)) != m_keyCount
+     || m_keyCount != int(TranslationKey::Count)) {
+        throw std::runtime_error("Invalid translation file");
     }
 }
 
-QMap<QString, QString> Translation::JsonFileToQMap(const QString &filePath)
+quint32 Translation::readValue(const QByteArray &table, int index) const
 {
-    QMap<QString, QString> translations;
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        return translations;
-    }
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    file.close();
-    if (doc.isNull()) {
-        return translations;
-    }
-    auto jsonObj = doc.object();
-    for (auto &key : jsonObj.keys()) {
-        translations.insert(key, jsonObj.value(key).toString());
-    }
-    return translations;
+    return qFromLittleEndian<quint32>(table.constData() + 4 * index);
+}
+
+QString Translation::readString(const QByteArray &table, int offsetsIndex, int index) const
+{
+    const int poolIndex = offsetsIndex + 2 * m_keyCount;
+    const quint32 offset = readValue(table, offsetsIndex + index);
+    const quint32 length = readValue(table, offsetsIndex + m_keyCount + index);
+    const char *data = table.constData() + 4 * poolIndex + 2 * offset;
+    return QString::fromRawData(reinterpret_cast<const QChar*>(data), length);
+}
+
+int Translation::findKey(const QString &key) const
+{
+    if (m_keyCount == 0)
+        return -1;
+    const quint32 bucket = keyHash(key, 0) % m_bucketCount;
+    const quint32 seed = readValue(m_keys, KEYS_HEADER_SIZE + bucket);
+    const quint32 slot = keyHash(key, seed) % m_keyCount;
+    const int index = readValue(m_keys, KEYS_HEADER_SIZE + m_bucketCount + slot);
+    // Any string hashes to some slot
+    const int offsetsIndex = KEYS_HEADER_SIZE + m_bucketCount + m_keyCount;
+    return readString(m_keys, offsetsIndex, index) == key ? index : -1;
+}
+
+QString Translation::getText(const QString &key) const
+{
+    const int index = findKey(key);
+    return index < 0 ? key : readString(m_texts, TEXTS_HEADER_SIZE, index);
 }
 
-QString Translation::getText(const QString &key)
+QString Translation::getText(TranslationKey key) const
 {
-    return (m_translations.contains(key)) ? m_translations.value(key) : key;
+    if (m_keyCount == 0)
+        return QString();
+    return readString(m_texts, TEXTS_HEADER_SIZE, int(key));
 }
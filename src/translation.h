@@ -1,23 +1,40 @@
 #ifndef TRANSLATION_H
 #define TRANSLATION_H
 
+#include "translationkeys.h"
+
+#include <QByteArray>
 #include <QString>
-#include <QMap>
 #include <QLocale>
 
+// Texts of the user interface, in the language of the locale.
+//
+// The JSON translations are compiled at build time (see
+// resources/generate_translation_tables.py) into tables embedded in the
+// resources and used in place: loading a language doesn't parse anything,
+// getText() finds a key with a perfect hash, and getText(TranslationKey)
+// indexes the table directly. The returned strings point into the tables,
+// they are not copied.
 class Translation
 {
 public:
     Translation();
 
     void setTranslation(QLocale locale);
-    QString getText(const QString &key);
+    QString getText(const QString &key) const;
+    QString getText(TranslationKey key) const;
 
 private:
-    QMap<QString, QString> JsonFileToQMap(const QString &filePath);
+    // Index of the key in the tables, -1 if it doesn't exist
+    int findKey(const QString &key) const;
+    quint32 readValue(const QByteArray &table, int index) const;
+    QString readString(const QByteArray &table, int offsetsIndex, int index) const;
 
 private:
-    QMap<QString, QString> m_translations;
+    QByteArray m_keys;
+    QByteArray m_texts;
+    int m_keyCount = 0;
+    int m_bucketCount = 0;
 };
 
 #endif // TRANSLATION_H
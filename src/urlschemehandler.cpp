@@ -1,10 +1,12 @@
 #include "urlschemehandler.h"
 #include "kiwixapp.h"
+#include "tracing.h"
 #include "blobbuffer.h"
 #include <QDebug>
 #include <QWebEngineUrlRequestJob>
 #include <QTextStream>
 #include <iostream>
+#include <algorithm>
 
 #include <kiwix/search_renderer.h>
 #include <kiwix/name_mapper.h>
@@ -37,10 +39,13 @@ zim::Entry getArchiveEntryFromUrl(const zim::Archive& archive, const QUrl& url)
 void
 UrlSchemeHandler::handleContentRequest(QWebEngineUrlRequestJob *request)
 {
+    KIWIX_TRACE_SCOPE("UrlSchemeHandler::handleContentRequest");
     auto qurl = request->requestUrl();
     auto library = KiwixApp::instance()->getLibrary();
     auto zim_id = qurl.host();
     zim_id.resize(zim_id.length()-4);
+    const auto navigationMetrics = KiwixApp::instance()->getNavigationMetrics();
+    navigationMetrics->requestStarted(zim_id, qurl);
     std::shared_ptr<zim::Archive> archive;
     try {
       archive = library->getArchive(zim_id);
@@ -48,21 +53,36 @@ UrlSchemeHandler::handleContentRequest(QWebEngineUrlRequestJob *request)
       replyZimNotFoundPage(request, zim_id);
       return;
     }
+
+    const auto contentCache = KiwixApp::instance()->getContentCache();
+    ContentCache::Entry cachedEntry;
+    if (contentCache->get(zim_id, qurl.path(), &cachedEntry)) {
+        replyData(request, cachedEntry.mimeType, cachedEntry.data);
+        navigationMetrics->requestServed(zim_id, qurl, cachedEntry.data.size());
+        return;
+    }
+
     try {
         auto entry = getArchiveEntryFromUrl(*archive, qurl);
         auto item = entry.getItem(true);
         if (entry.isRedirect()) {
             auto path = QString("/") + QString::fromStdString(item.getPath());
             qurl.setPath(path);
+            navigationMetrics->requestRedirected(request->requestUrl(), qurl);
             request->redirect(qurl);
             return;
         }
 
-        BlobBuffer* buffer = new BlobBuffer(item.getData(0));
         auto mimeType = QByteArray::fromStdString(item.getMimetype());
         mimeType = mimeType.split(';')[0];
+        BlobBuffer* buffer = new BlobBuffer(item.getData(0));
+        if (contentCache->isCacheable(qint64(item.getSize()))) {
+            // The entry shares the data of the buffer (no copy)
+            contentCache->put(zim_id, qurl.path(), {mimeType, buffer->data()});
+        }
         connect(request, &QObject::destroyed, buffer, &QObject::deleteLater);
         request->reply(mimeType, buffer);
+        navigationMetrics->requestServed(zim_id, qurl, qint64(item.getSize()));
     } catch (zim::EntryNotFound&) {
       request->fail(QWebEngineUrlRequestJob::UrlNotFound);
     } catch (const zim::ZimFileFormatError&) {
@@ -70,6 +90,16 @@ UrlSchemeHandler::handleContentRequest(QWebEngineUrlRequestJob *request)
     }
 }
 
+void
+UrlSchemeHandler::replyData(QWebEngineUrlRequestJob *request, const QByteArray &mimeType,
+                            const QByteArray &data)
+{
+    QBuffer* buffer = new QBuffer;
+    buffer->setData(data);
+    connect(request, &QObject::destroyed, buffer, &QObject::deleteLater);
+    request->reply(mimeType, buffer);
+}
+
 void
 UrlSchemeHandler::handleMetaRequest(QWebEngineUrlRequestJob* request)
 {
@@ -103,25 +133,6 @@ class IdNameMapper : public kiwix::NameMapper {
 };
 
 
-namespace
-{
-
-struct SearchResultsWithEstimatedMatchCount
-{
-    std::shared_ptr<zim::SearchResultSet> results;
-    int estimatedMatchCount = 0;
-};
-
-SearchResultsWithEstimatedMatchCount getSearchResults(zim::Search& s, int start, int pageLength)
-{
-    SearchResultsWithEstimatedMatchCount r;
-    r.estimatedMatchCount = s.getEstimatedMatches();
-    r.results = std::make_shared<zim::SearchResultSet>(s.getResults(start, pageLength));
-    return r;
-}
-
-} // unnamed namespace
-
 void
 UrlSchemeHandler::handleSearchRequest(QWebEngineUrlRequestJob* request)
 {
@@ -145,27 +156,27 @@ UrlSchemeHandler::handleSearchRequest(QWebEngineUrlRequestJob* request)
     if (ok)
       pageLength = temp;
 
-    std::shared_ptr<zim::Search> search;
+    Library::SearchResults searchResults;
     try {
-        auto searcher = app->getLibrary()->getSearcher(bookId);
-        search = std::make_shared<zim::Search>(searcher->search(searchQuery));
-    } catch(...) {
+        searchResults = app->getLibrary()->search(bookId, searchQuery, start, pageLength);
+    } catch (const std::out_of_range&) {
         request->fail(QWebEngineUrlRequestJob::UrlInvalid);
         return;
-    }
-
-    SearchResultsWithEstimatedMatchCount searchResult;
-    try {
-        searchResult = getSearchResults(*search, start, pageLength);
     } catch (...) {
         request->fail(QWebEngineUrlRequestJob::RequestFailed);
         return;
     }
 
+    if (!searchResults.results) {
+        replySidecarSearchResults(request, bookId, QString::fromStdString(searchQuery),
+                                  start, pageLength, searchResults);
+        return;
+    }
+
     kiwix::SearchRenderer renderer(
-        *searchResult.results,
+        *searchResults.results,
         start,
-        searchResult.estimatedMatchCount);
+        searchResults.estimatedMatchCount);
     renderer.setSearchPattern(searchQuery);
     renderer.setSearchBookQuery("content="+bookId.toStdString());
     renderer.setProtocolPrefix("zim://");
@@ -276,3 +287,61 @@ UrlSchemeHandler::requestStarted(QWebEngineUrlRequestJob *request)
         request->fail(QWebEngineUrlRequestJob::UrlNotFound);
     }
 }
+
+void
+UrlSchemeHandler::replySidecarSearchResults(QWebEngineUrlRequestJob *request,
+                                            const QString &zimId,
+                                            const QString &pattern,
+                                            int start, int pageLength,
+                                            const Library::SearchResults &searchResults)
+{
+    // kiwix::SearchRenderer only takes a zim::SearchResultSet, which libzim
+    // only builds from the index embedded in a book
+    const auto pageUrl = [=](int pageStart) {
+        QUrl url = request->requestUrl();
+        QUrlQuery query;
+        query.addQueryItem("content", zimId);
+        query.addQueryItem("pattern", pattern);
+        query.addQueryItem("start", QString::number(pageStart));
+        query.addQueryItem("pageLength", QString::number(pageLength));
+        url.setQuery(query);
+        return url.toString(QUrl::FullyEncoded).toHtmlEscaped();
+    };
+
+    const QString escapedPattern = pattern.toHtmlEscaped();
+    const int end = start + searchResults.sidecarResults.size();
+    QString contentHtml = "<section><div>"
+                          "<h1>" + gt("kiwix-search") + "</h1>";
+    if (searchResults.sidecarResults.isEmpty()) {
+        contentHtml += "<p>" + gt("search-no-results").replace("{{PATTERN}}", escapedPattern) + "</p>";
+    } else {
+        contentHtml += "<p>" + gt("search-results-range")
+                                   .replace("{{START}}", QString::number(start + 1))
+                                   .replace("{{END}}", QString::number(end))
+                                   .replace("{{COUNT}}", QString::number(searchResults.estimatedMatchCount))
+                                   .replace("{{PATTERN}}", escapedPattern) + "</p>";
+    }
+
+    contentHtml += "<ul>";
+    for (const auto& result : searchResults.sidecarResults) {
+        QUrl url;
+        url.setScheme("zim");
+        url.setHost(zimId + ".zim");
+        url.setPath(QString("/") + result.path);
+        contentHtml += "<li><a href=\"" + url.toString(QUrl::FullyEncoded).toHtmlEscaped() + "\">"
+                     + result.title.toHtmlEscaped() + "</a>"
+                       "<p>" + result.snippet + "</p></li>";
+    }
+    contentHtml += "</ul><p>";
+
+    if (start > 0) {
+        contentHtml += "<a href=\"" + pageUrl(std::max(0, start - pageLength)) + "\">"
+                     + gt("search-previous-page") + "</a> ";
+    }
+    if (end < searchResults.estimatedMatchCount) {
+        contentHtml += "<a href=\"" + pageUrl(end) + "\">" + gt("search-next-page") + "</a>";
+    }
+    contentHtml += "</p></div></section>";
+
+    sendHtmlResponse(request, contentHtml);
+}
@@ -1,6 +1,8 @@
 #ifndef URLSCHEMEHANDLER_H
 #define URLSCHEMEHANDLER_H
 
+#include "library.h"
+
 #include <QWebEngineUrlSchemeHandler>
 
 class UrlSchemeHandler : public QWebEngineUrlSchemeHandler
@@ -14,8 +16,12 @@ private:
     void handleContentRequest(QWebEngineUrlRequestJob *request);
     void handleSearchRequest(QWebEngineUrlRequestJob *request);
 
+    void replyData(QWebEngineUrlRequestJob *request, const QByteArray& mimeType, const QByteArray& data);
     void replyZimNotFoundPage(QWebEngineUrlRequestJob *request, const QString& zimId);
     void replyBadZimFilePage(QWebEngineUrlRequestJob *request, const QString& zimId);
+    void replySidecarSearchResults(QWebEngineUrlRequestJob *request, const QString& zimId,
+                                   const QString& pattern, int start, int pageLength,
+                                   const Library::SearchResults& searchResults);
 };
 
 #endif // URLSCHEMEHANDLER_H
@@ -4,6 +4,7 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include "kiwixapp.h"
+#include "webviewpool.h"
 #include <QWebEngineProfile>
 
 WebPage::WebPage(QObject *parent) :
@@ -16,6 +17,10 @@ WebPage::WebPage(QObject *parent) :
 
 bool WebPage::acceptNavigationRequest(const QUrl &url, QWebEnginePage::NavigationType /*type*/, bool /*isMainFrame*/)
 {
+    // The blank page is loaded by pre-created views (see WebViewPool)
+    if (WebViewPool::isBlankUrl(url))
+        return true;
+
     if (url.scheme() != "zim") {
         QDesktopServices::openUrl(url);
         return false;
@@ -8,6 +8,8 @@ class QMenu;
 #include "kiwixapp.h"
 #include "webpage.h"
 #include <QToolTip>
+#include <QDebug>
+#include <QLoggingCategory>
 #include <QWebEngineSettings>
 #include <QWebEngineHistory>
 #include <QVBoxLayout>
@@ -18,6 +20,14 @@ class QMenu;
 
 zim::Entry getArchiveEntryFromUrl(const zim::Archive& archive, const QUrl& url);
 
+namespace
+{
+
+// Enabled with QT_LOGGING_RULES="kiwix.tabs.debug=true"
+Q_LOGGING_CATEGORY(tabsLog, "kiwix.tabs", QtInfoMsg)
+
+} // unnamed namespace
+
 void WebViewBackMenu::showEvent(QShowEvent *)
 {
     /* In Qt 5.12 CSS options for shifting this menu didn't work.
@@ -80,6 +90,14 @@ WebView::WebView(QWidget *parent)
         m_linkHovered = url;
     });
 
+    const auto navigationMetrics = KiwixApp::instance()->getNavigationMetrics();
+    connect(this, &QWebEngineView::loadStarted, navigationMetrics, [=]() {
+        navigationMetrics->navigationStarted(this);
+    });
+    connect(this, &QWebEngineView::loadFinished, navigationMetrics, [=](bool ok) {
+        navigationMetrics->navigationFinished(this, ok);
+    });
+
     /* In Qt 5.12, the zoom factor is not correctly passed after a fulltext search
      * Bug Report: https://bugreports.qt.io/browse/QTBUG-51851
      * This rezooms the page to its correct zoom (default/by ZIM ID) after loading is finished.
@@ -96,7 +114,9 @@ WebView::WebView(QWidget *parent)
 }
 
 WebView::~WebView()
-{}
+{
+    KiwixApp::instance()->getNavigationMetrics()->navigationAborted(this);
+}
 
 bool WebView::isWebActionEnabled(QWebEnginePage::WebAction webAction) const
 {
@@ -288,9 +308,21 @@ QMenu* WebView::createLinkContextMenu() {
 }
 
 
+void WebView::measureTimeToFirstPaint(const QElapsedTimer& timer, const QString& context)
+{
+    m_firstPaintTimer = timer;
+    m_firstPaintContext = context;
+}
+
 bool WebView::eventFilter(QObject *src, QEvent *e)
 {
     Q_UNUSED(src)
+    // The page is painted by a child widget
+    if (e->type() == QEvent::Paint && m_firstPaintTimer.isValid()) {
+        qCDebug(tabsLog) << "New tab" << m_firstPaintContext << "painted after"
+                 << m_firstPaintTimer.elapsed() << "ms";
+        m_firstPaintTimer.invalidate();
+    }
     // work around QTBUG-43602
     if (e->type() == QEvent::Wheel) {
         auto we = static_cast<QWheelEvent *>(e);
@@ -5,6 +5,7 @@
 #include <QWebEngineView>
 #include <QIcon>
 #include <QWheelEvent>
+#include <QElapsedTimer>
 
 #include "findinpagebar.h"
 
@@ -47,6 +48,9 @@ public:
 
     void saveViewContent();
 
+    // Logs the time elapsed on the timer when the view is next painted
+    void measureTimeToFirstPaint(const QElapsedTimer& timer, const QString& context);
+
 public slots:
     void onUrlChanged(const QUrl& url);
 
@@ -64,6 +68,8 @@ protected:
     QString m_currentZimId;
     QIcon m_icon;
     QString m_linkHovered;
+    QElapsedTimer m_firstPaintTimer;
+    QString m_firstPaintContext;
 
 private slots:
     void gotoTriggeredHistoryItemAction();
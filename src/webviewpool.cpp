@@ -0,0 +1,69 @@
+#include "webviewpool.h"
+#include "webview.h"
+
+#include <QWebEngineHistory>
+
+#include <memory>
+
+namespace
+{
+
+const int POOL_SIZE = 2;
+
+// Views are created one at a time, once the application has been idle for
+// that long
+const int REFILL_DELAY_MS = 2000;
+
+const char BLANK_URL[] = "about:blank";
+
+} // unnamed namespace
+
+WebViewPool::WebViewPool(QObject* parent)
+    : QObject(parent)
+{
+    m_refillTimer.setSingleShot(true);
+    m_refillTimer.setInterval(REFILL_DELAY_MS);
+    connect(&m_refillTimer, &QTimer::timeout, this, &WebViewPool::refill);
+    m_refillTimer.start();
+}
+
+WebViewPool::~WebViewPool()
+{
+    qDeleteAll(m_views);
+}
+
+bool WebViewPool::isBlankUrl(const QUrl& url)
+{
+    return url == QUrl(BLANK_URL);
+}
+
+WebView* WebViewPool::take()
+{
+    m_refillTimer.start();
+    if (m_views.isEmpty())
+        return nullptr;
+
+    WebView* const view = m_views.takeFirst();
+    // The blank page must not be reachable with the back button. Clearing the
+    // history keeps the current entry, so it's done once the first actual
+    // page has been loaded.
+    const auto connection = std::make_shared<QMetaObject::Connection>();
+    *connection = connect(view, &QWebEngineView::loadFinished, view, [=]() {
+        if (isBlankUrl(view->url()))
+            return;
+        view->history()->clear();
+        disconnect(*connection);
+    });
+    return view;
+}
+
+void WebViewPool::refill()
+{
+    if (m_views.size() >= POOL_SIZE)
+        return;
+
+    const auto view = new WebView();
+    view->setUrl(QUrl(BLANK_URL));
+    m_views.append(view);
+    m_refillTimer.start();
+}
@@ -0,0 +1,36 @@
+#ifndef WEBVIEWPOOL_H
+#define WEBVIEWPOOL_H
+
+#include <QObject>
+#include <QList>
+#include <QTimer>
+#include <QUrl>
+
+class WebView;
+
+// A few hidden web views created in advance, so that new tabs don't have to
+// wait for a page and its renderer process to be set up. The views have
+// loaded a blank page (which starts their renderer process) and the pool is
+// refilled when the application is idle.
+class WebViewPool : public QObject
+{
+    Q_OBJECT
+
+public: // functions
+    explicit WebViewPool(QObject* parent = nullptr);
+    ~WebViewPool();
+
+    // Returns nullptr if the pool is empty. The caller owns the view.
+    WebView* take();
+
+    static bool isBlankUrl(const QUrl& url);
+
+private: // functions
+    void refill();
+
+private: // data
+    QList<WebView*> m_views;
+    QTimer m_refillTimer;
+};
+
+#endif // WEBVIEWPOOL_H
@@ -1,15 +1,18 @@
 #include "zimview.h"
 #include "kiwixapp.h"
+#include "webviewpool.h"
 #include <QAction>
 #include <QVBoxLayout>
 #include <QToolTip>
 
-ZimView::ZimView(TabBar *tabBar, QWidget *parent)
+QString getZimIdFromUrl(QUrl url);
+
+ZimView::ZimView(TabBar *tabBar, QWidget *parent, WebView *webView)
     : QWidget(parent),
+      mp_webView(webView ? webView : new WebView()),
       mp_tabBar(tabBar),
       mp_findInPageBar(new FindInPageBar(this))
 {
-    mp_webView = new WebView();
     QVBoxLayout *layout = new QVBoxLayout;
     layout->addWidget(mp_webView);
     layout->addWidget(mp_findInPageBar);
@@ -17,6 +20,7 @@ ZimView::ZimView(TabBar *tabBar, QWidget *parent)
     layout->setSpacing(0);
     setLayout(layout); // now 'mp_webView' has 'this' as the parent QObject
     mp_findInPageBar->hide();
+    m_hiddenTimer.start();
     auto app = KiwixApp::instance();
     connect(app->getAction(KiwixApp::ZoomInAction), &QAction::triggered,
             this, [=]() {
@@ -102,3 +106,57 @@ void ZimView::openFindInPageBar()
     mp_findInPageBar->show();
     mp_findInPageBar->getFindLineEdit()->setFocus();
 }
+
+void ZimView::setDeferredUrl(const QUrl& url, const QString& title)
+{
+    m_deferredUrl = url;
+    mp_tabBar->setTitleOf(title.isEmpty() ? url.toString() : title, this);
+    mp_tabBar->setIconOf(KiwixApp::instance()->getLibrary()->getBookIcon(getZimIdFromUrl(url)), this);
+}
+
+QUrl ZimView::getUrl() const
+{
+    if (!m_deferredUrl.isEmpty())
+        return m_deferredUrl;
+    return WebViewPool::isBlankUrl(mp_webView->url()) ? QUrl() : mp_webView->url();
+}
+
+QString ZimView::getZimId() const
+{
+    return m_deferredUrl.isEmpty() ? mp_webView->zimId() : getZimIdFromUrl(m_deferredUrl);
+}
+
+qint64 ZimView::getHiddenTime() const
+{
+    return m_hiddenTimer.isValid() ? m_hiddenTimer.elapsed() : -1;
+}
+
+bool ZimView::isDiscarded() const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    return mp_webView->page()->lifecycleState() == QWebEnginePage::LifecycleState::Discarded;
+#else
+    return false;
+#endif
+}
+
+void ZimView::showEvent(QShowEvent *event)
+{
+    m_hiddenTimer.invalidate();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    // A discarded page is reloaded from its URL
+    mp_webView->page()->setLifecycleState(QWebEnginePage::LifecycleState::Active);
+#endif
+    if (!m_deferredUrl.isEmpty()) {
+        const QUrl url = m_deferredUrl;
+        m_deferredUrl.clear();
+        mp_webView->setUrl(url);
+    }
+    QWidget::showEvent(event);
+}
+
+void ZimView::hideEvent(QHideEvent *event)
+{
+    m_hiddenTimer.start();
+    QWidget::hideEvent(event);
+}
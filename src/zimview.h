@@ -2,6 +2,8 @@
 #define ZIMVIEW_H
 
 #include <QWidget>
+#include <QElapsedTimer>
+#include <QUrl>
 #include <QWebEnginePage>
 
 class FindInPageBar;
@@ -12,19 +14,40 @@ class ZimView : public QWidget
 {
     Q_OBJECT
 public:
-    explicit ZimView(TabBar* tabBar, QWidget *parent = nullptr);
+    // A new web view is created if none is given
+    explicit ZimView(TabBar* tabBar, QWidget *parent = nullptr, WebView *webView = nullptr);
 
     WebView *getWebView() { return mp_webView; }
     FindInPageBar *getFindInPageBar() { return mp_findInPageBar; }
     void openFindInPageBar();
 
+    // Restored tabs only load their page when they are first displayed.
+    // Meanwhile the tab shows the given title and the icon of the book.
+    void setDeferredUrl(const QUrl& url, const QString& title);
+
+    // URL of the page of the tab, even if it isn't loaded yet
+    QUrl getUrl() const;
+    QString getZimId() const;
+
+    // Time (in ms) since the tab was last displayed, -1 while it is displayed
+    qint64 getHiddenTime() const;
+
+    // Whether the page was unloaded (see TabHibernator)
+    bool isDiscarded() const;
+
 signals:
     void webActionEnabledChanged(QWebEnginePage::WebAction action, bool enabled);
 
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
 private:
     WebView *mp_webView;
     TabBar *mp_tabBar;
     FindInPageBar *mp_findInPageBar;
+    QElapsedTimer m_hiddenTimer;
+    QUrl m_deferredUrl;
 };
 
 #endif // ZIMVIEW_H